@@ -80,8 +80,19 @@ bool getFile(String url, String filename) {
 
         Serial.println();
         Serial.print("[HTTP] connection closed or file end.\n");
+
+        // A truncated download must not be found as a complete file next time
+        if (len > 0) {
+          Serial.print("[HTTP] download incomplete, removing file\n");
+          f.close();
+          SPIFFS.remove(filename);
+        }
+      } else {
+        // Nothing useful was written, don't leave an empty file behind
+        f.close();
+        SPIFFS.remove(filename);
       }
-      f.close();
+      if (f) f.close();
     }
     else {
       Serial.printf("[HTTP] GET... failed, error: %s\n", http.errorToString(httpCode).c_str());
@@ -0,0 +1,306 @@
+#include "ArtCache.h"
+
+#include <stddef.h>
+
+#define ART_CACHE_MAGIC 0x43545241  // "ARTC"
+#define ART_CACHE_VERSION 2
+
+struct ArtCacheHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    uint32_t clock;
+};
+
+//========= Paths =========
+
+uint32_t ArtCache::keyFor(const char* url) {
+    // FNV-1a de 32 bits
+    uint32_t hash = 2166136261u;
+    while (*url) {
+        hash ^= (uint8_t)*url++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static const char* extensionFor(ArtCacheFormat format) {
+    return format == ART_CACHE_RGB565 ? "565" : "jpg";
+}
+
+void ArtCache::pathFor(uint32_t key, char* path, size_t size) {
+    snprintf(path, size, "%s/%08x.%s", dir, key, extensionFor(format));
+}
+
+void ArtCache::tempPath(char* path, size_t size) {
+    snprintf(path, size, "%s/tmp.%s", dir, extensionFor(format));
+}
+
+//========= Index =========
+
+void ArtCache::loadIndex() {
+    char path[32];
+    snprintf(path, sizeof(path), "%s/index.bin", dir);
+
+    count = 0;
+    clock = 0;
+    usedBytes = 0;
+
+    fs::File f = fs->open(path, "r");
+    if (!f)
+        return;
+
+    ArtCacheHeader header;
+    if (f.read((uint8_t*)&header, sizeof(header)) != sizeof(header) || header.magic != ART_CACHE_MAGIC ||
+        header.version < 1 || header.version > ART_CACHE_VERSION || header.count > ART_CACHE_MAX_ENTRIES) {
+        f.close();
+        return;
+    }
+
+    // La version 1 no tenia colores: se leen las entradas de a una y quedan en 0, asi los archivos no se pierden
+    size_t entrySize = header.version == 1 ? offsetof(ArtCacheEntry, palette) : sizeof(ArtCacheEntry);
+    uint16_t read = 0;
+    while (read < header.count && f.read((uint8_t*)&entries[read], entrySize) == entrySize) {
+        if (header.version == 1)
+            entries[read].palette = 0;
+        read++;
+    }
+    if (read == header.count) {
+        count = header.count;
+        clock = header.clock;
+    }
+    f.close();
+}
+
+void ArtCache::saveIndex() {
+    char path[32];
+    snprintf(path, sizeof(path), "%s/index.bin", dir);
+
+    fs::File f = fs->open(path, "w");
+    if (!f) {
+        Serial.println("No se pudo guardar el indice de la cache de tapas");
+        return;
+    }
+
+    ArtCacheHeader header = {ART_CACHE_MAGIC, ART_CACHE_VERSION, count, clock};
+    f.write((const uint8_t*)&header, sizeof(header));
+    f.write((const uint8_t*)entries, count * sizeof(ArtCacheEntry));
+    f.close();
+    dirty = false;
+    savedAt = millis();
+}
+
+int ArtCache::find(uint32_t key) {
+    for (int i = 0; i < count; i++) {
+        if (entries[i].key == key)
+            return i;
+    }
+    return -1;
+}
+
+void ArtCache::remove(int index) {
+    char path[32];
+    pathFor(entries[index].key, path, sizeof(path));
+    fs->remove(path);
+
+    usedBytes -= entries[index].size;
+    entries[index] = entries[count - 1];
+    count--;
+}
+
+// Libera lugar para size bytes. La entrada mas reciente (la tapa en pantalla) no se toca
+void ArtCache::evictFor(uint32_t size) {
+    while (count > 0 && (usedBytes + size > budget || count >= ART_CACHE_MAX_ENTRIES)) {
+        int oldest = -1;
+        int newest = 0;
+        for (int i = 0; i < count; i++) {
+            if (entries[i].lastUsed > entries[newest].lastUsed)
+                newest = i;
+        }
+        for (int i = 0; i < count; i++) {
+            if (i != newest && (oldest < 0 || entries[i].lastUsed < entries[oldest].lastUsed))
+                oldest = i;
+        }
+        if (oldest < 0)
+            break;
+        remove(oldest);
+        evictionCount++;
+    }
+}
+
+//========= Validation =========
+
+bool ArtCache::validate(const char* path, uint32_t expectedSize) {
+    fs::File f = fs->open(path, "r");
+    if (!f)
+        return false;
+
+    size_t size = f.size();
+    bool ok = expectedSize == 0 || size == expectedSize;
+
+    if (ok && format == ART_CACHE_JPEG) {
+        // Un JPEG completo empieza con SOI (FFD8) y termina con EOI (FFD9)
+        uint8_t marker[2];
+        ok = size >= 4 && f.read(marker, 2) == 2 && marker[0] == 0xFF && marker[1] == 0xD8;
+        if (ok && f.seek(size - 2))
+            ok = f.read(marker, 2) == 2 && marker[0] == 0xFF && marker[1] == 0xD9;
+    } else if (ok) {
+        // El marcador final solo se escribe si la decodificacion termino
+        ArtPixelsMarker head;
+        ArtPixelsMarker tail;
+        ok = size >= 2 * sizeof(ArtPixelsMarker) && f.read((uint8_t*)&head, sizeof(head)) == sizeof(head) &&
+             head.magic == ART_PIXELS_MAGIC;
+        if (ok && f.seek(size - sizeof(tail)))
+            ok = f.read((uint8_t*)&tail, sizeof(tail)) == sizeof(tail) && tail.magic == ART_PIXELS_MAGIC && tail.size == size;
+    }
+    f.close();
+    return ok;
+}
+
+//========= Public =========
+
+void ArtCache::begin() {
+    loadIndex();
+
+    // Las entradas que no coinciden con lo que hay en flash se descartan
+    bool changed = false;
+    for (int i = count - 1; i >= 0; i--) {
+        char path[32];
+        pathFor(entries[i].key, path, sizeof(path));
+        fs::File f = fs->open(path, "r");
+        bool ok = f && f.size() == entries[i].size;
+        if (f)
+            f.close();
+        if (ok) {
+            usedBytes += entries[i].size;
+        } else {
+            fs->remove(path);
+            entries[i] = entries[count - 1];
+            count--;
+            changed = true;
+        }
+    }
+
+    discard();
+    if (changed)
+        saveIndex();
+
+    Serial.printf("Cache %s: %u archivos, %u de %u bytes\n", dir, count, usedBytes, budget);
+}
+
+bool ArtCache::lookup(uint32_t key, char* path, size_t size) {
+    int index = find(key);
+    if (index < 0) {
+        missCount++;
+        return false;
+    }
+
+    hitCount++;
+    entries[index].lastUsed = ++clock;
+    dirty = true;
+    pathFor(key, path, size);
+    return true;
+}
+
+void ArtCache::flush(uint32_t now) {
+    if (dirty && now - savedAt >= INDEX_FLUSH_MS)
+        saveIndex();
+}
+
+bool ArtCache::contains(uint32_t key) {
+    return find(key) >= 0;
+}
+
+bool ArtCache::commit(uint32_t key, int32_t expectedSize) {
+    char temp[32];
+    tempPath(temp, sizeof(temp));
+
+    if (!validate(temp, expectedSize > 0 ? expectedSize : 0)) {
+        Serial.printf("Tapa incompleta, no se guarda en cache %s\n", dir);
+        fs->remove(temp);
+        return false;
+    }
+
+    fs::File f = fs->open(temp, "r");
+    uint32_t size = f.size();
+    f.close();
+
+    int index = find(key);
+    if (index >= 0)
+        remove(index);
+
+    evictFor(size);
+
+    char path[32];
+    pathFor(key, path, sizeof(path));
+    fs->remove(path);
+    if (!fs->rename(temp, path)) {
+        fs->remove(temp);
+        saveIndex();
+        return false;
+    }
+
+    entries[count].key = key;
+    entries[count].size = size;
+    entries[count].lastUsed = ++clock;
+    entries[count].palette = 0;
+    count++;
+    usedBytes += size;
+    saveIndex();
+    return true;
+}
+
+void ArtCache::setPalette(uint32_t key, uint32_t palette) {
+    int index = find(key);
+    if (index < 0 || entries[index].palette == palette)
+        return;
+    entries[index].palette = palette;
+    saveIndex();
+}
+
+uint32_t ArtCache::palette(uint32_t key) {
+    int index = find(key);
+    return index >= 0 ? entries[index].palette : 0;
+}
+
+void ArtCache::discard() {
+    char temp[32];
+    tempPath(temp, sizeof(temp));
+    if (fs->exists(temp))
+        fs->remove(temp);
+}
+
+//========= Stats =========
+
+uint32_t ArtCache::hits() const {
+    return hitCount;
+}
+
+uint32_t ArtCache::misses() const {
+    return missCount;
+}
+
+uint32_t ArtCache::evictions() const {
+    return evictionCount;
+}
+
+void ArtCache::printStats() {
+    Serial.printf("[cache %s] aciertos: %u, fallos: %u, desalojos: %u, %u archivos, %u/%u bytes\n",
+                  dir, hitCount, missCount, evictionCount, count, usedBytes, budget);
+}
+
+ArtCache::ArtCache(fs::FS& fs, const char* dir, uint32_t budgetBytes, ArtCacheFormat format) {
+    this->fs = &fs;
+    strlcpy(this->dir, dir, sizeof(this->dir));
+    this->format = format;
+    budget = budgetBytes;
+
+    count = 0;
+    clock = 0;
+    usedBytes = 0;
+    hitCount = 0;
+    missCount = 0;
+    evictionCount = 0;
+    dirty = false;
+    savedAt = 0;
+}
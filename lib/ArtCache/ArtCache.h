@@ -0,0 +1,107 @@
+#ifndef ARTCACHE_H
+#define ARTCACHE_H
+
+#include <Arduino.h>
+#include <FS.h>
+
+#define ART_CACHE_MAX_ENTRIES 48
+
+enum ArtCacheFormat : uint8_t {
+    ART_CACHE_JPEG,    // JPEG tal como lo sirve spotify
+    ART_CACHE_RGB565   // Tapa ya decodificada, escalada y con los bytes invertidos, lista para pushImage
+};
+
+// Formato de los archivos RGB565: ArtPixelsMarker, bloques {ArtPixelsBlock, pixeles} y un ArtPixelsMarker final
+// con el largo total del archivo. Se escribe solo agregando al final; sin el marcador final el archivo no es valido.
+#define ART_PIXELS_MAGIC 0x52353635  // "565R"
+
+struct ArtPixelsMarker {
+    uint32_t magic;
+    uint32_t size;  // En el marcador final: bytes totales del archivo
+};
+
+struct ArtPixelsBlock {
+    int16_t x;  // Relativo a la esquina de la tapa
+    int16_t y;
+    uint16_t w;
+    uint16_t h;
+};
+
+struct ArtCacheEntry {
+    uint32_t key;       // Hash de la URL de la imagen
+    uint32_t size;      // Bytes del archivo validado
+    uint32_t lastUsed;  // Reloj logico para el LRU
+    uint32_t palette;   // Colores sacados de la tapa al decodificarla (ArtPalette::pack), 0 si todavia no
+};
+
+// Cache de tapas en SPIFFS con indice compacto y desalojo LRU por presupuesto de bytes.
+// Un archivo solo entra al indice despues de validarlo, asi una descarga cortada nunca cuenta como acierto.
+class ArtCache {
+
+  private:
+    fs::FS* fs;
+    char dir[12];
+    ArtCacheFormat format;
+    uint32_t budget;
+
+    ArtCacheEntry entries[ART_CACHE_MAX_ENTRIES];
+    uint8_t count;
+    uint32_t clock;
+    uint32_t usedBytes;
+
+    // Los aciertos solo mueven el LRU en RAM; el indice se reescribe con commit/desalojo/colores o en flush()
+    bool dirty;
+    uint32_t savedAt;
+
+    uint32_t hitCount;
+    uint32_t missCount;
+    uint32_t evictionCount;
+
+    int find(uint32_t key);
+    void remove(int index);
+    void evictFor(uint32_t size);
+    bool validate(const char* path, uint32_t expectedSize);
+    void loadIndex();
+    void saveIndex();
+
+  public:
+    static const uint32_t INDEX_FLUSH_MS = 10 * 60 * 1000;
+
+    static uint32_t keyFor(const char* url);
+
+    // Carga el indice y descarta las entradas cuyo archivo falta o no coincide
+    void begin();
+
+    // Si esta en cache deja la ruta en path y la marca como usada (sin escribir en flash)
+    bool lookup(uint32_t key, char* path, size_t size);
+
+    // Guarda el orden del LRU si cambio y paso INDEX_FLUSH_MS desde la ultima escritura. Para llamar
+    // cuando no hay nada mas que hacer; si se corta la luz antes solo se pierde ese orden
+    void flush(uint32_t now);
+
+    // Como lookup pero sin contar ni tocar el LRU (para el prefetch)
+    bool contains(uint32_t key);
+
+    // Ruta temporal donde se escribe una descarga antes de validarla
+    void tempPath(char* path, size_t size);
+
+    // Valida el archivo temporal (largo esperado o -1 si no se conoce, archivo completo) y lo agrega.
+    // Si no es valido lo borra y devuelve false
+    bool commit(uint32_t key, int32_t expectedSize);
+    void discard();
+
+    void pathFor(uint32_t key, char* path, size_t size);
+
+    // Los colores viajan con la entrada: se van con ella al desalojarla
+    void setPalette(uint32_t key, uint32_t palette);
+    uint32_t palette(uint32_t key);
+
+    uint32_t hits() const;
+    uint32_t misses() const;
+    uint32_t evictions() const;
+    void printStats();
+
+    ArtCache(fs::FS& fs, const char* dir, uint32_t budgetBytes, ArtCacheFormat format = ART_CACHE_JPEG);
+};
+
+#endif
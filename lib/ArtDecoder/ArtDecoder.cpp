@@ -0,0 +1,131 @@
+#include "ArtDecoder.h"
+
+//========= tjpgd callbacks =========
+
+size_t ArtDecoder::readInput(JDEC* jd, uint8_t* buf, size_t len) {
+    ArtDecoder* self = (ArtDecoder*)jd->device;
+
+    if (self->remaining >= 0 && (int32_t)len > self->remaining)
+        len = self->remaining;
+
+    size_t done = 0;
+    while (done < len) {
+        size_t n;
+        if (buf != nullptr) {
+            // readBytes espera hasta el timeout del stream, asi se decodifica al ritmo de la red
+            n = self->input->readBytes(buf + done, len - done);
+            if (self->copy != nullptr && n > 0)
+                self->copy->write(buf + done, n);
+        } else {
+            // tjpgd pide saltear bytes (segmentos que no usa)
+            int c = self->input->read();
+            n = c >= 0 ? 1 : 0;
+            if (self->copy != nullptr && n > 0)
+                self->copy->write((uint8_t)c);
+        }
+        if (n == 0)
+            break;
+        done += n;
+    }
+
+    if (self->remaining >= 0)
+        self->remaining -= done;
+    self->bytesRead += done;
+    return done;
+}
+
+int ArtDecoder::writeOutput(JDEC* jd, void* bitmap, JRECT* rect) {
+    ArtDecoder* self = (ArtDecoder*)jd->device;
+
+    if (self->firstBlockAt == 0)
+        self->firstBlockAt = millis();
+
+    uint16_t w = rect->right - rect->left + 1;
+    uint16_t h = rect->bottom - rect->top + 1;
+    uint16_t* pixels = (uint16_t*)bitmap;
+
+    if (self->swapBytes) {
+        for (uint32_t i = 0; i < (uint32_t)w * h; i++)
+            pixels[i] = (pixels[i] << 8) | (pixels[i] >> 8);
+    }
+
+    return self->output(self->offsetX + rect->left, self->offsetY + rect->top, w, h, pixels) ? 1 : 0;
+}
+
+//========= Decode =========
+
+bool ArtDecoder::decode(Stream& input, int32_t length, int16_t x, int16_t y, uint8_t scale, ArtOutput output) {
+    this->input = &input;
+    this->output = output;
+    remaining = length;
+    offsetX = x;
+    offsetY = y;
+    bytesRead = 0;
+    startedAt = millis();
+    firstBlockAt = 0;
+    totalMs = 0;
+
+    uint8_t jpgScale = 0;
+    while (scale > 1 && jpgScale < 3) {
+        scale >>= 1;
+        jpgScale++;
+    }
+
+    void* workspace = malloc(TJPGD_WORKSPACE_SIZE);
+    if (!workspace) {
+        Serial.println("Sin memoria para decodificar la tapa");
+        return false;
+    }
+
+    JDEC jdec;
+    JRESULT result = jd_prepare(&jdec, readInput, workspace, TJPGD_WORKSPACE_SIZE, this);
+    if (result == JDR_OK) {
+        result = jd_decomp(&jdec, writeOutput, jpgScale);
+    }
+    free(workspace);
+
+    // Lo que quede despues del EOI se consume para no ensuciar la conexion (y para que la copia quede entera)
+    while (result == JDR_OK && remaining != 0) {
+        int c = input.read();
+        if (c < 0)
+            break;
+        if (copy != nullptr)
+            copy->write((uint8_t)c);
+        if (remaining > 0)
+            remaining--;
+    }
+
+    totalMs = millis() - startedAt;
+
+    if (result != JDR_OK) {
+        Serial.printf("Error al decodificar la tapa: %d\n", result);
+        return false;
+    }
+    return true;
+}
+
+void ArtDecoder::setSwapBytes(bool swap) {
+    swapBytes = swap;
+}
+
+void ArtDecoder::setCopy(Print* copy) {
+    this->copy = copy;
+}
+
+uint32_t ArtDecoder::firstBlockMs() const {
+    return firstBlockAt == 0 ? 0 : firstBlockAt - startedAt;
+}
+
+ArtDecoder::ArtDecoder() {
+    input = nullptr;
+    remaining = -1;
+    output = nullptr;
+    offsetX = 0;
+    offsetY = 0;
+    swapBytes = false;
+    copy = nullptr;
+    startedAt = 0;
+    firstBlockAt = 0;
+    totalMs = 0;
+    bytesRead = 0;
+}
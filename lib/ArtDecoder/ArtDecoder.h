@@ -0,0 +1,53 @@
+#ifndef ARTDECODER_H
+#define ARTDECODER_H
+
+#include <Arduino.h>
+#include <TJpg_Decoder.h>
+
+#ifndef TJPGD_WORKSPACE_SIZE
+#define TJPGD_WORKSPACE_SIZE 3100
+#endif
+
+// Mismo formato que el callback de TJpg_Decoder (tft_output)
+typedef bool (*ArtOutput)(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap);
+
+// Decodifica un JPEG a medida que llegan los bytes de un Stream (el socket de la descarga),
+// entregando cada bloque MCU apenas esta listo. No pasa por SPIFFS.
+class ArtDecoder {
+
+  private:
+    Stream* input;
+    int32_t remaining;  // -1 si no se conoce el largo
+    ArtOutput output;
+    int16_t offsetX;
+    int16_t offsetY;
+    bool swapBytes;
+    Print* copy;
+
+    uint32_t startedAt;
+    uint32_t firstBlockAt;
+
+    static size_t readInput(JDEC* jd, uint8_t* buf, size_t len);
+    static int writeOutput(JDEC* jd, void* bitmap, JRECT* rect);
+
+  public:
+    // Bytes libres contiguos que hacen falta para decodificar en streaming
+    static const size_t REQUIRED_HEAP = TJPGD_WORKSPACE_SIZE + 1024;
+
+    // scale: 1, 2, 4 u 8 (igual que TJpgDec.setJpgScale). Devuelve true si se decodifico la imagen entera
+    bool decode(Stream& input, int32_t length, int16_t x, int16_t y, uint8_t scale, ArtOutput output);
+
+    void setSwapBytes(bool swap);
+
+    // Todo lo que se lee del stream se escribe tambien aca (p.ej. el archivo de la cache), nullptr para nada
+    void setCopy(Print* copy);
+
+    // Tiempos de la ultima decodificacion, desde que se llamo a decode()
+    uint32_t firstBlockMs() const;
+    uint32_t totalMs;
+    uint32_t bytesRead;
+
+    ArtDecoder();
+};
+
+#endif
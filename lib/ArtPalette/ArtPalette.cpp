@@ -0,0 +1,140 @@
+#include "ArtPalette.h"
+
+// El texto es blanco y gris claro: el fondo no pasa de esta luminancia (0-255)
+#define BACKGROUND_MAX_LUMA 64
+// Por debajo de esto el acento se aclara hacia el blanco
+#define ACCENT_MIN_LUMA 176
+// Por encima de esto la caja es casi blanca y su puntaje para el fondo se divide por 8
+#define WHITE_LUMA 224
+
+//========= Color =========
+
+// Centro de la caja en 8 bits por canal
+static void binColor(int bin, int32_t& r, int32_t& g, int32_t& b) {
+    r = (((bin >> 6) & 7) << 5) | 16;
+    g = (((bin >> 3) & 7) << 5) | 16;
+    b = ((bin & 7) << 5) | 16;
+}
+
+static int32_t luma(int32_t r, int32_t g, int32_t b) {
+    return (77 * r + 150 * g + 29 * b) >> 8;
+}
+
+static int32_t saturation(int32_t r, int32_t g, int32_t b) {
+    int32_t high = r > g ? (r > b ? r : b) : (g > b ? g : b);
+    int32_t low = r < g ? (r < b ? r : b) : (g < b ? g : b);
+    return high - low;
+}
+
+static uint16_t to565(int32_t r, int32_t g, int32_t b) {
+    return (uint16_t)(((r & 0xF8) << 8) | ((g & 0xFC) << 3) | (b >> 3));
+}
+
+//========= Public =========
+
+void ArtPalette::reset() {
+    for (int i = 0; i < ART_PALETTE_BINS; i++)
+        bins[i] = 0;
+    samples = 0;
+}
+
+void ArtPalette::add(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t* pixels, bool swapped) {
+    const uint16_t mask = ART_PALETTE_STEP - 1;
+    uint16_t firstRow = (ART_PALETTE_STEP - (y & mask)) & mask;
+    uint16_t firstCol = (ART_PALETTE_STEP - (x & mask)) & mask;
+
+    for (uint16_t row = firstRow; row < h; row += ART_PALETTE_STEP) {
+        const uint16_t* line = pixels + (uint32_t)row * w;
+        for (uint16_t col = firstCol; col < w; col += ART_PALETTE_STEP) {
+            uint16_t c = line[col];
+            if (swapped)
+                c = (uint16_t)((c >> 8) | (c << 8));
+            // Los 3 bits altos de cada canal: R 15-13, G 10-8, B 4-2
+            uint16_t bin = ((c >> 7) & 0x1C0) | ((c >> 5) & 0x38) | ((c >> 2) & 0x07);
+            if (bins[bin] != UINT16_MAX)
+                bins[bin]++;
+            samples++;
+        }
+    }
+}
+
+// Fondo: mayor muestras * (64 + saturacion), con las casi blancas a 1/8.
+// Acento: entre las cajas con luminancia >= 96 y saturacion >= 64, mayor muestras * saturacion (pesa la
+// cantidad, no cual es mas clara); si la tapa no tiene ninguna, el fondo. En los dos casos se aclara
+// hacia el blanco hasta ACCENT_MIN_LUMA
+ArtColors ArtPalette::colors() const {
+    ArtColors result = {ART_PALETTE_DEFAULT_BACKGROUND, ART_PALETTE_DEFAULT_ACCENT};
+    if (samples == 0)
+        return result;
+
+    int background = 0;
+    int accent = -1;
+    uint32_t bestBackground = 0;
+    uint32_t bestAccent = 0;
+    for (int bin = 0; bin < ART_PALETTE_BINS; bin++) {
+        if (bins[bin] == 0)
+            continue;
+
+        int32_t r, g, b;
+        binColor(bin, r, g, b);
+        int32_t l = luma(r, g, b);
+        int32_t s = saturation(r, g, b);
+
+        uint32_t score = bins[bin] * (uint32_t)(64 + s);
+        if (l > WHITE_LUMA)
+            score /= 8;
+        if (score > bestBackground) {
+            bestBackground = score;
+            background = bin;
+        }
+
+        if (l >= 96 && s >= 64 && bins[bin] * (uint32_t)s > bestAccent) {
+            bestAccent = bins[bin] * (uint32_t)s;
+            accent = bin;
+        }
+    }
+
+    int32_t r, g, b;
+    binColor(background, r, g, b);
+    int32_t l = luma(r, g, b);
+    if (l > BACKGROUND_MAX_LUMA) {
+        // Mismo tono, mas oscuro
+        result.background = to565(r * BACKGROUND_MAX_LUMA / l, g * BACKGROUND_MAX_LUMA / l, b * BACKGROUND_MAX_LUMA / l);
+    } else {
+        result.background = to565(r, g, b);
+    }
+
+    if (accent >= 0)
+        binColor(accent, r, g, b);
+    l = luma(r, g, b);
+    if (l < ACCENT_MIN_LUMA) {
+        // Hacia el blanco en la proporcion que falta para llegar a ACCENT_MIN_LUMA
+        int32_t lift = (ACCENT_MIN_LUMA - l) * 256 / (255 - l);
+        r += (255 - r) * lift >> 8;
+        g += (255 - g) * lift >> 8;
+        b += (255 - b) * lift >> 8;
+    }
+    result.accent = to565(r, g, b);
+    return result;
+}
+
+uint32_t ArtPalette::sampleCount() const {
+    return samples;
+}
+
+// El acento nunca es negro, asi que un paquete valido nunca es 0
+uint32_t ArtPalette::pack(const ArtColors& colors) {
+    return ((uint32_t)colors.background << 16) | colors.accent;
+}
+
+bool ArtPalette::unpack(uint32_t packed, ArtColors& colors) {
+    if (packed == 0)
+        return false;
+    colors.background = packed >> 16;
+    colors.accent = packed & 0xFFFF;
+    return true;
+}
+
+ArtPalette::ArtPalette() {
+    reset();
+}
@@ -0,0 +1,50 @@
+#ifndef ARTPALETTE_H
+#define ARTPALETTE_H
+
+#include <stdint.h>
+
+// 3 bits por canal: 512 cajas de 16 bits, 1 KB
+#define ART_PALETTE_BITS 3
+#define ART_PALETTE_BINS (1 << (3 * ART_PALETTE_BITS))
+
+// Se cuenta un pixel de cada ART_PALETTE_STEP en x y en y (potencia de 2). La grilla es la de la tapa
+// entera, no la de cada bloque, asi los bloques recortados en los bordes no pesan de mas
+#define ART_PALETTE_STEP 4
+
+// El fondo de siempre (0x383b39) en RGB565, para cuando no hay tapa
+#define ART_PALETTE_DEFAULT_BACKGROUND 0x39C7
+#define ART_PALETTE_DEFAULT_ACCENT 0xFFFF
+
+// Ambos en RGB565 con el orden de bytes del CPU
+struct ArtColors {
+    uint16_t background;  // Oscurecido para que el texto blanco se siga leyendo
+    uint16_t accent;      // Claro, para la barra de progreso y los sliders
+};
+
+// Histograma de colores que se llena con los mismos bloques MCU que entrega el decodificador, asi los
+// colores de la tapa salen sin decodificarla dos veces. Todo en enteros: una suma por muestra y el
+// resto al final, en colors()
+class ArtPalette {
+
+  private:
+    uint16_t bins[ART_PALETTE_BINS];
+    uint32_t samples;
+
+  public:
+    void reset();
+
+    // Un bloque en (x, y) relativo a la esquina de la tapa. swapped: bytes invertidos, como los pide pushImage
+    void add(int16_t x, int16_t y, uint16_t w, uint16_t h, const uint16_t* pixels, bool swapped);
+
+    // Sin muestras devuelve los colores de siempre
+    ArtColors colors() const;
+    uint32_t sampleCount() const;
+
+    // Fondo y acento en 32 bits para la cache y el snapshot; 0 es "no se conocen"
+    static uint32_t pack(const ArtColors& colors);
+    static bool unpack(uint32_t packed, ArtColors& colors);
+
+    ArtPalette();
+};
+
+#endif
@@ -0,0 +1,184 @@
+#include "BridgeClient.h"
+
+// Cada cuanto se mira el socket. Lo que tarda un cambio en llegar a la pantalla es como mucho esto
+#define BRIDGE_READ_MS 100
+#define BRIDGE_PARTIAL_READ_MS 10
+
+//========= Conexion =========
+
+bool BridgeClient::connect(uint32_t now) {
+    if (client->connected())
+        return true;
+    if (attempted && now - lastAttemptAt < BRIDGE_RETRY_MS)
+        return false;
+    attempted = true;
+    lastAttemptAt = now;
+
+    if (!client->connect(host, port))
+        return false;
+
+    connectCount++;
+    lineLength = 0;
+    lastHeardAt = now;
+    client->printf("SUB %s\n", name);
+    Serial.printf("[puente] conectado a %s:%u\n", host, port);
+    return true;
+}
+
+bool BridgeClient::connected() {
+    return client->connected();
+}
+
+void BridgeClient::disconnect() {
+    client->stop();
+}
+
+void BridgeClient::sendCommand(const TransportBatch& batch) {
+    if (!client->connected())
+        return;
+    client->printf("CMD %u %d %d %d %d\n", batch.seq, (int)batch.skip, (int)batch.play, (int)batch.seekMs, (int)batch.volume);
+}
+
+//========= Mensajes =========
+
+void BridgeClient::applyField(char* key, char* value) {
+    if (strcmp(key, "id") == 0)
+        strlcpy(state.id, value, sizeof(state.id));
+    else if (strcmp(key, "name") == 0)
+        strlcpy(state.name, value, sizeof(state.name));
+    else if (strcmp(key, "artist") == 0)
+        strlcpy(state.artist, value, sizeof(state.artist));
+    else if (strcmp(key, "img") == 0) {
+        // La tapa se baja del puente, no de i.scdn.co
+        if (value[0] == '\0')
+            state.imageUrl[0] = '\0';
+        else
+            snprintf(state.imageUrl, sizeof(state.imageUrl), "http://%s:%u%s", host, port, value);
+    } else if (strcmp(key, "w") == 0)
+        state.imageWidth = strtoul(value, nullptr, 10);
+    else if (strcmp(key, "dur") == 0)
+        state.durationMs = strtol(value, nullptr, 10);
+    else if (strcmp(key, "prog") == 0)
+        state.progressMs = strtol(value, nullptr, 10);
+    else if (strcmp(key, "age") == 0)
+        sampledAt = millis() - strtoul(value, nullptr, 10);
+    else if (strcmp(key, "play") == 0)
+        state.isPlaying = value[0] == '1';
+    else if (strcmp(key, "vol") == 0)
+        state.volumePercent = strtol(value, nullptr, 10);
+    else if (strcmp(key, "active") == 0)
+        active = value[0] == '1';
+    else if (strcmp(key, "ack") == 0)
+        ackedSeq = strtoul(value, nullptr, 10);
+}
+
+void BridgeClient::handleLine() {
+    if (line[0] != 'S')
+        return;  // "P" o algo que todavia no se entiende
+
+    char* cursor = line + 1;
+    while (*cursor == '\t') {
+        char* key = cursor + 1;
+        char* end = strchr(key, '\t');
+        if (end != nullptr)
+            *end = '\0';
+        char* value = strchr(key, '=');
+        if (value != nullptr) {
+            *value = '\0';
+            applyField(key, value + 1);
+        }
+        if (end == nullptr)
+            break;
+        *end = '\t';
+        cursor = end;
+    }
+    messageCount++;
+
+    // El progreso que no vino se sigue interpolando desde el ultimo que llego, igual que con un 304
+    PlaybackSnapshot snapshot;
+    snapshot.state = state;
+    snapshot.active = active;
+    snapshot.artVersion = 0;
+    snapshot.artPath[0] = '\0';
+    snapshot.artScale = 1;
+    snapshot.artPalette = 0;
+    snapshot.commandSeq = ackedSeq;
+    snapshot.sampledAt = sampledAt;
+    snapshot.restored = false;
+    listener->onSnapshot(snapshot);
+}
+
+uint32_t BridgeClient::step(uint32_t now) {
+    if (!client->connected())
+        return BRIDGE_RETRY_MS;
+
+    while (client->available() > 0) {
+        int c = client->read();
+        if (c < 0)
+            break;
+        byteCount++;
+        lastHeardAt = now;
+        if (c == '\n') {
+            line[lineLength] = '\0';
+            handleLine();
+            lineLength = 0;
+        } else if (lineLength < sizeof(line) - 1) {
+            line[lineLength++] = c;
+        }
+        // Una linea mas larga que el buffer se recorta; el campo que quedo afuera llega en el proximo cambio
+    }
+
+    if (now - lastHeardAt > BRIDGE_TIMEOUT_MS) {
+        Serial.println("[puente] sin noticias, se vuelve a consultar a spotify");
+        client->stop();
+        lastAttemptAt = now;
+    }
+
+    // El puente avisa solo: se mira seguido solo si quedo un mensaje a medio llegar
+    return lineLength > 0 ? BRIDGE_PARTIAL_READ_MS : BRIDGE_READ_MS;
+}
+
+//========= Stats =========
+
+uint32_t BridgeClient::messages() const {
+    return messageCount;
+}
+
+uint32_t BridgeClient::bytes() const {
+    return byteCount;
+}
+
+uint32_t BridgeClient::connects() const {
+    return connectCount;
+}
+
+const PlaybackState& BridgeClient::currentState() const {
+    return state;
+}
+
+void BridgeClient::printStats() {
+    Serial.printf("[puente] %s, %u conexiones, %u mensajes, %u bytes\n",
+                  client->connected() ? "conectado" : "desconectado", connectCount, messageCount, byteCount);
+}
+
+BridgeClient::BridgeClient(Client& client, const char* host, uint16_t port, const char* name, PlayerListener& listener) {
+    this->client = &client;
+    this->host = host;
+    this->port = port;
+    this->name = name;
+    this->listener = &listener;
+
+    lineLength = 0;
+    memset(&state, 0, sizeof(state));
+    state.volumePercent = -1;
+    active = false;
+    sampledAt = 0;
+    ackedSeq = 0;
+    lastHeardAt = 0;
+    lastAttemptAt = 0;
+    attempted = false;
+
+    messageCount = 0;
+    byteCount = 0;
+    connectCount = 0;
+}
@@ -0,0 +1,62 @@
+#ifndef BRIDGECLIENT_H
+#define BRIDGECLIENT_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+#include "BridgeProtocol.h"
+#include "CommandCoalescer.h"
+#include "PlayerSession.h"
+
+// Lado del controlador del puente de la LAN: en lugar de consultar a spotify recibe los cambios de
+// estado del puente y se los pasa al mismo PlayerListener que usa PlayerSession. Los comandos van al
+// puente. Si el puente no esta o se calla, connected() da false y la tarea de red vuelve a PlayerSession.
+class BridgeClient {
+
+  private:
+    Client* client;
+    const char* host;
+    uint16_t port;
+    const char* name;
+    PlayerListener* listener;
+
+    char line[BRIDGE_LINE_MAX];
+    size_t lineLength;
+
+    PlaybackState state;
+    bool active;
+    uint32_t sampledAt;
+    uint32_t ackedSeq;
+    uint32_t lastHeardAt;
+    uint32_t lastAttemptAt;
+    bool attempted;
+
+    uint32_t messageCount;
+    uint32_t byteCount;
+    uint32_t connectCount;
+
+    void handleLine();
+    void applyField(char* key, char* value);
+
+  public:
+    // Si no hay conexion la intenta, como mucho una vez cada BRIDGE_RETRY_MS. true si quedo conectado
+    bool connect(uint32_t now);
+    bool connected();
+    void disconnect();
+
+    void sendCommand(const TransportBatch& batch);
+
+    // Lee lo que haya llegado y avisa al listener. Devuelve cuantos ms esperar antes de volver a leer
+    uint32_t step(uint32_t now);
+
+    uint32_t messages() const;
+    uint32_t bytes() const;
+    uint32_t connects() const;
+    const PlaybackState& currentState() const;
+    void printStats();
+
+    // name identifica al controlador en el log del puente
+    BridgeClient(Client& client, const char* host, uint16_t port, const char* name, PlayerListener& listener);
+};
+
+#endif
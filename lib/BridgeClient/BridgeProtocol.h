@@ -0,0 +1,35 @@
+#ifndef BRIDGEPROTOCOL_H
+#define BRIDGEPROTOCOL_H
+
+// Protocolo entre el puente (src/bridge) y los controladores. Texto, una linea por mensaje, un solo puerto TCP.
+//
+// Controlador -> puente:
+//   SUB <nombre>                          primera linea; el puente contesta con el estado completo
+//   CMD <seq> <skip> <play> [<seek> <vol>]  un TransportBatch (play: -1, 0 o 1; seek en ms y vol de 0 a 100,
+//                                         -1 sin cambios). seq vuelve en ack=
+//
+// Puente -> controlador, campos clave=valor separados por tabs:
+//   S\tcampo=valor\t...                   estado: solo los campos que cambiaron desde el ultimo S a ese controlador
+//   P                                     sigue vivo, cada BRIDGE_HEARTBEAT_MS si no hubo otro mensaje
+//
+// Campos de S: id, name, artist, dur (ms), play (0/1), vol (0-100), active (0/1), img (path de la tapa en el puente),
+// w (ancho de la tapa), ack (ultimo CMD aplicado). prog (ms) y age (ms desde que spotify lo midio) van juntos
+// y solo cuando el progreso se aparta de lo que el controlador ya interpola.
+//
+// En el mismo puerto, "GET /art/<clave> HTTP/1.0" devuelve la tapa (JPEG) desde la cache del puente.
+
+#ifndef BRIDGE_PORT
+#define BRIDGE_PORT 4680
+#endif
+
+#define BRIDGE_HEARTBEAT_MS 15000
+// Sin noticias del puente en este tiempo, el controlador vuelve a consultar a spotify
+#define BRIDGE_TIMEOUT_MS 45000
+// Un controlador sin puente lo vuelve a buscar cada tanto
+#define BRIDGE_RETRY_MS 60000
+// Diferencia de progreso a partir de la cual se manda prog/age
+#define BRIDGE_PROGRESS_TOLERANCE_MS 1000
+
+#define BRIDGE_LINE_MAX 512
+
+#endif
@@ -0,0 +1,190 @@
+#include "BrowserController.h"
+
+#include "ArtCache.h"
+
+//========= Miniaturas =========
+
+// Slot del pool con la miniatura de item, o -1 si todavia no esta. Si falta y la lista esta quieta se pide
+int BrowserController::thumbFor(const BrowserItem* item, bool settled) {
+    if (item == nullptr || item->thumbUrl[0] == '\0')
+        return -1;
+
+    uint32_t key = ArtCache::keyFor(item->thumbUrl);
+    int slot = thumbs->find(key);
+    if (slot < 0 && settled) {
+        slot = thumbs->reserve(key);
+        if (slot >= 0) {
+            ThumbRequest request;
+            request.slot = slot;
+            request.key = key;
+            request.width = item->thumbWidth;
+            request.scale = thumbScaleFor(item->thumbWidth);
+            strlcpy(request.url, item->thumbUrl, sizeof(request.url));
+            if (queues->thumbRequests.push(request)) {
+                thumbRequestCount++;
+            } else {
+                thumbs->release(slot);
+                slot = -1;
+            }
+        }
+    }
+    return slot >= 0 && thumbs->state(slot) == THUMB_READY ? slot : -1;
+}
+
+//========= Pasada de la UI =========
+
+void BrowserController::open(BrowserSource source, const char* contextId) {
+    list.open(source, contextId);
+    rows.reset();
+    for (int i = 0; i < BROWSER_ROW_SLOTS; i++) {
+        if (rowVisible[i])
+            sink->hideRow(i);
+        rowVisible[i] = false;
+        shownThumb[i] = -1;
+    }
+    lastFirst = UINT32_MAX;
+}
+
+uint32_t BrowserController::frame(int32_t scrollY, uint32_t now) {
+    frameCount++;
+    thumbs->beginFrame();
+
+    BrowserPage page;
+    while (queues->pages.pop(page))
+        list.onPage(page);
+    ThumbResult result;
+    while (queues->thumbResults.pop(result))
+        thumbs->finish(result);
+
+    uint32_t first, count;
+    rows.layout(scrollY, list.size(), first, count);
+    list.setViewport(first, count);
+    if (first != lastFirst) {
+        lastFirst = first;
+        firstSince = now;
+    }
+    bool settled = now - firstSince >= THUMB_SETTLE_MS;
+
+    BrowserRequest request;
+    if (list.nextRequest(request) && !queues->requests.push(request))
+        list.cancelRequest();
+
+    bool visible[BROWSER_ROW_SLOTS] = {};
+    for (uint32_t index = first; index < first + count; index++) {
+        uint8_t slot = rows.slotFor(index);
+        const BrowserItem* item = list.item(index);
+        visible[slot] = true;
+        visibleRowFrames++;
+        if (item == nullptr)
+            emptyRowFrames++;
+
+        if (rows.needsBind(index, item != nullptr)) {
+            sink->bindRow(slot, index, item);
+            rows.bound(index, item != nullptr);
+            shownThumb[slot] = -2;
+        }
+
+        int thumb = thumbFor(item, settled);
+        if (thumb < 0 && item != nullptr && item->thumbUrl[0] != '\0')
+            missingThumbFrames++;
+        if (thumb != shownThumb[slot]) {
+            sink->bindThumb(slot, thumb);
+            shownThumb[slot] = thumb;
+        }
+    }
+
+    // Las que sobran se esconden, no se destruyen
+    for (int i = 0; i < BROWSER_ROW_SLOTS; i++) {
+        if (rowVisible[i] && !visible[i])
+            sink->hideRow(i);
+        rowVisible[i] = visible[i];
+    }
+
+    return settled ? UINT32_MAX : THUMB_SETTLE_MS - (now - firstSince);
+}
+
+bool BrowserController::playFrom(uint32_t index) {
+    if (list.currentSource() != BROWSE_PLAYLIST_TRACKS)
+        return false;
+
+    BrowserRequest request;
+    request.source = BROWSE_PLAYLIST_TRACKS;
+    request.generation = 0;
+    request.offset = index;
+    request.play = true;
+    strlcpy(request.contextId, list.context(), sizeof(request.contextId));
+    return queues->requests.push(request);
+}
+
+int32_t BrowserController::contentHeight() const {
+    return list.size() * rowHeight;
+}
+
+const BrowserItem* BrowserController::rowItem(uint8_t slot, uint32_t* index) const {
+    uint32_t bound = rows.boundTo(slot);
+    if (bound == RowRecycler::NONE)
+        return nullptr;
+    if (index != nullptr)
+        *index = bound;
+    return list.item(bound);
+}
+
+BrowserSource BrowserController::source() const {
+    return list.currentSource();
+}
+
+const char* BrowserController::context() const {
+    return list.context();
+}
+
+//========= Stats =========
+
+const BrowserList& BrowserController::pages() const {
+    return list;
+}
+
+uint32_t BrowserController::binds() const {
+    return rows.binds();
+}
+
+uint32_t BrowserController::frames() const {
+    return frameCount;
+}
+
+uint32_t BrowserController::visibleRows() const {
+    return visibleRowFrames;
+}
+
+uint32_t BrowserController::emptyRows() const {
+    return emptyRowFrames;
+}
+
+uint32_t BrowserController::missingThumbs() const {
+    return missingThumbFrames;
+}
+
+uint32_t BrowserController::thumbRequests() const {
+    return thumbRequestCount;
+}
+
+BrowserController::BrowserController(int32_t rowHeight, int32_t viewHeight, ThumbPool& thumbs, BrowserQueues& queues,
+                                     BrowserRowSink& sink) {
+    rows.setGeometry(rowHeight, viewHeight);
+    this->rowHeight = rowHeight;
+    this->thumbs = &thumbs;
+    this->queues = &queues;
+    this->sink = &sink;
+
+    for (int i = 0; i < BROWSER_ROW_SLOTS; i++) {
+        shownThumb[i] = -1;
+        rowVisible[i] = false;
+    }
+    lastFirst = UINT32_MAX;
+    firstSince = 0;
+
+    frameCount = 0;
+    visibleRowFrames = 0;
+    emptyRowFrames = 0;
+    missingThumbFrames = 0;
+    thumbRequestCount = 0;
+}
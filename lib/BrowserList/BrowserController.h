@@ -0,0 +1,93 @@
+#ifndef BROWSERCONTROLLER_H
+#define BROWSERCONTROLLER_H
+
+#include <stdint.h>
+
+#include "BrowserList.h"
+#include "SpscQueue.h"
+#include "ThumbPool.h"
+
+// Mientras la primera fila visible cambia mas seguido que esto (un fling) no se piden miniaturas:
+// las filas pasan antes de que llegue la imagen y la tarea de red bajaria tapas que nadie ve
+#define THUMB_SETTLE_MS 120
+
+// Entre la UI y la tarea de red. Las paginas salen de a una; las miniaturas, hasta una por slot del pool
+struct BrowserQueues {
+    SpscQueue<BrowserRequest, 2> requests;
+    SpscQueue<BrowserPage, 1> pages;
+    SpscQueue<ThumbRequest, THUMB_SLOTS> thumbRequests;
+    SpscQueue<ThumbResult, THUMB_SLOTS> thumbResults;
+};
+
+// Lo que hace la UI con cada fila reciclada (LVGL en el ESP32, contadores en env:native)
+class BrowserRowSink {
+
+  public:
+    // Llena el slot con la fila index; item es nullptr mientras su pagina no llego
+    virtual void bindRow(uint8_t slot, uint32_t index, const BrowserItem* item) = 0;
+
+    // Miniatura del slot: thumbSlot es el del ThumbPool, -1 para ninguna
+    virtual void bindThumb(uint8_t slot, int thumbSlot) = 0;
+
+    // La fila ya no se ve (la lista es mas corta que la pantalla)
+    virtual void hideRow(uint8_t slot) = 0;
+
+    virtual ~BrowserRowSink() {}
+};
+
+// El navegador del lado de la UI, sin LVGL: en cada pasada aplica lo que mando la tarea de red,
+// rellena solo las filas recicladas que cambiaron y pide la pagina y las miniaturas que faltan.
+class BrowserController {
+
+  private:
+    BrowserList list;
+    RowRecycler rows;
+    ThumbPool* thumbs;
+    BrowserQueues* queues;
+    BrowserRowSink* sink;
+
+    int32_t rowHeight;
+    int8_t shownThumb[BROWSER_ROW_SLOTS];
+    bool rowVisible[BROWSER_ROW_SLOTS];
+    uint32_t lastFirst;
+    uint32_t firstSince;
+
+    uint32_t frameCount;
+    uint32_t visibleRowFrames;
+    uint32_t emptyRowFrames;
+    uint32_t missingThumbFrames;
+    uint32_t thumbRequestCount;
+
+    int thumbFor(const BrowserItem* item, bool settled);
+
+  public:
+    void open(BrowserSource source, const char* contextId = "");
+
+    // Una pasada con el scroll en scrollY. Devuelve en cuantos ms hace falta otra aunque no pase nada
+    // (se esta esperando que se asiente para pedir miniaturas), UINT32_MAX si no hace falta
+    uint32_t frame(int32_t scrollY, uint32_t now);
+
+    // Toque en una fila de una playlist: la tarea de red la reproduce desde ahi
+    bool playFrom(uint32_t index);
+
+    // Alto de toda la lista, para el area de scroll
+    int32_t contentHeight() const;
+
+    // Fila que muestra el slot (para el toque), nullptr si no hay ninguna cargada
+    const BrowserItem* rowItem(uint8_t slot, uint32_t* index = nullptr) const;
+
+    BrowserSource source() const;
+    const char* context() const;
+
+    const BrowserList& pages() const;
+    uint32_t binds() const;
+    uint32_t frames() const;
+    uint32_t visibleRows() const;       // Filas visibles sumadas en todas las pasadas
+    uint32_t emptyRows() const;         // De esas, cuantas esperaban su pagina
+    uint32_t missingThumbs() const;     // Cuantas esperaban la miniatura
+    uint32_t thumbRequests() const;
+
+    BrowserController(int32_t rowHeight, int32_t viewHeight, ThumbPool& thumbs, BrowserQueues& queues, BrowserRowSink& sink);
+};
+
+#endif
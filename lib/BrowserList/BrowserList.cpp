@@ -0,0 +1,247 @@
+#include "BrowserList.h"
+
+#include <string.h>
+
+//========= Paginas =========
+
+static uint32_t pageOffset(uint32_t index) {
+    return index - index % BROWSER_PAGE_SIZE;
+}
+
+int BrowserList::slotOf(uint32_t offset) const {
+    for (int i = 0; i < BROWSER_WINDOW_PAGES; i++) {
+        if (loaded[i] && pages[i].offset == offset)
+            return i;
+    }
+    return -1;
+}
+
+bool BrowserList::wants(uint32_t offset) const {
+    if (totalKnown && offset >= total)
+        return false;
+    if (failed && failedOffset == offset)
+        return false;
+    return slotOf(offset) < 0;
+}
+
+// Filas entre la pagina y lo que se ve; 0 si se pisan
+uint32_t BrowserList::distance(uint32_t offset) const {
+    uint32_t end = offset + BROWSER_PAGE_SIZE;
+    if (end <= first)
+        return first - end + 1;
+    if (offset >= first + visible)
+        return offset - (first + visible) + 1;
+    return 0;
+}
+
+void BrowserList::open(BrowserSource source, const char* contextId) {
+    this->source = source;
+    strlcpy(this->contextId, contextId, sizeof(this->contextId));
+    generation++;
+    total = 0;
+    totalKnown = false;
+    for (int i = 0; i < BROWSER_WINDOW_PAGES; i++)
+        loaded[i] = false;
+    first = 0;
+    visible = 0;
+    scrollingUp = false;
+    pending = false;
+    failed = false;
+}
+
+void BrowserList::setViewport(uint32_t first, uint32_t count) {
+    if (first != this->first) {
+        scrollingUp = first < this->first;
+        failed = false;
+    }
+    this->first = first;
+    visible = count;
+}
+
+bool BrowserList::nextRequest(BrowserRequest& request) {
+    if (pending)
+        return false;
+
+    // Hasta la primera respuesta no se sabe cuantas filas hay
+    uint32_t candidates[3];
+    uint8_t count = 0;
+    if (!totalKnown) {
+        candidates[count++] = 0;
+    } else if (visible > 0) {
+        uint32_t firstPage = pageOffset(first);
+        uint32_t lastPage = pageOffset(first + visible - 1);
+        for (uint32_t offset = firstPage; offset <= lastPage && count < 2; offset += BROWSER_PAGE_SIZE)
+            candidates[count++] = offset;
+        // La que viene: se pide antes de que asome
+        if (scrollingUp && firstPage > 0)
+            candidates[count++] = firstPage - BROWSER_PAGE_SIZE;
+        else if (!scrollingUp)
+            candidates[count++] = lastPage + BROWSER_PAGE_SIZE;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (!wants(candidates[i]))
+            continue;
+        request.source = source;
+        request.generation = generation;
+        request.offset = candidates[i];
+        request.play = false;
+        strlcpy(request.contextId, contextId, sizeof(request.contextId));
+        pending = true;
+        pendingOffset = candidates[i];
+        return true;
+    }
+    return false;
+}
+
+void BrowserList::cancelRequest() {
+    pending = false;
+}
+
+bool BrowserList::onPage(const BrowserPage& page) {
+    if (page.generation != generation)
+        return false;
+    if (pending && page.offset == pendingOffset)
+        pending = false;
+
+    if (!page.ok) {
+        failed = true;
+        failedOffset = page.offset;
+        return true;
+    }
+
+    total = page.total;
+    totalKnown = true;
+    if (slotOf(page.offset) >= 0)
+        return true;
+
+    // Lugar libre o, si no hay, la pagina mas lejos de lo que se ve
+    int slot = -1;
+    uint32_t farthest = 0;
+    for (int i = 0; i < BROWSER_WINDOW_PAGES; i++) {
+        if (!loaded[i]) {
+            slot = i;
+            break;
+        }
+        uint32_t d = distance(pages[i].offset);
+        if (slot < 0 || d > farthest) {
+            slot = i;
+            farthest = d;
+        }
+    }
+    if (loaded[slot])
+        evictionCount++;
+
+    pages[slot] = page;
+    loaded[slot] = true;
+    loadCount++;
+    return true;
+}
+
+const BrowserItem* BrowserList::item(uint32_t index) const {
+    int slot = slotOf(pageOffset(index));
+    if (slot < 0 || index - pages[slot].offset >= pages[slot].count)
+        return nullptr;
+    return &pages[slot].items[index - pages[slot].offset];
+}
+
+uint32_t BrowserList::size() const {
+    return total;
+}
+
+bool BrowserList::loading() const {
+    return pending;
+}
+
+BrowserSource BrowserList::currentSource() const {
+    return source;
+}
+
+const char* BrowserList::context() const {
+    return contextId;
+}
+
+uint32_t BrowserList::pagesLoaded() const {
+    return loadCount;
+}
+
+uint32_t BrowserList::pagesEvicted() const {
+    return evictionCount;
+}
+
+uint32_t BrowserList::itemsInMemory() const {
+    uint32_t items = 0;
+    for (int i = 0; i < BROWSER_WINDOW_PAGES; i++) {
+        if (loaded[i])
+            items += pages[i].count;
+    }
+    return items;
+}
+
+BrowserList::BrowserList() {
+    generation = 0;
+    loadCount = 0;
+    evictionCount = 0;
+    pendingOffset = 0;
+    failedOffset = 0;
+    open(BROWSE_QUEUE);
+}
+
+//========= Filas =========
+
+void RowRecycler::layout(int32_t scrollY, uint32_t total, uint32_t& first, uint32_t& count) const {
+    if (scrollY < 0)
+        scrollY = 0;
+    first = scrollY / rowHeight;
+    uint32_t last = (scrollY + viewHeight - 1) / rowHeight;
+    if (first >= total) {
+        count = 0;
+        return;
+    }
+    if (last >= total)
+        last = total - 1;
+    count = last - first + 1;
+}
+
+uint8_t RowRecycler::slotFor(uint32_t index) const {
+    return index % BROWSER_ROW_SLOTS;
+}
+
+bool RowRecycler::needsBind(uint32_t index, bool loaded) const {
+    uint8_t slot = slotFor(index);
+    return boundIndex[slot] != index || (loaded && !boundLoaded[slot]);
+}
+
+void RowRecycler::bound(uint32_t index, bool loaded) {
+    uint8_t slot = slotFor(index);
+    boundIndex[slot] = index;
+    boundLoaded[slot] = loaded;
+    bindCount++;
+}
+
+uint32_t RowRecycler::boundTo(uint8_t slot) const {
+    return boundIndex[slot];
+}
+
+void RowRecycler::setGeometry(int32_t rowHeight, int32_t viewHeight) {
+    this->rowHeight = rowHeight;
+    this->viewHeight = viewHeight;
+}
+
+void RowRecycler::reset() {
+    for (int i = 0; i < BROWSER_ROW_SLOTS; i++) {
+        boundIndex[i] = NONE;
+        boundLoaded[i] = false;
+    }
+}
+
+uint32_t RowRecycler::binds() const {
+    return bindCount;
+}
+
+RowRecycler::RowRecycler() {
+    rowHeight = 1;
+    viewHeight = 1;
+    bindCount = 0;
+    reset();
+}
@@ -0,0 +1,117 @@
+#ifndef BROWSERLIST_H
+#define BROWSERLIST_H
+
+#include <stdint.h>
+
+#include "PlaybackState.h"
+
+// Paginas en memoria. Con BROWSER_PAGE_SIZE filas por pagina y 6 visibles alcanza para lo que se ve
+// y la pagina que viene; una playlist de 1000 temas ocupa lo mismo que una de 20
+#define BROWSER_WINDOW_PAGES 3
+
+// Filas de widgets del navegador: las que entran en la pantalla mas las que asoman mientras se scrollea
+#define BROWSER_ROW_SLOTS 8
+
+// Lista larga cargada de a paginas (cola, playlists o los temas de una playlist). Solo la toca la UI:
+// dice que pagina pedir segun lo que se ve y se queda con las BROWSER_WINDOW_PAGES mas cercanas.
+// Las paginas van y vienen por SpscQueue, la tarea de red nunca ve esta clase.
+class BrowserList {
+
+  private:
+    BrowserPage pages[BROWSER_WINDOW_PAGES];
+    bool loaded[BROWSER_WINDOW_PAGES];
+
+    BrowserSource source;
+    char contextId[sizeof(BrowserItem::id)];
+    uint32_t generation;
+    uint32_t total;
+    bool totalKnown;
+
+    uint32_t first;
+    uint32_t visible;
+    bool scrollingUp;
+
+    // De a una pagina por vez; una que fallo no se vuelve a pedir hasta que se mueva la lista
+    bool pending;
+    uint32_t pendingOffset;
+    bool failed;
+    uint32_t failedOffset;
+
+    uint32_t loadCount;
+    uint32_t evictionCount;
+
+    int slotOf(uint32_t offset) const;
+    bool wants(uint32_t offset) const;
+    uint32_t distance(uint32_t offset) const;
+
+  public:
+    // Vacia todo y arranca otra lista; las paginas de la anterior que sigan en camino se descartan
+    void open(BrowserSource source, const char* contextId = "");
+
+    // Filas que se ven ahora
+    void setViewport(uint32_t first, uint32_t count);
+
+    // La proxima pagina a pedir: primero las visibles, despues la que sigue en el sentido del scroll
+    bool nextRequest(BrowserRequest& request);
+
+    // El pedido de nextRequest() no pudo salir (cola llena): se vuelve a pedir en la proxima pasada
+    void cancelRequest();
+
+    // Respuesta de la tarea de red. Devuelve false si era de otra lista
+    bool onPage(const BrowserPage& page);
+
+    // nullptr si la pagina de esa fila todavia no llego (o ya se desalojo)
+    const BrowserItem* item(uint32_t index) const;
+
+    // Filas de la lista; 0 hasta que llega la primera pagina
+    uint32_t size() const;
+    bool loading() const;
+    BrowserSource currentSource() const;
+    const char* context() const;
+
+    uint32_t pagesLoaded() const;
+    uint32_t pagesEvicted() const;
+    uint32_t itemsInMemory() const;
+
+    BrowserList();
+};
+
+// Filas recicladas: hay BROWSER_ROW_SLOTS widgets para toda la lista. La fila index va siempre al
+// slot index % BROWSER_ROW_SLOTS, asi al scrollear solo se rellena la que entra y las demas no se tocan
+class RowRecycler {
+
+  private:
+    int32_t rowHeight;
+    int32_t viewHeight;
+    uint32_t boundIndex[BROWSER_ROW_SLOTS];
+    bool boundLoaded[BROWSER_ROW_SLOTS];
+    uint32_t bindCount;
+
+  public:
+    static const uint32_t NONE = UINT32_MAX;
+
+    // Primera fila visible y cuantas se ven (tambien las cortadas) con el scroll en scrollY
+    void layout(int32_t scrollY, uint32_t total, uint32_t& first, uint32_t& count) const;
+
+    uint8_t slotFor(uint32_t index) const;
+
+    // true si el slot de index muestra otra fila, o la muestra vacia y los datos ya llegaron
+    bool needsBind(uint32_t index, bool loaded) const;
+    void bound(uint32_t index, bool loaded);
+
+    // Fila que muestra el slot, NONE si ninguna
+    uint32_t boundTo(uint8_t slot) const;
+
+    // Alto de cada fila y del area visible, en pixeles
+    void setGeometry(int32_t rowHeight, int32_t viewHeight);
+
+    // Al abrir otra lista
+    void reset();
+
+    // Veces que se relleno un slot, para ver cuanto trabajo hace cada frame
+    uint32_t binds() const;
+
+    RowRecycler();
+};
+
+#endif
@@ -0,0 +1,86 @@
+#include "CommandCoalescer.h"
+
+//========= UI =========
+
+uint32_t CommandCoalescer::addSkip(int32_t delta) {
+    int32_t current = skip.load(std::memory_order_relaxed);
+    int32_t wanted;
+    do {
+        wanted = current + delta;
+        // No tiene sentido mandar decenas de skips, se acota
+        if (wanted > MAX_SKIP)
+            wanted = MAX_SKIP;
+        if (wanted < -MAX_SKIP)
+            wanted = -MAX_SKIP;
+    } while (!skip.compare_exchange_weak(current, wanted, std::memory_order_relaxed));
+
+    taps.fetch_add(1, std::memory_order_relaxed);
+    // seq se publica al final, asi quien lo lea ya ve el comando
+    return seq.fetch_add(1, std::memory_order_release) + 1;
+}
+
+uint32_t CommandCoalescer::next() {
+    return addSkip(1);
+}
+
+uint32_t CommandCoalescer::prev() {
+    return addSkip(-1);
+}
+
+uint32_t CommandCoalescer::setPlaying(bool playing) {
+    play.store(playing ? 1 : 0, std::memory_order_relaxed);
+    taps.fetch_add(1, std::memory_order_relaxed);
+    return seq.fetch_add(1, std::memory_order_release) + 1;
+}
+
+// Cada evento del arrastre pisa el anterior; el numero de secuencia avanza igual para que la UI
+// ignore las consultas viejas hasta que se mande el ultimo
+uint32_t CommandCoalescer::seekTo(uint32_t positionMs) {
+    seekMs.store((int32_t)positionMs, std::memory_order_relaxed);
+    seekEvents.fetch_add(1, std::memory_order_relaxed);
+    return seq.fetch_add(1, std::memory_order_release) + 1;
+}
+
+uint32_t CommandCoalescer::setVolume(uint8_t percent) {
+    volume.store(percent > 100 ? 100 : percent, std::memory_order_relaxed);
+    volumeEvents.fetch_add(1, std::memory_order_relaxed);
+    return seq.fetch_add(1, std::memory_order_release) + 1;
+}
+
+//========= Network task =========
+
+bool CommandCoalescer::take(TransportBatch& batch) {
+    uint32_t current = seq.load(std::memory_order_acquire);
+    if (current == takenSeq)
+        return false;
+
+    // Un toque que llegue entre estas lineas queda en este lote o en el siguiente, nunca se pierde
+    batch.seq = current;
+    batch.skip = skip.exchange(0, std::memory_order_relaxed);
+    batch.play = play.exchange(-1, std::memory_order_relaxed);
+    batch.seekMs = seekMs.exchange(-1, std::memory_order_relaxed);
+    batch.volume = volume.exchange(-1, std::memory_order_relaxed);
+    takenSeq = current;
+    return true;
+}
+
+bool CommandCoalescer::pending() const {
+    return seq.load(std::memory_order_acquire) != takenSeq;
+}
+
+uint32_t CommandCoalescer::tapCount() const {
+    return taps.load(std::memory_order_relaxed);
+}
+
+uint32_t CommandCoalescer::seekEventCount() const {
+    return seekEvents.load(std::memory_order_relaxed);
+}
+
+uint32_t CommandCoalescer::volumeEventCount() const {
+    return volumeEvents.load(std::memory_order_relaxed);
+}
+
+CommandCoalescer::CommandCoalescer()
+    : skip(0), play(-1), seekMs(-1), volume(-1), seq(0), taps(0), seekEvents(0), volumeEvents(0) {
+    takenSeq = 0;
+}
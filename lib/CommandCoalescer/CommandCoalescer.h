@@ -0,0 +1,58 @@
+#ifndef COMMANDCOALESCER_H
+#define COMMANDCOALESCER_H
+
+#include <atomic>
+#include <stdint.h>
+
+// Lo que la UI pidio desde la ultima vez que la tarea de red paso a buscar comandos
+struct TransportBatch {
+    int32_t skip;   // > 0 siguientes, < 0 anteriores (se cancelan entre si)
+    int8_t play;    // -1 sin cambios, 0 pausa, 1 reproducir
+    uint32_t seq;   // Ultimo comando incluido en el lote
+    int32_t seekMs; // -1 sin cambios; si no, la ultima posicion a la que se arrastro la barra
+    int8_t volume;  // -1 sin cambios, 0 a 100
+};
+
+// Junta las pulsaciones de prev/play-pause/next en un solo lote. La UI escribe sin bloquear y
+// la tarea de red toma todo junto: cinco "next" seguidos son un lote con skip = 5 y tres toques de
+// play-pause terminan en un solo estado final. Los arrastres (seek y volumen) se quedan solo con el
+// ultimo valor: mientras la tarea de red manda uno, los que llegan se pisan entre si.
+class CommandCoalescer {
+
+  private:
+    static const int32_t MAX_SKIP = 10;
+
+    std::atomic<int32_t> skip;
+    std::atomic<int8_t> play;
+    std::atomic<int32_t> seekMs;
+    std::atomic<int8_t> volume;
+    std::atomic<uint32_t> seq;
+    std::atomic<uint32_t> taps;
+    std::atomic<uint32_t> seekEvents;
+    std::atomic<uint32_t> volumeEvents;
+    uint32_t takenSeq;
+
+    uint32_t addSkip(int32_t delta);
+
+  public:
+    // UI. Devuelven el numero de secuencia del comando para saber cuando el estado lo refleja
+    uint32_t next();
+    uint32_t prev();
+    uint32_t setPlaying(bool playing);
+    uint32_t seekTo(uint32_t positionMs);
+    uint32_t setVolume(uint8_t percent);
+
+    // Tarea de red. Devuelve false si no hubo comandos nuevos
+    bool take(TransportBatch& batch);
+
+    // Tarea de red. true si la UI mando algo que todavia no se tomo (para cortar trabajo de fondo)
+    bool pending() const;
+
+    uint32_t tapCount() const;
+    uint32_t seekEventCount() const;    // Eventos de arrastre de la barra, no peticiones
+    uint32_t volumeEventCount() const;
+
+    CommandCoalescer();
+};
+
+#endif
@@ -0,0 +1,249 @@
+#include "ConnectivityManager.h"
+
+// Cada cuanto se mira el enlace mientras hay un intento en curso
+#define CONNECTING_CHECK_MS 100
+// Como en CommandCoalescer: mas saltos seguidos no tienen sentido
+#define HELD_SKIP_MAX 10
+
+//========= Enlace =========
+
+// Espera antes del proximo intento: 1 s, 2 s, 4 s... hasta BACKOFF_MAX_MS, con hasta un 25% mas al azar
+// para que varias pantallas no vuelvan todas juntas cuando se reinicia el AP
+uint32_t ConnectivityManager::backoff() {
+    uint32_t shift = attempt > 1 ? attempt - 1 : 0;
+    uint32_t wait = shift >= 16 ? BACKOFF_MAX_MS : BACKOFF_MIN_MS << shift;
+    if (wait > BACKOFF_MAX_MS)
+        wait = BACKOFF_MAX_MS;
+
+    jitterSeed ^= jitterSeed << 13;
+    jitterSeed ^= jitterSeed >> 17;
+    jitterSeed ^= jitterSeed << 5;
+    return wait + jitterSeed % (wait / 4 + 1);
+}
+
+void ConnectivityManager::startAttempt(uint32_t now) {
+    state = LINK_CONNECTING;
+    attemptStartedAt = now;
+    attemptTimeoutMs = link->connect(attempt);
+    attemptCount++;
+    attempt++;
+}
+
+void ConnectivityManager::onLost(uint32_t now) {
+    outageCount++;
+    downSince = now;
+    attempt = 0;
+    Serial.println("[red] se perdio la conexion, reconectando en segundo plano");
+    startAttempt(now);
+}
+
+void ConnectivityManager::onUp(uint32_t now) {
+    if (state != LINK_UP && outageCount > 0) {
+        uint32_t ms = now - downSince;
+        recoveryCount++;
+        recoveryTotalMs += ms;
+        if (ms > recoveryMaxMs)
+            recoveryMaxMs = ms;
+        Serial.printf("[red] conectado de nuevo en %u ms (%u intentos)\n", ms, attempt);
+    }
+    state = LINK_UP;
+    attempt = 0;
+    recovered = true;
+    link->onConnected();
+}
+
+void ConnectivityManager::begin(uint32_t now) {
+    attempt = 0;
+    startAttempt(now);
+}
+
+uint32_t ConnectivityManager::step(uint32_t now) {
+    bool up = link->isUp();
+
+    switch (state) {
+        case LINK_UP:
+            if (!up)
+                onLost(now);
+            break;
+
+        case LINK_CONNECTING:
+            if (up) {
+                onUp(now);
+            } else if (now - attemptStartedAt >= attemptTimeoutMs) {
+                link->disconnect();
+                state = LINK_WAITING;
+                retryAt = now + backoff();
+            }
+            break;
+
+        case LINK_WAITING:
+            if (up)
+                onUp(now);
+            else if ((int32_t)(now - retryAt) >= 0)
+                startAttempt(now);
+            break;
+    }
+
+    // Arriba, la caida la avisa quien lo usa (evento del WiFi o una falla de la API)
+    if (state == LINK_UP)
+        return UINT32_MAX;
+    if (state == LINK_CONNECTING)
+        return CONNECTING_CHECK_MS;
+    return (int32_t)(retryAt - now) > 0 ? retryAt - now : 0;
+}
+
+bool ConnectivityManager::online() const {
+    return state == LINK_UP;
+}
+
+LinkState ConnectivityManager::linkState() const {
+    return state;
+}
+
+bool ConnectivityManager::reconnected() {
+    bool was = recovered;
+    recovered = false;
+    return was;
+}
+
+void ConnectivityManager::onApiFailures(uint32_t consecutive, uint32_t now) {
+    if (state != LINK_UP || consecutive < API_FAILURES_TO_RESET)
+        return;
+    Serial.printf("[red] %u peticiones seguidas sin respuesta, se reconecta el enlace\n", consecutive);
+    apiResetCount++;
+    link->disconnect();
+    onLost(now);
+}
+
+//========= Comandos sin conexion =========
+
+void ConnectivityManager::holdCommands(const TransportBatch& batch, uint32_t now) {
+    if (!hasHeld) {
+        held.skip = 0;
+        held.play = -1;
+        held.seekMs = -1;
+        held.volume = -1;
+    }
+
+    if (batch.skip != 0) {
+        if (held.skip == 0)
+            heldSkipSince = now;
+        held.skip += batch.skip;
+        if (held.skip > HELD_SKIP_MAX)
+            held.skip = HELD_SKIP_MAX;
+        else if (held.skip < -HELD_SKIP_MAX)
+            held.skip = -HELD_SKIP_MAX;
+    }
+    if (batch.play >= 0) {
+        held.play = batch.play;
+        heldPlaySince = now;
+    }
+    if (batch.seekMs >= 0) {
+        held.seekMs = batch.seekMs;
+        heldSeekSince = now;
+    }
+    if (batch.volume >= 0) {
+        held.volume = batch.volume;
+        heldVolumeSince = now;
+    }
+    held.seq = batch.seq;
+    hasHeld = true;
+    heldCount++;
+}
+
+bool ConnectivityManager::releaseCommands(TransportBatch& batch, uint32_t now) {
+    if (!hasHeld)
+        return false;
+
+    batch = held;
+    hasHeld = false;
+
+    if (batch.skip != 0 && now - heldSkipSince > COMMAND_SKIP_TTL_MS) {
+        droppedSkipCount += batch.skip > 0 ? batch.skip : -batch.skip;
+        batch.skip = 0;
+    }
+    if (batch.play >= 0 && now - heldPlaySince > COMMAND_PLAY_TTL_MS) {
+        droppedPlayCount++;
+        batch.play = -1;
+    }
+    // La posicion pedida ya no corresponde a lo que suena
+    if (batch.seekMs >= 0 && now - heldSeekSince > COMMAND_SKIP_TTL_MS)
+        batch.seekMs = -1;
+    if (batch.volume >= 0 && now - heldVolumeSince > COMMAND_PLAY_TTL_MS)
+        batch.volume = -1;
+    return true;
+}
+
+//========= Stats =========
+
+uint32_t ConnectivityManager::outages() const {
+    return outageCount;
+}
+
+uint32_t ConnectivityManager::attempts() const {
+    return attemptCount;
+}
+
+uint32_t ConnectivityManager::recoveries() const {
+    return recoveryCount;
+}
+
+uint32_t ConnectivityManager::meanRecoveryMs() const {
+    return recoveryCount ? recoveryTotalMs / recoveryCount : 0;
+}
+
+uint32_t ConnectivityManager::maxRecoveryMs() const {
+    return recoveryMaxMs;
+}
+
+uint32_t ConnectivityManager::apiResets() const {
+    return apiResetCount;
+}
+
+uint32_t ConnectivityManager::heldCommands() const {
+    return heldCount;
+}
+
+uint32_t ConnectivityManager::droppedSkips() const {
+    return droppedSkipCount;
+}
+
+uint32_t ConnectivityManager::droppedPlays() const {
+    return droppedPlayCount;
+}
+
+void ConnectivityManager::printStats() {
+    Serial.printf("[red] %u caidas, %u intentos, recuperacion promedio %u ms (max %u), %u reconexiones por la API\n",
+                  outageCount, attemptCount, meanRecoveryMs(), recoveryMaxMs, apiResetCount);
+    Serial.printf("[red] comandos sin conexion: %u guardados, %u saltos y %u play/pausa descartados\n",
+                  heldCount, droppedSkipCount, droppedPlayCount);
+}
+
+ConnectivityManager::ConnectivityManager(NetworkLink& link) {
+    this->link = &link;
+    state = LINK_WAITING;
+    attempt = 0;
+    attemptStartedAt = 0;
+    attemptTimeoutMs = 0;
+    retryAt = 0;
+    downSince = 0;
+    recovered = false;
+    jitterSeed = 0x9e3779b9;
+
+    held = {0, -1, 0, -1, -1};
+    hasHeld = false;
+    heldSkipSince = 0;
+    heldPlaySince = 0;
+    heldSeekSince = 0;
+    heldVolumeSince = 0;
+
+    outageCount = 0;
+    attemptCount = 0;
+    recoveryCount = 0;
+    recoveryTotalMs = 0;
+    recoveryMaxMs = 0;
+    apiResetCount = 0;
+    heldCount = 0;
+    droppedSkipCount = 0;
+    droppedPlayCount = 0;
+}
@@ -0,0 +1,104 @@
+#ifndef CONNECTIVITYMANAGER_H
+#define CONNECTIVITYMANAGER_H
+
+#include <Arduino.h>
+
+#include "CommandCoalescer.h"
+#include "NetworkLink.h"
+
+enum LinkState {
+    LINK_UP,
+    LINK_CONNECTING,  // Hay un intento en curso
+    LINK_WAITING      // Espera antes del proximo intento
+};
+
+// Reemplaza al ESP.restart() cuando se cae la red: reconecta en segundo plano con espera exponencial
+// mientras la UI sigue con el ultimo estado, y guarda los comandos del usuario hasta que vuelva.
+// Politica de comandos sin conexion:
+//  - saltos (next/prev): se suman y se mandan si la red vuelve antes de COMMAND_SKIP_TTL_MS del primero;
+//    despues se descartan, saltar varios temas un minuto tarde sorprende mas que no saltar
+//  - play/pausa: se guarda el ultimo pedido y se manda si vuelve antes de COMMAND_PLAY_TTL_MS
+//  - seek y volumen: el ultimo valor, con los mismos plazos que los saltos y el play/pausa
+// Igual que PollScheduler no sabe nada de WiFi ni de FreeRTOS: todos los tiempos son millis() de quien lo usa.
+class ConnectivityManager {
+
+  private:
+    NetworkLink* link;
+    LinkState state;
+    uint32_t attempt;
+    uint32_t attemptStartedAt;
+    uint32_t attemptTimeoutMs;
+    uint32_t retryAt;
+    uint32_t downSince;
+    bool recovered;
+    uint32_t jitterSeed;
+
+    TransportBatch held;
+    bool hasHeld;
+    uint32_t heldSkipSince;
+    uint32_t heldPlaySince;
+    uint32_t heldSeekSince;
+    uint32_t heldVolumeSince;
+
+    uint32_t outageCount;
+    uint32_t attemptCount;
+    uint32_t recoveryCount;
+    uint64_t recoveryTotalMs;
+    uint32_t recoveryMaxMs;
+    uint32_t apiResetCount;
+    uint32_t heldCount;
+    uint32_t droppedSkipCount;
+    uint32_t droppedPlayCount;
+
+    void startAttempt(uint32_t now);
+    void onLost(uint32_t now);
+    void onUp(uint32_t now);
+    uint32_t backoff();
+
+  public:
+    static const uint32_t BACKOFF_MIN_MS = 1000;
+    static const uint32_t BACKOFF_MAX_MS = 60000;
+    // Fallas de transporte seguidas (sin respuesta HTTP) con el enlace arriba antes de reconectarlo
+    static const uint32_t API_FAILURES_TO_RESET = 3;
+    static const uint32_t COMMAND_SKIP_TTL_MS = 10000;
+    static const uint32_t COMMAND_PLAY_TTL_MS = 60000;
+
+    // Primer intento de conexion
+    void begin(uint32_t now);
+
+    // Mira el enlace y, si toca, arranca otro intento. Devuelve cuantos ms se puede esperar hasta volver a mirar
+    uint32_t step(uint32_t now);
+
+    bool online() const;
+    LinkState linkState() const;
+
+    // true una sola vez despues de cada reconexion, para consultar enseguida
+    bool reconnected();
+
+    // Fallas de transporte seguidas que lleva la API. Con el enlace arriba, un DNS o un AP colgado
+    // se ven asi: pasado el limite se corta el enlace y se reconecta
+    void onApiFailures(uint32_t consecutive, uint32_t now);
+
+    // Sin conexion: la tarea de red le pasa cada lote del coalescer
+    void holdCommands(const TransportBatch& batch, uint32_t now);
+
+    // Con conexion: el lote guardado despues de aplicar la politica. Aunque no quede nada para mandar
+    // devuelve true con el seq, asi la UI deja de esperar la confirmacion
+    bool releaseCommands(TransportBatch& batch, uint32_t now);
+
+    uint32_t outages() const;
+    uint32_t attempts() const;
+    uint32_t recoveries() const;
+    // Promedio y maximo desde que se detecto la caida hasta que el enlace volvio
+    uint32_t meanRecoveryMs() const;
+    uint32_t maxRecoveryMs() const;
+    uint32_t apiResets() const;
+    uint32_t heldCommands() const;
+    uint32_t droppedSkips() const;
+    uint32_t droppedPlays() const;
+    void printStats();
+
+    ConnectivityManager(NetworkLink& link);
+};
+
+#endif
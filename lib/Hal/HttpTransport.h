@@ -0,0 +1,46 @@
+#ifndef HTTPTRANSPORT_H
+#define HTTPTRANSPORT_H
+
+#include <Arduino.h>
+
+// Lo que la logica de red necesita de una conexion HTTP contra un host de spotify.
+// En el ESP32 lo implementa SpotifyClient (HTTPS persistente); en env:native, el mock de spotify.
+class HttpTransport {
+
+  public:
+    // Header "Authorization" que se agrega a cada peticion (vacio para no mandarlo)
+    virtual void setAuthorization(const String& value) = 0;
+
+    // El proximo GET manda If-None-Match con este validador; vale para una sola peticion (nullptr o "" para no mandarlo)
+    virtual void setIfNoneMatch(const char* etag) = 0;
+
+    virtual int GET(const char* path) = 0;
+    virtual int PUT(const char* path, const String& body = "", const char* contentType = nullptr) = 0;
+    virtual int POST(const char* path, const String& body = "", const char* contentType = nullptr) = 0;
+
+    // Cuerpo de la ultima respuesta
+    virtual String getString() = 0;
+    virtual Stream& getBodyStream() = 0;
+
+    // Largo del cuerpo segun Content-Length, -1 si no vino
+    virtual int getSize() = 0;
+
+    // Copia el header ETag de la ultima respuesta en out ("" si no vino). Devuelve false si no entra
+    virtual bool etag(char* out, size_t size) = 0;
+
+    // Segundos del header Retry-After de la ultima respuesta (429), 0 si no vino
+    virtual uint32_t retryAfter() = 0;
+
+    // Libera la peticion actual dejando la conexion abierta para la siguiente
+    virtual void end() = 0;
+
+    // Cierra la conexion; para cuando el cuerpo quedo a medio leer
+    virtual void abort() = 0;
+
+    virtual uint32_t requests() const = 0;
+    virtual void printStats() = 0;
+
+    virtual ~HttpTransport() {}
+};
+
+#endif
@@ -0,0 +1,26 @@
+#ifndef NETWORKLINK_H
+#define NETWORKLINK_H
+
+#include <Arduino.h>
+
+// El enlace de red que reconecta ConnectivityManager. En el ESP32 lo implementa WifiLink;
+// en env:native, un enlace simulado que se cae cuando lo dice el escenario.
+class NetworkLink {
+
+  public:
+    // Arranca un intento de conexion sin bloquear. attempt cuenta desde 0 en cada caida.
+    // Devuelve cuanto esperar a que este intento conecte antes de darlo por fallido
+    virtual uint32_t connect(uint32_t attempt) = 0;
+
+    virtual bool isUp() = 0;
+
+    // Corta el intento en curso o una conexion que quedo colgada
+    virtual void disconnect() = 0;
+
+    // Una vez por cada conexion lograda, para guardar lo que sirva para la proxima
+    virtual void onConnected() {}
+
+    virtual ~NetworkLink() {}
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef HALNATIVE_ARDUINO_H
+#define HALNATIVE_ARDUINO_H
+
+// Lo minimo de Arduino que usa la logica compartida (lib/) para compilar en Linux.
+// millis() sale de NativeClock: en tiempo real o en tiempo simulado para las pruebas de larga duracion.
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+
+#include "NativeClock.h"
+
+using std::min;
+using std::max;
+
+inline uint32_t millis() {
+    return NativeClock::millis();
+}
+
+inline uint32_t micros() {
+    return NativeClock::micros();
+}
+
+inline void delay(uint32_t ms) {
+    NativeClock::advance(ms);
+}
+
+inline void yield() {}
+
+// glibc recien la trae en 2.38
+#if defined(__GLIBC__) && (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38)
+#define HALNATIVE_STRLCPY
+size_t strlcpy(char* dst, const char* src, size_t size);
+#endif
+
+// En el ESP32 la hora sale de NTP; en Linux el reloj ya esta en hora
+inline bool getLocalTime(struct tm* info, uint32_t ms = 5000) {
+    time_t now = time(nullptr);
+    localtime_r(&now, info);
+    return true;
+}
+
+inline void configTime(long gmtOffset, int daylightOffset, const char* server) {}
+
+class String {
+
+  private:
+    std::string value;
+
+  public:
+    String() {}
+    String(const char* text) : value(text ? text : "") {}
+    String(const std::string& text) : value(text) {}
+    String(char c) : value(1, c) {}
+    String(int number) : value(std::to_string(number)) {}
+    String(unsigned int number) : value(std::to_string(number)) {}
+    String(long number) : value(std::to_string(number)) {}
+    String(unsigned long number) : value(std::to_string(number)) {}
+
+    unsigned int length() const { return value.length(); }
+    const char* c_str() const { return value.c_str(); }
+    bool reserve(unsigned int size) { value.reserve(size); return true; }
+    long toInt() const { return strtol(value.c_str(), nullptr, 10); }
+    bool equalsIgnoreCase(const String& other) const { return strcasecmp(value.c_str(), other.c_str()) == 0; }
+    bool startsWith(const String& prefix) const { return value.compare(0, prefix.value.size(), prefix.value) == 0; }
+
+    String& operator+=(const String& other) { value += other.value; return *this; }
+    String& operator+=(const char* other) { value += other; return *this; }
+    String& operator+=(char c) { value += c; return *this; }
+
+    bool operator==(const String& other) const { return value == other.value; }
+    bool operator==(const char* other) const { return value == other; }
+    bool operator!=(const String& other) const { return value != other.value; }
+    bool operator!=(const char* other) const { return value != other; }
+
+    friend String operator+(const String& a, const String& b) { return String(a.value + b.value); }
+    friend String operator+(const char* a, const String& b) { return String(a + b.value); }
+    friend String operator+(const String& a, const char* b) { return String(a.value + b); }
+};
+
+class Print {
+
+  public:
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size);
+
+    size_t print(const char* text);
+    size_t print(const String& text);
+    size_t println(const char* text = "");
+    size_t println(const String& text);
+    size_t println(int number);
+    size_t printf(const char* format, ...) __attribute__((format(printf, 2, 3)));
+
+    virtual ~Print() {}
+};
+
+class Stream : public Print {
+
+  public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    // Sin timeout: en Linux todos los streams son de memoria o de archivo
+    size_t readBytes(uint8_t* buffer, size_t length);
+    size_t readBytes(char* buffer, size_t length);
+    void setTimeout(unsigned long timeout) {}
+};
+
+// Serial va a stdout. En las corridas aceleradas se silencia para no escribir millones de lineas
+class NativeSerial : public Stream {
+
+  public:
+    bool quiet = false;
+
+    void begin(unsigned long baud) {}
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+};
+
+extern NativeSerial Serial;
+
+#endif
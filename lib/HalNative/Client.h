@@ -0,0 +1,40 @@
+#ifndef HALNATIVE_CLIENT_H
+#define HALNATIVE_CLIENT_H
+
+#include <Arduino.h>
+
+// Lo que usa la logica compartida de un Client de Arduino (WiFiClient en el ESP32)
+class Client : public Stream {
+
+  public:
+    virtual int connect(const char* host, uint16_t port) = 0;
+    virtual uint8_t connected() = 0;
+    virtual void stop() = 0;
+    using Print::write;
+};
+
+// Client sobre un socket TCP de Linux, no bloqueante despues de conectar
+class NativeTcpClient : public Client {
+
+  private:
+    int fd;
+    int peeked;
+
+    bool fill();
+
+  public:
+    int connect(const char* host, uint16_t port) override;
+    uint8_t connected() override;
+    void stop() override;
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+
+    NativeTcpClient();
+    ~NativeTcpClient();
+};
+
+#endif
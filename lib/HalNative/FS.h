@@ -0,0 +1,55 @@
+#ifndef HALNATIVE_FS_H
+#define HALNATIVE_FS_H
+
+#include <Arduino.h>
+#include <memory>
+
+namespace fs {
+
+// Archivo del host con la interfaz de fs::File del core de ESP32
+class File : public Stream {
+
+  private:
+    std::shared_ptr<FILE> file;
+    std::string path;
+
+  public:
+    File() {}
+    File(FILE* f, const std::string& path);
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t read(uint8_t* buffer, size_t size);
+
+    bool seek(uint32_t position);
+    size_t position() const;
+    size_t size() const;
+    void close();
+    const char* name() const;
+
+    operator bool() const;
+};
+
+// SPIFFS sobre un directorio del host. Las rutas "/art/xxx" quedan en <root>/art/xxx
+class FS {
+
+  private:
+    std::string root;
+
+    std::string hostPath(const char* path) const;
+
+  public:
+    File open(const char* path, const char* mode = "r");
+    bool exists(const char* path);
+    bool remove(const char* path);
+    bool rename(const char* from, const char* to);
+
+    explicit FS(const char* root);
+};
+
+}
+
+#endif
@@ -0,0 +1,392 @@
+#include <Arduino.h>
+#include <Client.h>
+#include <Preferences.h>
+#include <FS.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <stdarg.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <chrono>
+#include <string>
+#include <thread>
+
+//========= Reloj =========
+
+static bool clockSimulated = false;
+static uint64_t simulatedUs = 0;
+
+static uint64_t realMicros() {
+    static const auto start = std::chrono::steady_clock::now();
+    return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count();
+}
+
+void NativeClock::setSimulated(bool simulated) {
+    clockSimulated = simulated;
+}
+
+bool NativeClock::simulated() {
+    return clockSimulated;
+}
+
+uint64_t NativeClock::elapsedMs() {
+    return (clockSimulated ? simulatedUs : realMicros()) / 1000;
+}
+
+uint32_t NativeClock::millis() {
+    return (uint32_t)elapsedMs();
+}
+
+uint32_t NativeClock::micros() {
+    return (uint32_t)(clockSimulated ? simulatedUs : realMicros());
+}
+
+void NativeClock::advance(uint32_t ms) {
+    if (clockSimulated)
+        simulatedUs += (uint64_t)ms * 1000;
+    else
+        std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+//========= Texto =========
+
+#ifdef HALNATIVE_STRLCPY
+size_t strlcpy(char* dst, const char* src, size_t size) {
+    size_t len = strlen(src);
+    if (size > 0) {
+        size_t n = len < size - 1 ? len : size - 1;
+        memcpy(dst, src, n);
+        dst[n] = '\0';
+    }
+    return len;
+}
+#endif
+
+size_t Print::write(const uint8_t* buffer, size_t size) {
+    size_t n = 0;
+    while (n < size && write(buffer[n]))
+        n++;
+    return n;
+}
+
+size_t Print::print(const char* text) {
+    return write((const uint8_t*)text, strlen(text));
+}
+
+size_t Print::print(const String& text) {
+    return print(text.c_str());
+}
+
+size_t Print::println(const char* text) {
+    return print(text) + print("\n");
+}
+
+size_t Print::println(const String& text) {
+    return println(text.c_str());
+}
+
+size_t Print::println(int number) {
+    return println(String(number));
+}
+
+size_t Print::printf(const char* format, ...) {
+    char buffer[256];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buffer, sizeof(buffer), format, args);
+    va_end(args);
+    if (len < 0)
+        return 0;
+    if ((size_t)len < sizeof(buffer))
+        return write((const uint8_t*)buffer, len);
+
+    std::string large(len + 1, '\0');
+    va_start(args, format);
+    vsnprintf(&large[0], large.size(), format, args);
+    va_end(args);
+    return write((const uint8_t*)large.data(), len);
+}
+
+size_t Stream::readBytes(uint8_t* buffer, size_t length) {
+    size_t n = 0;
+    while (n < length) {
+        int c = read();
+        if (c < 0)
+            break;
+        buffer[n++] = (uint8_t)c;
+    }
+    return n;
+}
+
+size_t Stream::readBytes(char* buffer, size_t length) {
+    return readBytes((uint8_t*)buffer, length);
+}
+
+NativeSerial Serial;
+
+size_t NativeSerial::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t NativeSerial::write(const uint8_t* buffer, size_t size) {
+    if (quiet)
+        return size;
+    return fwrite(buffer, 1, size, stdout);
+}
+
+//========= Preferences =========
+
+bool Preferences::clear() {
+    strings.clear();
+    numbers.clear();
+    return true;
+}
+
+bool Preferences::remove(const char* key) {
+    return strings.erase(key) + numbers.erase(key) > 0;
+}
+
+bool Preferences::isKey(const char* key) {
+    return strings.count(key) > 0 || numbers.count(key) > 0;
+}
+
+size_t Preferences::putString(const char* key, const String& value) {
+    strings[key] = value.c_str();
+    return value.length();
+}
+
+String Preferences::getString(const char* key, const String& defaultValue) {
+    auto it = strings.find(key);
+    return it == strings.end() ? defaultValue : String(it->second);
+}
+
+size_t Preferences::putULong64(const char* key, uint64_t value) {
+    numbers[key] = value;
+    return sizeof(value);
+}
+
+uint64_t Preferences::getULong64(const char* key, uint64_t defaultValue) {
+    auto it = numbers.find(key);
+    return it == numbers.end() ? defaultValue : it->second;
+}
+
+size_t Preferences::putUInt(const char* key, uint32_t value) {
+    numbers[key] = value;
+    return sizeof(value);
+}
+
+uint32_t Preferences::getUInt(const char* key, uint32_t defaultValue) {
+    auto it = numbers.find(key);
+    return it == numbers.end() ? defaultValue : (uint32_t)it->second;
+}
+
+//========= FS =========
+
+namespace fs {
+
+File::File(FILE* f, const std::string& path) : file(f, fclose), path(path) {}
+
+size_t File::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t File::write(const uint8_t* buffer, size_t size) {
+    return file ? fwrite(buffer, 1, size, file.get()) : 0;
+}
+
+int File::available() {
+    return file ? (int)(size() - position()) : 0;
+}
+
+int File::read() {
+    return file ? fgetc(file.get()) : -1;
+}
+
+int File::peek() {
+    if (!file)
+        return -1;
+    int c = fgetc(file.get());
+    if (c >= 0)
+        ungetc(c, file.get());
+    return c;
+}
+
+size_t File::read(uint8_t* buffer, size_t size) {
+    return file ? fread(buffer, 1, size, file.get()) : 0;
+}
+
+bool File::seek(uint32_t position) {
+    return file && fseek(file.get(), position, SEEK_SET) == 0;
+}
+
+size_t File::position() const {
+    return file ? ftell(file.get()) : 0;
+}
+
+size_t File::size() const {
+    if (!file)
+        return 0;
+    long current = ftell(file.get());
+    fseek(file.get(), 0, SEEK_END);
+    long end = ftell(file.get());
+    fseek(file.get(), current, SEEK_SET);
+    return end;
+}
+
+void File::close() {
+    file.reset();
+}
+
+const char* File::name() const {
+    return path.c_str();
+}
+
+File::operator bool() const {
+    return (bool)file;
+}
+
+std::string FS::hostPath(const char* path) const {
+    return root + path;
+}
+
+File FS::open(const char* path, const char* mode) {
+    std::string host = hostPath(path);
+
+    // SPIFFS no tiene directorios: se crean a medida que hacen falta
+    if (mode[0] != 'r') {
+        for (size_t slash = host.find('/', root.size() + 1); slash != std::string::npos; slash = host.find('/', slash + 1))
+            mkdir(host.substr(0, slash).c_str(), 0755);
+    }
+
+    std::string hostMode = std::string(mode) + "b";
+    FILE* f = fopen(host.c_str(), hostMode.c_str());
+    return f ? File(f, path) : File();
+}
+
+bool FS::exists(const char* path) {
+    struct stat info;
+    return stat(hostPath(path).c_str(), &info) == 0;
+}
+
+bool FS::remove(const char* path) {
+    return ::remove(hostPath(path).c_str()) == 0;
+}
+
+bool FS::rename(const char* from, const char* to) {
+    return ::rename(hostPath(from).c_str(), hostPath(to).c_str()) == 0;
+}
+
+FS::FS(const char* root) : root(root) {
+    mkdir(root, 0755);
+}
+
+}
+
+//========= Client =========
+
+int NativeTcpClient::connect(const char* host, uint16_t port) {
+    stop();
+
+    struct addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result;
+    char service[8];
+    snprintf(service, sizeof(service), "%u", port);
+    if (getaddrinfo(host, service, &hints, &result) != 0)
+        return 0;
+
+    fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+    if (fd >= 0 && ::connect(fd, result->ai_addr, result->ai_addrlen) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    freeaddrinfo(result);
+    if (fd < 0)
+        return 0;
+
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return 1;
+}
+
+uint8_t NativeTcpClient::connected() {
+    // Un read de 0 bytes en fill() cierra el socket
+    fill();
+    return fd >= 0 || peeked >= 0;
+}
+
+void NativeTcpClient::stop() {
+    if (fd >= 0)
+        close(fd);
+    fd = -1;
+    peeked = -1;
+}
+
+// Trae un byte si hay; false si no hay nada para leer todavia
+bool NativeTcpClient::fill() {
+    if (peeked >= 0)
+        return true;
+    if (fd < 0)
+        return false;
+    uint8_t c;
+    ssize_t n = recv(fd, &c, 1, 0);
+    if (n == 1) {
+        peeked = c;
+        return true;
+    }
+    if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK)) {
+        close(fd);
+        fd = -1;
+    }
+    return false;
+}
+
+size_t NativeTcpClient::write(uint8_t c) {
+    return write(&c, 1);
+}
+
+size_t NativeTcpClient::write(const uint8_t* buffer, size_t size) {
+    size_t sent = 0;
+    while (fd >= 0 && sent < size) {
+        ssize_t n = send(fd, buffer + sent, size - sent, MSG_NOSIGNAL);
+        if (n > 0)
+            sent += n;
+        else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        else
+            stop();
+    }
+    return sent;
+}
+
+int NativeTcpClient::available() {
+    return fill() ? 1 : 0;
+}
+
+int NativeTcpClient::read() {
+    if (!fill())
+        return -1;
+    int c = peeked;
+    peeked = -1;
+    return c;
+}
+
+int NativeTcpClient::peek() {
+    return fill() ? peeked : -1;
+}
+
+NativeTcpClient::NativeTcpClient() {
+    fd = -1;
+    peeked = -1;
+}
+
+NativeTcpClient::~NativeTcpClient() {
+    stop();
+}
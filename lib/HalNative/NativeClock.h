@@ -0,0 +1,21 @@
+#ifndef NATIVECLOCK_H
+#define NATIVECLOCK_H
+
+#include <stdint.h>
+
+// Reloj de env:native. En tiempo real millis() sigue al reloj monotono y advance() duerme;
+// en tiempo simulado advance() solo mueve el reloj, asi una semana corre en segundos.
+class NativeClock {
+
+  public:
+    static void setSimulated(bool simulated);
+    static bool simulated();
+
+    static uint32_t millis();
+    static uint32_t micros();
+    static uint64_t elapsedMs();
+
+    static void advance(uint32_t ms);
+};
+
+#endif
@@ -0,0 +1,31 @@
+#ifndef HALNATIVE_PREFERENCES_H
+#define HALNATIVE_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+
+// Preferences (NVS) en memoria: dura lo que dura el proceso, como una placa recien borrada
+class Preferences {
+
+  private:
+    std::map<std::string, std::string> strings;
+    std::map<std::string, uint64_t> numbers;
+
+  public:
+    bool begin(const char* name, bool readOnly = false) { return true; }
+    void end() {}
+    bool clear();
+    bool remove(const char* key);
+    bool isKey(const char* key);
+
+    size_t putString(const char* key, const String& value);
+    String getString(const char* key, const String& defaultValue = String());
+
+    size_t putULong64(const char* key, uint64_t value);
+    uint64_t getULong64(const char* key, uint64_t defaultValue = 0);
+
+    size_t putUInt(const char* key, uint32_t value);
+    uint32_t getUInt(const char* key, uint32_t defaultValue = 0);
+};
+
+#endif
@@ -0,0 +1,23 @@
+#ifndef HALNATIVE_FREERTOS_H
+#define HALNATIVE_FREERTOS_H
+
+#include <stdint.h>
+#include <mutex>
+
+// Lo poco de FreeRTOS que usa lib/: en env:native casi todo corre en un solo hilo
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY ((TickType_t)0xffffffffUL)
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+// El modo navegador corre la red en otro hilo: la seccion critica es un mutex de verdad
+typedef std::mutex portMUX_TYPE;
+#define portMUX_INITIALIZE(mux) ((void)(mux))
+#define portENTER_CRITICAL(mux) (mux)->lock()
+#define portEXIT_CRITICAL(mux) (mux)->unlock()
+
+#endif
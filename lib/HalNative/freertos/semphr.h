@@ -0,0 +1,28 @@
+#ifndef HALNATIVE_SEMPHR_H
+#define HALNATIVE_SEMPHR_H
+
+#include <chrono>
+#include <mutex>
+
+#include "FreeRTOS.h"
+
+typedef std::timed_mutex* SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex() {
+    return new std::timed_mutex();
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t mutex, TickType_t ticks) {
+    if (ticks == portMAX_DELAY) {
+        mutex->lock();
+        return pdTRUE;
+    }
+    return mutex->try_lock_for(std::chrono::milliseconds(ticks)) ? pdTRUE : pdFALSE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t mutex) {
+    mutex->unlock();
+    return pdTRUE;
+}
+
+#endif
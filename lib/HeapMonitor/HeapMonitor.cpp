@@ -0,0 +1,51 @@
+#include "HeapMonitor.h"
+
+#include <esp_heap_caps.h>
+
+void HeapMonitor::setBaseline() {
+    baselineFree = freeHeap();
+    baselineLargest = largestFreeBlock();
+    minLargest = baselineLargest;
+    baselineTaken = true;
+}
+
+void HeapMonitor::sample() {
+    uint32_t largest = largestFreeBlock();
+    if (largest < minLargest)
+        minLargest = largest;
+    samples++;
+}
+
+uint32_t HeapMonitor::freeHeap() const {
+    return heap_caps_get_free_size(MALLOC_CAP_8BIT);
+}
+
+uint32_t HeapMonitor::minFreeHeap() const {
+    return heap_caps_get_minimum_free_size(MALLOC_CAP_8BIT);
+}
+
+uint32_t HeapMonitor::largestFreeBlock() const {
+    return heap_caps_get_largest_free_block(MALLOC_CAP_8BIT);
+}
+
+uint32_t HeapMonitor::minLargestFreeBlock() const {
+    return minLargest;
+}
+
+void HeapMonitor::printStats() {
+    uint32_t free = freeHeap();
+    uint32_t largest = largestFreeBlock();
+    Serial.printf("Heap: libre %u (minimo %u), bloque mas grande %u (minimo %u), %u muestras\n",
+                  free, minFreeHeap(), largest, minLargest, samples);
+    if (baselineTaken)
+        Serial.printf("Heap desde el arranque: libre %+d, bloque mas grande %+d\n",
+                      (int)(free - baselineFree), (int)(largest - baselineLargest));
+}
+
+HeapMonitor::HeapMonitor() {
+    baselineFree = 0;
+    baselineLargest = 0;
+    minLargest = UINT32_MAX;
+    samples = 0;
+    baselineTaken = false;
+}
@@ -0,0 +1,33 @@
+#ifndef HEAPMONITOR_H
+#define HEAPMONITOR_H
+
+#include <Arduino.h>
+
+// Sigue el heap interno a lo largo de dias: heap libre, minimo historico y el bloque libre mas grande.
+// Si el bloque mas grande se achica mientras el heap libre se mantiene, el heap se esta fragmentando.
+class HeapMonitor {
+
+  private:
+    uint32_t baselineFree;
+    uint32_t baselineLargest;
+    uint32_t minLargest;
+    uint32_t samples;
+    bool baselineTaken;
+
+  public:
+    // Se toma como referencia el estado despues del arranque, cuando ya estan todos los buffers reservados
+    void setBaseline();
+
+    // Muestra periodica, barata: se puede llamar en cada consulta
+    void sample();
+
+    uint32_t freeHeap() const;
+    uint32_t minFreeHeap() const;
+    uint32_t largestFreeBlock() const;
+    uint32_t minLargestFreeBlock() const;
+    void printStats();
+
+    HeapMonitor();
+};
+
+#endif
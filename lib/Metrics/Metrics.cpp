@@ -0,0 +1,162 @@
+#include "Metrics.h"
+
+Metrics metrics;
+
+//========= Histograma =========
+
+// Balde i >= 2: exponente e = i / 2, mitad inferior o superior de [2^e, 2^(e+1))
+static uint8_t bucketFor(uint32_t us) {
+    if (us < 2)
+        return us;
+    uint8_t e = 31 - __builtin_clz(us);
+    uint8_t bucket = e * 2 + ((us >> (e - 1)) & 1);
+    return bucket < LatencyHistogram::BUCKETS ? bucket : LatencyHistogram::BUCKETS - 1;
+}
+
+static uint32_t bucketLimit(uint8_t bucket) {
+    if (bucket < 2)
+        return bucket;
+    uint8_t e = bucket / 2;
+    return ((2 + (bucket & 1) + 1) << (e - 1)) - 1;
+}
+
+void LatencyHistogram::add(uint32_t us) {
+    buckets[bucketFor(us)]++;
+    count++;
+    totalUs += us;
+    if (us > maxUs)
+        maxUs = us;
+}
+
+uint32_t LatencyHistogram::percentile(float p) const {
+    if (count == 0)
+        return 0;
+    uint32_t rank = (uint32_t)(p * (count - 1)) + 1;
+    uint32_t seen = 0;
+    for (uint8_t i = 0; i < BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            uint32_t limit = bucketLimit(i);
+            return limit < maxUs ? limit : maxUs;
+        }
+    }
+    return maxUs;
+}
+
+void LatencyHistogram::reset() {
+    memset(buckets, 0, sizeof(buckets));
+    count = 0;
+    maxUs = 0;
+    totalUs = 0;
+}
+
+//========= Anotar =========
+
+void Metrics::record(MetricStage stage, uint32_t us) {
+    portENTER_CRITICAL(&lock);
+    stages[stage].add(us);
+    portEXIT_CRITICAL(&lock);
+}
+
+void Metrics::count(MetricCounter counter, uint32_t n) {
+    portENTER_CRITICAL(&lock);
+    counters[counter] += n;
+    portEXIT_CRITICAL(&lock);
+}
+
+const LatencyHistogram& Metrics::stage(MetricStage stage) const {
+    return stages[stage];
+}
+
+uint32_t Metrics::counter(MetricCounter counter) const {
+    return counters[counter];
+}
+
+void Metrics::reset() {
+    portENTER_CRITICAL(&lock);
+    for (uint8_t i = 0; i < STAGE_COUNT; i++)
+        stages[i].reset();
+    memset(counters, 0, sizeof(counters));
+    since = millis();
+    portEXIT_CRITICAL(&lock);
+}
+
+//========= Leer =========
+
+const char* Metrics::stageName(MetricStage stage) {
+    static const char* names[STAGE_COUNT] = {"dns", "tls", "http_wait", "json_parse", "art_download",
+                                             "art_decode", "art_redraw", "render", "flush", "frame"};
+    return stage < STAGE_COUNT ? names[stage] : "?";
+}
+
+const char* Metrics::counterName(MetricCounter counter) {
+    static const char* names[COUNTER_COUNT] = {"rate_limited", "not_modified", "unauthorized",
+                                               "token_refresh", "token_failure", "invalidated_px"};
+    return counter < COUNTER_COUNT ? names[counter] : "?";
+}
+
+void Metrics::printCompact(Print& out) {
+    out.printf("[metrics] %u s, us:\n", (millis() - since) / 1000);
+    for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+        const LatencyHistogram& h = stages[i];
+        if (h.count == 0)
+            continue;
+        out.printf("  %-12s n=%-6u p50=%-7u p95=%-7u p99=%-7u max=%u\n", stageName((MetricStage)i), h.count,
+                   h.percentile(0.50f), h.percentile(0.95f), h.percentile(0.99f), h.maxUs);
+    }
+    out.printf("  429=%u 304=%u 401=%u token=%u fallidos=%u\n", counters[COUNTER_RATE_LIMITED],
+               counters[COUNTER_NOT_MODIFIED], counters[COUNTER_UNAUTHORIZED],
+               counters[COUNTER_TOKEN_REFRESH], counters[COUNTER_TOKEN_FAILURE]);
+    uint32_t window = millis() - since;
+    if (window > 0)
+        out.printf("  invalidado %u px/s\n", (uint32_t)((uint64_t)counters[COUNTER_INVALIDATED_PIXELS] * 1000 / window));
+}
+
+void Metrics::printJson(Print& out) {
+    out.printf("{\"uptime_ms\":%u,\"window_ms\":%u,\"stages_us\":{", millis(), millis() - since);
+    for (uint8_t i = 0; i < STAGE_COUNT; i++) {
+        const LatencyHistogram& h = stages[i];
+        out.printf("%s\"%s\":{\"count\":%u,\"mean\":%u,\"p50\":%u,\"p95\":%u,\"p99\":%u,\"max\":%u}", i ? "," : "",
+                   stageName((MetricStage)i), h.count, h.count ? (uint32_t)(h.totalUs / h.count) : 0,
+                   h.percentile(0.50f), h.percentile(0.95f), h.percentile(0.99f), h.maxUs);
+    }
+    out.print("},\"counters\":{");
+    for (uint8_t i = 0; i < COUNTER_COUNT; i++)
+        out.printf("%s\"%s\":%u", i ? "," : "", counterName((MetricCounter)i), counters[i]);
+    out.println("}}");
+}
+
+void Metrics::runCommand(const char* command, Print& out) {
+    if (strcmp(command, "m") == 0)
+        printCompact(out);
+    else if (strcmp(command, "mj") == 0)
+        printJson(out);
+    else if (strcmp(command, "mr") == 0) {
+        reset();
+        out.println("[metrics] en cero");
+    }
+}
+
+void Metrics::serviceSerial(Stream& io) {
+    // Sin nadie del otro lado esto es un available() por vuelta
+    while (io.available() > 0) {
+        int c = io.read();
+        if (c == '\n' || c == '\r') {
+            line[lineLength] = '\0';
+            if (lineLength > 0)
+                runCommand(line, io);
+            lineLength = 0;
+        } else if (lineLength < sizeof(line) - 1) {
+            line[lineLength++] = (char)c;
+        }
+    }
+}
+
+Metrics::Metrics() {
+    portMUX_INITIALIZE(&lock);
+    for (uint8_t i = 0; i < STAGE_COUNT; i++)
+        stages[i].reset();
+    memset(counters, 0, sizeof(counters));
+    since = 0;
+    lineLength = 0;
+}
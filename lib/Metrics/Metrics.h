@@ -0,0 +1,88 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+
+// Etapas que se miden, en microsegundos
+enum MetricStage : uint8_t {
+    STAGE_DNS,           // Resolver el host antes de un handshake
+    STAGE_TLS,           // TCP + handshake TLS
+    STAGE_HTTP_WAIT,     // Desde que se manda la peticion hasta tener los headers de la respuesta
+    STAGE_JSON_PARSE,    // Parseo de currently-playing, leyendo el cuerpo del socket
+    STAGE_ART_DOWNLOAD,  // Descarga de una tapa (en streaming incluye decodificarla)
+    STAGE_ART_DECODE,    // Decodificar una tapa que ya esta en SPIFFS (tarea de red)
+    STAGE_ART_REDRAW,    // Redibujar desde SPIFFS la tapa que no entro en streaming (tarea de UI)
+    STAGE_RENDER,        // Un refresco de LVGL que dibujo algo, con sus flushes
+    STAGE_FLUSH,         // Un flush: swap de bytes, esperar el DMA anterior y arrancar el nuevo
+    STAGE_FRAME,         // Una llamada a lv_task_handler
+    STAGE_COUNT
+};
+
+enum MetricCounter : uint8_t {
+    COUNTER_RATE_LIMITED,        // Respuestas 429
+    COUNTER_NOT_MODIFIED,        // Consultas resueltas con 304, sin cuerpo
+    COUNTER_UNAUTHORIZED,        // Respuestas 401
+    COUNTER_TOKEN_REFRESH,       // Tokens renovados
+    COUNTER_TOKEN_FAILURE,       // Renovaciones fallidas
+    COUNTER_INVALIDATED_PIXELS,  // Pixeles que LVGL marco para redibujar (por segundo: dividir por window_ms)
+    COUNTER_COUNT
+};
+
+// Histograma de memoria fija con dos baldes por potencia de dos (error maximo ~33%), hasta ~16 s.
+// Los percentiles devuelven el limite superior del balde
+struct LatencyHistogram {
+    static constexpr uint8_t BUCKETS = 48;
+
+    uint32_t buckets[BUCKETS];
+    uint32_t count;
+    uint32_t maxUs;
+    uint64_t totalUs;
+
+    void add(uint32_t us);
+    uint32_t percentile(float p) const;
+    void reset();
+};
+
+// Mediciones de todo el firmware. Anotan la tarea de red y la de UI, y "mr" pone a cero desde la UI
+// mientras la red sigue anotando: anotar y poner a cero van en una seccion critica de unas pocas sumas,
+// asi que se deja siempre prendido. Quien imprime no la toma y acepta ver una muestra a medio sumar.
+// Se leen por el puerto serie: "m" resumen, "mj" JSON, "mr" vuelve a cero
+class Metrics {
+
+  private:
+    LatencyHistogram stages[STAGE_COUNT];
+    uint32_t counters[COUNTER_COUNT];
+    uint32_t since;
+    portMUX_TYPE lock;
+
+    char line[8];
+    uint8_t lineLength;
+
+    void runCommand(const char* command, Print& out);
+
+  public:
+    void record(MetricStage stage, uint32_t us);
+    void count(MetricCounter counter, uint32_t n = 1);
+
+    const LatencyHistogram& stage(MetricStage stage) const;
+    uint32_t counter(MetricCounter counter) const;
+
+    // Una linea por etapa con muestras, p50/p95/p99/max y los contadores
+    void printCompact(Print& out);
+    // Un objeto JSON en una sola linea, para levantarlo desde la PC
+    void printJson(Print& out);
+    void reset();
+
+    // Lee lo que haya en io sin bloquear y responde cuando llega una linea completa
+    void serviceSerial(Stream& io);
+
+    static const char* stageName(MetricStage stage);
+    static const char* counterName(MetricCounter counter);
+
+    Metrics();
+};
+
+extern Metrics metrics;
+
+#endif
@@ -0,0 +1,332 @@
+#include "PlaybackState.h"
+
+#include <ArduinoJson.h>
+
+//========= Allocator =========
+
+// Memoria fija para el JsonDocument de cada consulta: el camino de 5 s no toca el heap.
+// Solo la usa la tarea de red, de a una peticion por vez.
+#ifndef JSON_ARENA_SIZE
+#define JSON_ARENA_SIZE 4096
+#endif
+
+static uint8_t jsonArena[JSON_ARENA_SIZE] __attribute__((aligned(8)));
+
+// Asignador de pila sobre jsonArena. Solo el ultimo bloque se puede liberar o agrandar en el lugar
+// (ArduinoJson hace justamente eso al armar strings y al achicar el pool); lo demas se recupera
+// entero con reset() en la proxima peticion. Si el arena no alcanza se cae a malloc y se cuenta.
+// Cada bloque guarda su tamaño al principio porque reallocate() no lo recibe.
+class ArenaAllocator : public ArduinoJson::Allocator {
+
+  private:
+    size_t top = 0;
+    size_t last = SIZE_MAX;  // Offset del encabezado del ultimo bloque
+    size_t peak = 0;
+    uint32_t fallbacks = 0;
+
+    static size_t align(size_t size) {
+        return (size + 7) & ~(size_t)7;
+    }
+
+    static const size_t HEADER = 8;
+
+    bool inArena(void* ptr) const {
+        return (uint8_t*)ptr >= jsonArena && (uint8_t*)ptr < jsonArena + JSON_ARENA_SIZE;
+    }
+
+    size_t& sizeOf(void* ptr) {
+        return *(size_t*)((uint8_t*)ptr - HEADER);
+    }
+
+  public:
+    void reset() {
+        top = 0;
+        last = SIZE_MAX;
+        peak = 0;
+    }
+
+    void* allocate(size_t size) override {
+        size_t needed = HEADER + align(size);
+        if (top + needed > JSON_ARENA_SIZE) {
+            fallbacks++;
+            return malloc(size);
+        }
+        last = top;
+        top += needed;
+        if (top > peak)
+            peak = top;
+        void* ptr = jsonArena + last + HEADER;
+        sizeOf(ptr) = size;
+        return ptr;
+    }
+
+    void deallocate(void* ptr) override {
+        if (!ptr)
+            return;
+        if (!inArena(ptr)) {
+            free(ptr);
+            return;
+        }
+        if ((uint8_t*)ptr - HEADER == jsonArena + last) {
+            top = last;
+            last = SIZE_MAX;
+        }
+    }
+
+    void* reallocate(void* ptr, size_t new_size) override {
+        if (!ptr)
+            return allocate(new_size);
+        if (!inArena(ptr))
+            return realloc(ptr, new_size);
+
+        // El ultimo bloque crece o se achica sin moverse
+        if ((uint8_t*)ptr - HEADER == jsonArena + last && last + HEADER + align(new_size) <= JSON_ARENA_SIZE) {
+            top = last + HEADER + align(new_size);
+            if (top > peak)
+                peak = top;
+            sizeOf(ptr) = new_size;
+            return ptr;
+        }
+
+        size_t old_size = sizeOf(ptr);
+        void* moved = allocate(new_size);
+        if (!moved)
+            return nullptr;
+        memcpy(moved, ptr, old_size < new_size ? old_size : new_size);
+        deallocate(ptr);
+        return moved;
+    }
+
+    size_t peakBytes() const {
+        return peak;
+    }
+
+    uint32_t fallbackCount() const {
+        return fallbacks;
+    }
+};
+
+static ArenaAllocator arenaAllocator;
+
+//========= Helpers =========
+
+// Copia src en dst sin cortar un caracter UTF-8 a la mitad
+static void copyText(char* dst, size_t size, const char* src) {
+    if (src == nullptr) {
+        dst[0] = '\0';
+        return;
+    }
+
+    size_t len = strlen(src);
+    if (len >= size) {
+        len = size - 1;
+        // Retrocede mientras el primer byte que queda afuera sea continuacion (10xxxxxx)
+        while (len > 0 && ((uint8_t)src[len] & 0xC0) == 0x80)
+            len--;
+    }
+
+    memcpy(dst, src, len);
+    dst[len] = '\0';
+}
+
+static JsonDocument& currentlyPlayingFilter() {
+    // Se arma una sola vez, el resto de las peticiones lo reutilizan
+    static JsonDocument filter;
+    if (filter.isNull()) {
+        filter["is_playing"] = true;
+        filter["progress_ms"] = true;
+        filter["item"]["id"] = true;
+        filter["item"]["name"] = true;
+        filter["item"]["duration_ms"] = true;
+        filter["item"]["artists"][0]["name"] = true;
+        filter["item"]["album"]["images"][0]["url"] = true;
+        filter["item"]["album"]["images"][0]["width"] = true;
+        filter["device"]["volume_percent"] = true;
+    }
+    return filter;
+}
+
+// La imagen mas chica que todavia cubre target; si ninguna alcanza, la mas grande.
+static const char* chooseImage(JsonArray images, uint16_t* width = nullptr, uint16_t target = ART_TARGET_SIZE) {
+    const char* best = nullptr;
+    uint16_t bestWidth = 0;
+    const char* largest = nullptr;
+    uint16_t largestWidth = 0;
+
+    for (JsonObject image : images) {
+        const char* url = image["url"];
+        uint16_t w = image["width"] | 0;
+        if (url == nullptr)
+            continue;
+        if (largest == nullptr || w > largestWidth) {
+            largest = url;
+            largestWidth = w;
+        }
+        if (w >= target && (best == nullptr || w < bestWidth)) {
+            best = url;
+            bestWidth = w;
+        }
+    }
+
+    if (best == nullptr) {
+        best = largest;
+        bestWidth = largestWidth;
+    }
+    if (width != nullptr)
+        *width = bestWidth;
+    return best;
+}
+
+static JsonDocument& queueFilter() {
+    static JsonDocument filter;
+    if (filter.isNull()) {
+        filter["queue"][0]["album"]["images"][0]["url"] = true;
+        filter["queue"][0]["album"]["images"][0]["width"] = true;
+    }
+    return filter;
+}
+
+// De cada tema solo lo que muestra una fila del navegador. En una playlist viene dentro de "track"
+static JsonDocument& browserFilter(BrowserSource source) {
+    static JsonDocument filters[3];
+    JsonDocument& filter = filters[source];
+    if (!filter.isNull())
+        return filter;
+
+    if (source == BROWSE_QUEUE) {
+        filter["queue"][0]["id"] = true;
+        filter["queue"][0]["name"] = true;
+        filter["queue"][0]["artists"][0]["name"] = true;
+        filter["queue"][0]["album"]["images"][0]["url"] = true;
+        filter["queue"][0]["album"]["images"][0]["width"] = true;
+    } else if (source == BROWSE_PLAYLISTS) {
+        filter["total"] = true;
+        filter["items"][0]["id"] = true;
+        filter["items"][0]["name"] = true;
+        filter["items"][0]["images"][0]["url"] = true;
+        filter["items"][0]["images"][0]["width"] = true;
+        filter["items"][0]["tracks"]["total"] = true;
+    } else {
+        filter["total"] = true;
+        filter["items"][0]["track"]["id"] = true;
+        filter["items"][0]["track"]["name"] = true;
+        filter["items"][0]["track"]["artists"][0]["name"] = true;
+        filter["items"][0]["track"]["album"]["images"][0]["url"] = true;
+        filter["items"][0]["track"]["album"]["images"][0]["width"] = true;
+    }
+    return filter;
+}
+
+// Una URL cortada no sirve: si no entra, la fila queda sin miniatura
+static void copyUrl(char* dst, size_t size, const char* src) {
+    if (src == nullptr || strlen(src) >= size)
+        dst[0] = '\0';
+    else
+        strcpy(dst, src);
+}
+
+//========= Parser =========
+
+bool parseCurrentlyPlaying(Stream& input, PlaybackState& state, size_t* peakBytes) {
+    bool ok;
+    arenaAllocator.reset();
+
+    {
+        JsonDocument doc(&arenaAllocator);
+        DeserializationError error = deserializeJson(doc, input, DeserializationOption::Filter(currentlyPlayingFilter()));
+
+        if (error) {
+            Serial.printf("Error al parsear el JSON: %s\n", error.c_str());
+            ok = false;
+        } else {
+            JsonObject item = doc["item"];
+
+            uint16_t imageWidth = 0;
+            const char* imageUrl = chooseImage(item["album"]["images"], &imageWidth);
+
+            copyText(state.id, sizeof(state.id), item["id"]);
+            copyText(state.name, sizeof(state.name), item["name"]);
+            copyText(state.artist, sizeof(state.artist), item["artists"][0]["name"]);
+            copyText(state.imageUrl, sizeof(state.imageUrl), imageUrl);
+            state.imageWidth = imageWidth;
+            state.progressMs = doc["progress_ms"] | 0;
+            state.durationMs = item["duration_ms"] | 1;
+            state.isPlaying = doc["is_playing"] | false;
+            state.volumePercent = doc["device"]["volume_percent"] | -1;
+            ok = true;
+        }
+    }
+
+    if (peakBytes != nullptr)
+        *peakBytes = arenaAllocator.peakBytes();
+
+    return ok;
+}
+
+uint32_t jsonArenaFallbacks() {
+    return arenaAllocator.fallbackCount();
+}
+
+bool parseQueueArt(Stream& input, QueueArt& art) {
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, input, DeserializationOption::Filter(queueFilter()));
+
+    art.count = 0;
+    if (error) {
+        Serial.printf("Error al parsear la cola: %s\n", error.c_str());
+        return false;
+    }
+
+    for (JsonObject item : doc["queue"].as<JsonArray>()) {
+        if (art.count == QUEUE_ART_MAX)
+            break;
+        // Los episodios no traen album, se saltean
+        const char* url = chooseImage(item["album"]["images"]);
+        if (url == nullptr)
+            continue;
+        copyText(art.urls[art.count], sizeof(art.urls[art.count]), url);
+        art.count++;
+    }
+    return true;
+}
+
+bool parseBrowserPage(Stream& input, BrowserSource source, BrowserPage& page) {
+    // Una pagina por scroll, no el camino de cada consulta: usa el heap como la cola
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, input, DeserializationOption::Filter(browserFilter(source)));
+
+    page.count = 0;
+    page.total = 0;
+    if (error) {
+        Serial.printf("Error al parsear la pagina: %s\n", error.c_str());
+        return false;
+    }
+
+    JsonArray items = doc[source == BROWSE_QUEUE ? "queue" : "items"];
+    for (JsonObject entry : items) {
+        if (page.count == BROWSER_PAGE_SIZE)
+            break;
+        BrowserItem& item = page.items[page.count];
+
+        if (source == BROWSE_PLAYLISTS) {
+            copyText(item.id, sizeof(item.id), entry["id"]);
+            copyText(item.title, sizeof(item.title), entry["name"]);
+            snprintf(item.subtitle, sizeof(item.subtitle), "%u temas", entry["tracks"]["total"] | 0u);
+            copyUrl(item.thumbUrl, sizeof(item.thumbUrl), chooseImage(entry["images"], &item.thumbWidth, THUMB_TARGET_SIZE));
+        } else {
+            // En una playlist cada fila envuelve al tema; un tema borrado llega como null y se muestra vacio
+            JsonObject track = source == BROWSE_QUEUE ? entry : entry["track"];
+            copyText(item.id, sizeof(item.id), track["id"]);
+            copyText(item.title, sizeof(item.title), track["name"]);
+            copyText(item.subtitle, sizeof(item.subtitle), track["artists"][0]["name"]);
+            copyUrl(item.thumbUrl, sizeof(item.thumbUrl), chooseImage(track["album"]["images"], &item.thumbWidth, THUMB_TARGET_SIZE));
+        }
+        if (item.thumbWidth == 0 || item.thumbWidth > THUMB_MAX_WIDTH)
+            item.thumbUrl[0] = '\0';
+        page.count++;
+    }
+
+    // La cola no dice el total: es lo que vino
+    page.total = source == BROWSE_QUEUE ? page.count : doc["total"] | 0u;
+    return true;
+}
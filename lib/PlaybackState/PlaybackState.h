@@ -0,0 +1,101 @@
+#ifndef PLAYBACKSTATE_H
+#define PLAYBACKSTATE_H
+
+#include <Arduino.h>
+
+// Lado de la tapa en pantalla. Se elige la imagen mas chica de spotify que lo cubra
+#ifndef ART_TARGET_SIZE
+#define ART_TARGET_SIZE 150
+#endif
+
+// Lo unico que la pantalla necesita de /v1/me/player/currently-playing.
+// Buffers fijos: los textos largos se recortan respetando UTF-8.
+struct PlaybackState {
+    char id[32];
+    char name[128];
+    char artist[96];
+    char imageUrl[128];
+    uint16_t imageWidth;  // Ancho de la imagen elegida, 0 si spotify no lo informa
+    int32_t progressMs;
+    int32_t durationMs;
+    bool isPlaying;
+    int8_t volumePercent;  // Del dispositivo activo, -1 si no lo informa (algunos no dejan cambiarlo)
+};
+
+// Lo que la tarea de red le entrega a la UI despues de cada consulta. Se copia entero en la cola,
+// la UI nunca ve un estado a medio escribir.
+struct PlaybackSnapshot {
+    PlaybackState state;
+    bool active;          // false si spotify respondio 204 (no hay nada reproduciendose)
+    uint32_t artVersion;  // Aumenta cada vez que se descarga una tapa nueva
+    char artPath[32];     // Archivo en SPIFFS con la tapa actual, vacio si ya se dibujo por bloques
+    uint8_t artScale;     // Escala para decodificar artPath (1, 2, 4 u 8)
+    uint32_t artPalette;  // Fondo y acento sacados de la tapa (ArtPalette::pack), 0 si no se conocen
+    uint32_t commandSeq;  // Ultimo comando de la UI que ya estaba aplicado cuando se consulto
+    uint32_t sampledAt;   // millis() estimado en el que spotify midio state.progressMs
+    bool restored;        // Lo ultimo que se mostro antes de apagar (NVS), no una respuesta de spotify
+};
+
+// Parsea el cuerpo directamente desde el stream, quedandose solo con los campos de PlaybackState.
+// El JsonDocument vive en un arena estatico (JSON_ARENA_SIZE), no en el heap.
+// Si peakBytes no es nulo devuelve el pico de memoria usado por el JsonDocument.
+bool parseCurrentlyPlaying(Stream& input, PlaybackState& state, size_t* peakBytes = nullptr);
+
+// Veces que el arena no alcanzo y el parser tuvo que pedir memoria al heap
+uint32_t jsonArenaFallbacks();
+
+// Tapas de las proximas canciones de /v1/me/player/queue, en orden
+#define QUEUE_ART_MAX 3
+
+struct QueueArt {
+    char urls[QUEUE_ART_MAX][128];
+    uint8_t count;
+};
+
+bool parseQueueArt(Stream& input, QueueArt& art);
+
+// Navegador de la cola y las playlists: se piden paginas de BROWSER_PAGE_SIZE filas a medida que se scrollea
+#define BROWSER_PAGE_SIZE 12
+// Miniaturas: la imagen mas chica de spotify que cubra THUMB_TARGET_SIZE (64 px en los temas, 60 en los
+// mosaicos de playlists), reducida con la escala de tjpgd. Sin ancho (las tapas propias de las playlists)
+// o mas ancha que THUMB_MAX_WIDTH no se pide: habria que bajarla y decodificarla entera para recortarla
+#define THUMB_TARGET_SIZE 32
+#define THUMB_MAX_WIDTH (8 * THUMB_TARGET_SIZE)
+
+enum BrowserSource : uint8_t {
+    BROWSE_QUEUE,           // /v1/me/player/queue, una sola pagina
+    BROWSE_PLAYLISTS,       // /v1/me/playlists
+    BROWSE_PLAYLIST_TRACKS  // /v1/playlists/{id}/tracks
+};
+
+struct BrowserItem {
+    char id[24];         // Tema o playlist
+    char title[48];
+    char subtitle[40];   // Artista, o cuantos temas tiene la playlist
+    char thumbUrl[72];   // Vacio si no hay o no entra entera a escala 8
+    uint16_t thumbWidth; // Ancho de thumbUrl, para elegir la escala
+};
+
+struct BrowserPage {
+    BrowserSource source;
+    uint32_t generation;  // Lista a la que pertenece: cambia cada vez que se abre otra
+    uint32_t offset;
+    uint32_t total;
+    uint8_t count;
+    bool ok;              // false si la peticion fallo; la pagina no trae filas
+    BrowserItem items[BROWSER_PAGE_SIZE];
+};
+
+// UI -> tarea de red: una pagina que hace falta, o reproducir una playlist desde una fila
+struct BrowserRequest {
+    BrowserSource source;
+    uint32_t generation;
+    uint32_t offset;   // Primera fila de la pagina; con play, la fila desde la que se reproduce
+    bool play;
+    char contextId[sizeof(BrowserItem::id)];  // La playlist, para BROWSE_PLAYLIST_TRACKS
+};
+
+// Completa count, total e items; offset, source y generation los pone quien pidio la pagina
+bool parseBrowserPage(Stream& input, BrowserSource source, BrowserPage& page);
+
+#endif
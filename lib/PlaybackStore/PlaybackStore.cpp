@@ -0,0 +1,57 @@
+#include "PlaybackStore.h"
+
+#define PLAYBACK_STORE_KEY "last_state"
+// Cambia si cambia PlaybackState, asi no se lee un blob con otro formato
+#define PLAYBACK_STORE_VERSION 2
+
+struct StoredPlayback {
+    uint32_t version;
+    PlaybackState state;
+};
+
+bool PlaybackStore::load(PlaybackState& state) {
+    StoredPlayback stored;
+    if (preferences->getBytesLength(PLAYBACK_STORE_KEY) != sizeof(stored))
+        return false;
+    if (preferences->getBytes(PLAYBACK_STORE_KEY, &stored, sizeof(stored)) != sizeof(stored) || stored.version != PLAYBACK_STORE_VERSION)
+        return false;
+
+    // Los textos vienen de flash: se cierran por las dudas
+    stored.state.id[sizeof(stored.state.id) - 1] = '\0';
+    stored.state.name[sizeof(stored.state.name) - 1] = '\0';
+    stored.state.artist[sizeof(stored.state.artist) - 1] = '\0';
+    stored.state.imageUrl[sizeof(stored.state.imageUrl) - 1] = '\0';
+
+    state = stored.state;
+    saved = stored.state;
+    hasSaved = true;
+    return true;
+}
+
+void PlaybackStore::save(const PlaybackState& state) {
+    if (hasSaved && strcmp(saved.id, state.id) == 0 && saved.isPlaying == state.isPlaying &&
+        strcmp(saved.imageUrl, state.imageUrl) == 0)
+        return;
+
+    StoredPlayback stored;
+    memset(&stored, 0, sizeof(stored));
+    stored.version = PLAYBACK_STORE_VERSION;
+    stored.state = state;
+    if (preferences->putBytes(PLAYBACK_STORE_KEY, &stored, sizeof(stored)) != sizeof(stored))
+        return;
+
+    saved = state;
+    hasSaved = true;
+    writeCount++;
+}
+
+uint32_t PlaybackStore::writes() const {
+    return writeCount;
+}
+
+PlaybackStore::PlaybackStore(Preferences& preferences) {
+    this->preferences = &preferences;
+    memset(&saved, 0, sizeof(saved));
+    hasSaved = false;
+    writeCount = 0;
+}
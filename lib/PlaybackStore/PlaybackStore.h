@@ -0,0 +1,29 @@
+#ifndef PLAYBACKSTORE_H
+#define PLAYBACKSTORE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+#include "PlaybackState.h"
+
+// Ultimo tema que mostro la pantalla, guardado en NVS para pintarlo al arrancar mientras se conecta el WiFi.
+// Solo se escribe cuando cambia el tema, play/pausa o la tapa: el progreso cambia en cada consulta y gastaria la flash.
+class PlaybackStore {
+
+  private:
+    Preferences* preferences;
+    PlaybackState saved;
+    bool hasSaved;
+    uint32_t writeCount;
+
+  public:
+    // false si no hay nada guardado o es de una version con otro PlaybackState
+    bool load(PlaybackState& state);
+    void save(const PlaybackState& state);
+
+    uint32_t writes() const;
+
+    PlaybackStore(Preferences& preferences);
+};
+
+#endif
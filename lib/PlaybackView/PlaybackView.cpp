@@ -0,0 +1,65 @@
+#include "PlaybackView.h"
+
+uint8_t PlaybackView::changes(const PlaybackState& state) const {
+    uint8_t widgets = 0;
+
+    // Se compara lo que se ve, no el id: dos versiones del mismo tema o un album del mismo artista
+    // cambian de cancion sin tocar todos los textos
+    if (strcmp(name, state.name) != 0)
+        widgets |= WIDGET_TITLE;
+    if (strcmp(artist, state.artist) != 0)
+        widgets |= WIDGET_ARTIST;
+    if (durationSeconds != state.durationMs / 1000)
+        widgets |= WIDGET_DURATION;
+
+    PlayState next = state.isPlaying ? PLAY_STATE_PLAYING : PLAY_STATE_PAUSED;
+    if (playState != next)
+        widgets |= WIDGET_PLAY_BUTTON;
+
+    if (state.volumePercent >= 0 && volume != state.volumePercent)
+        widgets |= WIDGET_VOLUME;
+
+    return widgets;
+}
+
+void PlaybackView::apply(const PlaybackState& state) {
+    strlcpy(songId, state.id, sizeof(songId));
+    strlcpy(name, state.name, sizeof(name));
+    strlcpy(artist, state.artist, sizeof(artist));
+    durationSeconds = state.durationMs / 1000;
+    playState = state.isPlaying ? PLAY_STATE_PLAYING : PLAY_STATE_PAUSED;
+    if (state.volumePercent >= 0)
+        volume = state.volumePercent;
+}
+
+uint8_t PlaybackView::progressChanges(int32_t progressMs, int32_t barValue) const {
+    uint8_t widgets = 0;
+    if (progressSeconds != progressMs / 1000)
+        widgets |= WIDGET_PROGRESS_TEXT;
+    if (this->barValue != barValue)
+        widgets |= WIDGET_PROGRESS_BAR;
+    return widgets;
+}
+
+void PlaybackView::applyProgress(int32_t progressMs, int32_t barValue) {
+    progressSeconds = progressMs / 1000;
+    this->barValue = barValue;
+}
+
+uint8_t widgetCount(uint8_t widgets) {
+    uint8_t count = 0;
+    for (; widgets != 0; widgets &= widgets - 1)
+        count++;
+    return count;
+}
+
+PlaybackView::PlaybackView() {
+    songId[0] = '\0';
+    name[0] = '\0';
+    artist[0] = '\0';
+    durationSeconds = -1;
+    playState = PLAY_STATE_UNKNOWN;
+    progressSeconds = -1;
+    barValue = -1;
+    volume = -1;
+}
@@ -0,0 +1,52 @@
+#ifndef PLAYBACKVIEW_H
+#define PLAYBACKVIEW_H
+
+#include <stdint.h>
+
+#include "PlaybackState.h"
+
+enum PlayState : uint8_t {
+    PLAY_STATE_UNKNOWN,
+    PLAY_STATE_PAUSED,
+    PLAY_STATE_PLAYING
+};
+
+// Widgets de la pantalla principal. Los cuatro primeros y el volumen dependen de cada consulta; la
+// barra y el tiempo transcurrido los mueve el timer de progreso
+enum PlaybackWidget : uint8_t {
+    WIDGET_TITLE = 1 << 0,
+    WIDGET_ARTIST = 1 << 1,
+    WIDGET_DURATION = 1 << 2,
+    WIDGET_PLAY_BUTTON = 1 << 3,
+    WIDGET_PROGRESS_TEXT = 1 << 4,
+    WIDGET_PROGRESS_BAR = 1 << 5,
+    WIDGET_VOLUME = 1 << 6
+};
+
+// Lo que la pantalla muestra ahora, campo por campo. La UI pide changes(), toca solo esos widgets y
+// despues llama a apply(). Los textos quedan aca, asi los labels pueden apuntarlos con lv_label_set_text_static
+struct PlaybackView {
+    char songId[sizeof(PlaybackState::id)];
+    char name[sizeof(PlaybackState::name)];
+    char artist[sizeof(PlaybackState::artist)];
+    int32_t durationSeconds;
+    PlayState playState;
+    int32_t progressSeconds;
+    int32_t barValue;
+    int8_t volume;  // -1 mientras el dispositivo no lo informe
+
+    // Mascara de PlaybackWidget que hay que redibujar para mostrar state
+    uint8_t changes(const PlaybackState& state) const;
+    void apply(const PlaybackState& state);
+
+    // Lo mismo para el progreso; barValue ya escalado al rango de la barra
+    uint8_t progressChanges(int32_t progressMs, int32_t barValue) const;
+    void applyProgress(int32_t progressMs, int32_t barValue);
+
+    PlaybackView();
+};
+
+// Cantidad de widgets de una mascara, para las mediciones
+uint8_t widgetCount(uint8_t widgets);
+
+#endif
@@ -0,0 +1,461 @@
+#include "PlayerSession.h"
+
+//========= Consultas =========
+
+void PlayerSession::pollCurrentlyPlaying() {
+    uint32_t tokenGeneration = tokens->currentGeneration();
+    api->setAuthorization(tokens->authorizationHeader());
+
+    uint32_t requestedAt = millis();
+    api->setIfNoneMatch(etag);
+    int httpCode = api->GET("/v1/me/player/currently-playing");
+    countTransport(httpCode);
+
+    PlaybackSnapshot snapshot;
+    snapshot.active = false;
+    snapshot.restored = false;
+    // Spotify no dice cuando midio progress_ms, se toma la mitad del viaje de ida y vuelta
+    snapshot.sampledAt = requestedAt + (millis() - requestedAt) / 2;
+
+    if (httpCode == 200) {
+        // Se parsea directo del socket, sin copiar la respuesta a un String
+        size_t peakBytes = 0;
+        uint32_t start = micros();
+        bool parsed = parseCurrentlyPlaying(api->getBodyStream(), snapshot.state, &peakBytes);
+        metrics.record(STAGE_JSON_PARSE, micros() - start);
+        // Un ETag que no entra entero no sirve como validador
+        if (!parsed || !api->etag(etag, sizeof(etag)))
+            etag[0] = '\0';
+
+        if (!parsed) {
+            // El cuerpo pudo quedar a medio leer: end() dejaria basura para la proxima respuesta
+            api->abort();
+            scheduler.onError(millis());
+            return;
+        }
+        api->end();
+
+        lastState = snapshot.state;
+        lastSampledAt = snapshot.sampledAt;
+
+        Serial.printf("Memoria usada al parsear: %u bytes\n", (unsigned)peakBytes);
+
+        if (snapshot.state.isPlaying)
+            scheduler.onPlaying(millis(), snapshot.state.progressMs, snapshot.state.durationMs);
+        else
+            scheduler.onPaused(millis());
+
+        netIsPlaying = snapshot.state.isPlaying;
+        snapshot.active = true;
+    } else if (httpCode == 304) {
+        api->end();
+        onNotModified(snapshot.sampledAt);
+        return;
+    } else if (httpCode == 401) {
+        metrics.count(COUNTER_UNAUTHORIZED);
+        api->end();
+        // Sin token nuevo (accounts fallo o todavia no se puede reintentar) las consultas esperan lo mismo que el token
+        if (tokens->onUnauthorized(tokenGeneration))
+            scheduler.onError(millis());
+        else
+            scheduler.onError(millis(), tokens->msUntilRetry(millis()));
+        return;
+    } else if (httpCode == 204) {
+        api->end();
+        etag[0] = '\0';
+        scheduler.onIdle(millis());
+        Serial.println("No hay reproducción activa en este momento.");
+    } else if (httpCode == 429) {
+        metrics.count(COUNTER_RATE_LIMITED);
+        uint32_t retryAfter = api->retryAfter();
+        api->end();
+        scheduler.onRateLimited(millis(), retryAfter);
+        Serial.printf("Spotify limito las peticiones, se espera %u s\n", retryAfter);
+        return;
+    } else {
+        Serial.printf("Error al actualizar la cancion, Código HTTP: %d\n", httpCode);
+        api->end();
+        scheduler.onError(millis());
+        return;
+    }
+
+    snapshot.commandSeq = ackedCommandSeq;
+    lastSentSeq = ackedCommandSeq;
+    listener->onSnapshot(snapshot);
+}
+
+// Nada cambio desde el ultimo 200: no hay cuerpo que bajar ni parsear, el progreso se interpola
+void PlayerSession::onNotModified(uint32_t sampledAt) {
+    notModifiedCount++;
+    metrics.count(COUNTER_NOT_MODIFIED);
+
+    int32_t progress = lastState.progressMs;
+    if (lastState.isPlaying) {
+        progress += (int32_t)(sampledAt - lastSampledAt);
+        if (progress > lastState.durationMs)
+            progress = lastState.durationMs;
+    }
+
+    if (lastState.isPlaying)
+        scheduler.onPlaying(millis(), progress, lastState.durationMs);
+    else
+        scheduler.onPaused(millis());
+
+    // La UI ya tiene este estado y su reloj de progreso sigue solo. Pero si espera la confirmacion de un
+    // comando que no cambio nada (p.ej. play con algo ya sonando), se la da con el estado guardado
+    if (lastSentSeq == ackedCommandSeq)
+        return;
+
+    PlaybackSnapshot snapshot;
+    snapshot.state = lastState;
+    snapshot.state.progressMs = progress;
+    snapshot.sampledAt = sampledAt;
+    snapshot.active = true;
+    snapshot.restored = false;
+    snapshot.commandSeq = ackedCommandSeq;
+    lastSentSeq = ackedCommandSeq;
+    listener->onSnapshot(snapshot);
+}
+
+//========= Comandos =========
+
+// El token se renueva antes de vencer, un 401 solo llega si spotify lo revoco: se renueva y se reintenta una vez
+int PlayerSession::sendCommand(bool put, const char* path, const String& body) {
+    int httpCode = 0;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        uint32_t tokenGeneration = tokens->currentGeneration();
+        api->setAuthorization(tokens->authorizationHeader());  // Cabecera con el token de acceso
+
+        httpCode = put ? api->PUT(path, body, body.length() > 0 ? "application/json" : nullptr) : api->POST(path);
+        countTransport(httpCode);
+        if (httpCode != 401)
+            break;
+
+        metrics.count(COUNTER_UNAUTHORIZED);
+        api->end();
+        if (!tokens->onUnauthorized(tokenGeneration))
+            break;
+    }
+
+    if (httpCode == 429) {
+        metrics.count(COUNTER_RATE_LIMITED);
+        scheduler.onRateLimited(millis(), api->retryAfter());
+    }
+
+    // Spotify responde sin cuerpo; end() descarta lo que haya sin copiarlo a un String
+    api->end();
+    return httpCode;
+}
+
+int PlayerSession::playAndPause(bool play) {
+    int httpCode = sendCommand(true, play ? "/v1/me/player/play" : "/v1/me/player/pause");
+
+    if (httpCode >= 200 && httpCode < 300)
+        Serial.printf("Pausado o reanudado exitoso (%d)\n", httpCode);
+    else
+        Serial.printf("Error al enviar la solicitud (%d)\n", httpCode);
+    return httpCode;
+}
+
+int PlayerSession::nextSong() {
+    int httpCode = sendCommand(false, "/v1/me/player/next");  // Enviamos la petición POST (vacía)
+
+    if (httpCode > 0)
+        Serial.printf("Siguiente canción enviada (%d)\n", httpCode);
+    else
+        Serial.printf("Error al enviar la solicitud (%d)\n", httpCode);
+    return httpCode;
+}
+
+int PlayerSession::prevSong() {
+    int httpCode = sendCommand(false, "/v1/me/player/previous");  // Enviamos la petición POST (vacía)
+
+    if (httpCode > 0)
+        Serial.printf("Canción anterior enviada (%d)\n", httpCode);
+    else
+        Serial.printf("Error al enviar la solicitud (%d)\n", httpCode);
+    return httpCode;
+}
+
+// Los comandos son del usuario: pueden endeudar el presupuesto, pero no se mandan durante un Retry-After
+bool PlayerSession::acquireCommand() {
+    if (!scheduler.acquire(millis(), true)) {
+        Serial.println("Comando descartado: spotify limito las peticiones");
+        return false;
+    }
+    commandCalls++;
+    return true;
+}
+
+void PlayerSession::runCommands(const TransportBatch& batch) {
+    // Spotify no tiene un "saltar N", van todos seguidos por la misma conexion y se consulta una sola vez al final
+    for (int32_t i = 0; i < batch.skip && acquireCommand(); i++) {
+        nextSong();
+    }
+    for (int32_t i = 0; i > batch.skip && acquireCommand(); i--) {
+        prevSong();
+    }
+
+    // Solo se manda si el estado final pedido no es el que ya tiene spotify
+    if (batch.play >= 0 && (batch.play == 1) != netIsPlaying && acquireCommand()) {
+        int httpCode = playAndPause(batch.play == 1);
+        if (httpCode >= 200 && httpCode < 300)
+            netIsPlaying = batch.play == 1;
+    }
+
+    if (batch.seekMs >= 0)
+        wantedSeekMs = batch.seekMs;
+    if (batch.volume >= 0)
+        wantedVolume = batch.volume;
+    wantedSeq = batch.seq;
+    sendDrags();
+
+    scheduler.onUserCommand(millis());
+    lastCommandAt = millis();
+}
+
+// Una peticion por control a la vez y como mucho cada DRAG_MIN_INTERVAL_MS, siempre con el ultimo valor.
+// Devuelve en cuantos ms hay que volver a mirar, UINT32_MAX si no quedo nada por mandar
+uint32_t PlayerSession::sendDrags() {
+    uint32_t wait = UINT32_MAX;
+    char path[64];
+
+    if (wantedSeekMs >= 0) {
+        uint32_t since = millis() - lastSeekAt;
+        if (since < DRAG_MIN_INTERVAL_MS) {
+            wait = DRAG_MIN_INTERVAL_MS - since;
+        } else {
+            if (acquireCommand()) {
+                snprintf(path, sizeof(path), "/v1/me/player/seek?position_ms=%d", (int)wantedSeekMs);
+                int httpCode = sendCommand(true, path);
+                seekCalls++;
+                if (httpCode < 200 || httpCode >= 300)
+                    Serial.printf("Error al mover la posicion (%d)\n", httpCode);
+            }
+            wantedSeekMs = -1;
+            lastSeekAt = millis();
+        }
+    }
+
+    if (wantedVolume >= 0) {
+        uint32_t since = millis() - lastVolumeAt;
+        if (since < DRAG_MIN_INTERVAL_MS) {
+            if (DRAG_MIN_INTERVAL_MS - since < wait)
+                wait = DRAG_MIN_INTERVAL_MS - since;
+        } else {
+            if (acquireCommand()) {
+                snprintf(path, sizeof(path), "/v1/me/player/volume?volume_percent=%d", (int)wantedVolume);
+                int httpCode = sendCommand(true, path);
+                volumeCalls++;
+                if (httpCode < 200 || httpCode >= 300)
+                    Serial.printf("Error al cambiar el volumen (%d)\n", httpCode);
+            }
+            wantedVolume = -1;
+            lastVolumeAt = millis();
+        }
+    }
+
+    if (wantedSeekMs < 0 && wantedVolume < 0 && wantedSeq != ackedCommandSeq) {
+        ackedCommandSeq = wantedSeq;
+        scheduler.onUserCommand(millis());
+    }
+    return wait;
+}
+
+//========= Navegador =========
+
+void PlayerSession::fetchBrowserPage(const BrowserRequest& request, BrowserPage& page) {
+    page.source = request.source;
+    page.generation = request.generation;
+    page.offset = request.offset;
+    page.count = 0;
+    page.total = 0;
+    page.ok = false;
+
+    // Scrolleando se piden varias por segundo: no gastan el presupuesto de las consultas, pero un
+    // Retry-After vale para todas
+    if (scheduler.rateLimited(millis())) {
+        Serial.println("Pagina descartada: spotify limito las peticiones");
+        return;
+    }
+    browseCalls++;
+
+    // fields recorta la respuesta en el servidor; el filtro del parser hace lo mismo con lo que llegue
+    char path[192];
+    if (request.source == BROWSE_QUEUE)
+        strlcpy(path, "/v1/me/player/queue", sizeof(path));
+    else if (request.source == BROWSE_PLAYLISTS)
+        snprintf(path, sizeof(path), "/v1/me/playlists?offset=%u&limit=%u", request.offset, BROWSER_PAGE_SIZE);
+    else
+        snprintf(path, sizeof(path), "/v1/playlists/%s/tracks?offset=%u&limit=%u&fields=total,items(track(id,name,artists(name),album(images)))",
+                 request.contextId, request.offset, BROWSER_PAGE_SIZE);
+
+    int httpCode = 0;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        uint32_t tokenGeneration = tokens->currentGeneration();
+        api->setAuthorization(tokens->authorizationHeader());
+        httpCode = api->GET(path);
+        countTransport(httpCode);
+        if (httpCode != 401)
+            break;
+
+        metrics.count(COUNTER_UNAUTHORIZED);
+        api->end();
+        if (!tokens->onUnauthorized(tokenGeneration))
+            break;
+    }
+
+    if (httpCode == 200) {
+        page.ok = parseBrowserPage(api->getBodyStream(), request.source, page);
+        if (!page.ok) {
+            api->abort();
+            return;
+        }
+    } else if (httpCode == 429) {
+        metrics.count(COUNTER_RATE_LIMITED);
+        scheduler.onRateLimited(millis(), api->retryAfter());
+    } else {
+        Serial.printf("Error al pedir la pagina %u, Código HTTP: %d\n", request.offset, httpCode);
+    }
+    api->end();
+}
+
+int PlayerSession::playContext(const char* playlistId, uint32_t position) {
+    if (!acquireCommand())
+        return 0;
+
+    char body[96];
+    snprintf(body, sizeof(body), "{\"context_uri\":\"spotify:playlist:%s\",\"offset\":{\"position\":%u}}", playlistId, position);
+    int httpCode = sendCommand(true, "/v1/me/player/play", body);
+    if (httpCode >= 200 && httpCode < 300)
+        netIsPlaying = true;
+    else
+        Serial.printf("Error al reproducir la playlist (%d)\n", httpCode);
+
+    scheduler.onUserCommand(millis());
+    lastCommandAt = millis();
+    return httpCode;
+}
+
+// HTTPClient devuelve codigos negativos cuando no hubo respuesta (sin conexion, DNS, timeout)
+void PlayerSession::countTransport(int httpCode) {
+    if (httpCode <= 0)
+        transportErrorCount++;
+    else
+        transportErrorCount = 0;
+}
+
+void PlayerSession::onReconnected() {
+    // Los fallos de antes de reconectar ya se usaron; si la proxima vuelta no hace ninguna peticion
+    // ConnectivityManager volveria a tirar el enlace con la cuenta vieja
+    transportErrorCount = 0;
+    scheduler.onReconnected(millis());
+}
+
+//========= Loop =========
+
+void PlayerSession::begin() {
+    tokens->begin();
+    scheduler.begin(millis());
+}
+
+uint32_t PlayerSession::step() {
+    // El token se renueva aca, antes de que lo necesite una peticion del usuario
+    tokens->refreshIfDue(millis());
+
+    // Los comandos de los botones tienen prioridad; el scheduler adelanta la consulta siguiente
+    TransportBatch batch;
+    if (commands->take(batch))
+        runCommands(batch);
+    uint32_t untilDrag = sendDrags();
+
+    pollDenied = false;
+    if (scheduler.msUntilNextPoll(millis()) == 0) {
+        if (scheduler.acquire(millis(), false))
+            pollCurrentlyPlaying();
+        else
+            pollDenied = true;
+    }
+
+    uint32_t wait = scheduler.msUntilNextPoll(millis());
+    // Sin presupuesto se reintenta en un rato en lugar de girar en vacio
+    if (pollDenied)
+        wait = PollScheduler::MIN_INTERVAL_MS;
+    uint32_t untilRefresh = tokens->msUntilRefresh(millis());
+    if (untilRefresh < wait)
+        wait = untilRefresh;
+    return untilDrag < wait ? untilDrag : wait;
+}
+
+PollScheduler& PlayerSession::pollScheduler() {
+    return scheduler;
+}
+
+uint32_t PlayerSession::lastCommandTime() const {
+    return lastCommandAt;
+}
+
+uint32_t PlayerSession::commandRequests() const {
+    return commandCalls;
+}
+
+uint32_t PlayerSession::browseRequests() const {
+    return browseCalls;
+}
+
+uint32_t PlayerSession::seekRequests() const {
+    return seekCalls;
+}
+
+uint32_t PlayerSession::volumeRequests() const {
+    return volumeCalls;
+}
+
+uint32_t PlayerSession::transportErrors() const {
+    return transportErrorCount;
+}
+
+uint32_t PlayerSession::notModifiedResponses() const {
+    return notModifiedCount;
+}
+
+void PlayerSession::printStats() {
+    Serial.printf("Comandos: %u toques, %u llamadas a la API\n", commands->tapCount(), commandCalls);
+
+    uint32_t baseline = scheduler.baselinePolls(millis());
+    uint32_t polls = scheduler.backgroundRequests();
+    Serial.printf("Consultas: %u (con el timer fijo de 5 s: %u, ahorradas: %d), 429: %u, denegadas por presupuesto: %u\n",
+                  polls, baseline, (int)(baseline - polls), scheduler.rateLimitedResponses(), scheduler.deniedRequests());
+    Serial.printf("Consultas resueltas con 304: %u\n", notModifiedCount);
+    Serial.printf("Navegador: %u paginas pedidas\n", browseCalls);
+    Serial.printf("Arrastres: seek %u eventos -> %u peticiones, volumen %u eventos -> %u peticiones\n",
+                  commands->seekEventCount(), seekCalls, commands->volumeEventCount(), volumeCalls);
+}
+
+PlayerSession::PlayerSession(HttpTransport& api, TokenManager& tokens, CommandCoalescer& commands, PlayerListener& listener) {
+    this->api = &api;
+    this->tokens = &tokens;
+    this->commands = &commands;
+    this->listener = &listener;
+
+    netIsPlaying = false;
+    ackedCommandSeq = 0;
+    commandCalls = 0;
+    browseCalls = 0;
+    wantedSeekMs = -1;
+    wantedVolume = -1;
+    wantedSeq = 0;
+    lastSeekAt = 0;
+    lastVolumeAt = 0;
+    seekCalls = 0;
+    volumeCalls = 0;
+    lastCommandAt = 0;
+    pollDenied = false;
+    transportErrorCount = 0;
+
+    etag[0] = '\0';
+    memset(&lastState, 0, sizeof(lastState));
+    lastSampledAt = 0;
+    lastSentSeq = 0;
+    notModifiedCount = 0;
+}
@@ -0,0 +1,110 @@
+#ifndef PLAYERSESSION_H
+#define PLAYERSESSION_H
+
+#include <Arduino.h>
+
+#include "HttpTransport.h"
+#include "TokenManager.h"
+#include "PollScheduler.h"
+#include "CommandCoalescer.h"
+#include "PlaybackState.h"
+#include "Metrics.h"
+
+// Lo que la sesion le avisa a quien la usa (firmware o env:native)
+class PlayerListener {
+
+  public:
+    // Resultado de cada consulta que cambia lo que se muestra (200 o 204, ver snapshot.active). Un 304 solo
+    // se reenvia si hay un comando que la UI todavia no vio confirmado.
+    // Aca se resuelve la tapa y se completan los campos de arte antes de pasarlo a la UI
+    virtual void onSnapshot(PlaybackSnapshot& snapshot) = 0;
+
+    virtual ~PlayerListener() {}
+};
+
+// Logica de red del controlador: consultas a currently-playing, comandos de transporte y token.
+// No sabe nada de pantalla ni de FreeRTOS, por eso corre igual en el ESP32 y en env:native.
+class PlayerSession {
+
+  private:
+    HttpTransport* api;
+    TokenManager* tokens;
+    CommandCoalescer* commands;
+    PlayerListener* listener;
+    PollScheduler scheduler;
+
+    bool netIsPlaying;
+    uint32_t ackedCommandSeq;
+    uint32_t commandCalls;
+    uint32_t lastCommandAt;
+    bool pollDenied;
+    uint32_t transportErrorCount;
+    uint32_t browseCalls;
+
+    // Arrastres de la barra y del volumen: el ultimo valor que todavia no salio (-1 ninguno). El lote
+    // que los trajo se confirma a la UI recien cuando salen, asi una consulta vieja no los deshace
+    int32_t wantedSeekMs;
+    int8_t wantedVolume;
+    uint32_t wantedSeq;
+    uint32_t lastSeekAt;
+    uint32_t lastVolumeAt;
+    uint32_t seekCalls;
+    uint32_t volumeCalls;
+
+    // Validador de la ultima respuesta 200 y el estado que traia, para contestar los 304 sin cuerpo
+    char etag[64];
+    PlaybackState lastState;
+    uint32_t lastSampledAt;
+    uint32_t lastSentSeq;
+    uint32_t notModifiedCount;
+
+    void onNotModified(uint32_t sampledAt);
+    int sendCommand(bool put, const char* path, const String& body = "");
+    int playAndPause(bool play);
+    int nextSong();
+    int prevSong();
+    bool acquireCommand();
+    uint32_t sendDrags();
+    void countTransport(int httpCode);
+
+  public:
+    // Entre dos peticiones del mismo arrastre; lo que llega mientras tanto se pisa
+    static const uint32_t DRAG_MIN_INTERVAL_MS = 1000;
+
+    // Token guardado (o uno nuevo) y arranque del scheduler
+    void begin();
+
+    // Una vuelta de la tarea de red: token, comandos pendientes y la consulta si toca.
+    // Devuelve cuantos ms se puede dormir hasta la proxima vuelta (un comando la adelanta)
+    uint32_t step();
+
+    void pollCurrentlyPlaying();
+
+    // Manda un lote de comandos; step() los toma del coalescer, esto es para los que se guardaron sin conexion
+    void runCommands(const TransportBatch& batch);
+
+    // Navegador: una pagina de la cola o de las playlists. Completa page siempre (page.ok = false si fallo)
+    void fetchBrowserPage(const BrowserRequest& request, BrowserPage& page);
+
+    // Reproduce la playlist desde el tema position y consulta enseguida para mostrarlo
+    int playContext(const char* playlistId, uint32_t position);
+
+    // Volvio la red despues de una caida: consulta en la proxima vuelta y olvida los fallos de transporte
+    void onReconnected();
+
+    // Peticiones seguidas que no llegaron a tener respuesta HTTP (codigo <= 0)
+    uint32_t transportErrors() const;
+
+    PollScheduler& pollScheduler();
+    uint32_t lastCommandTime() const;
+    uint32_t commandRequests() const;
+    uint32_t browseRequests() const;
+    uint32_t seekRequests() const;
+    uint32_t volumeRequests() const;
+    uint32_t notModifiedResponses() const;
+    void printStats();
+
+    PlayerSession(HttpTransport& api, TokenManager& tokens, CommandCoalescer& commands, PlayerListener& listener);
+};
+
+#endif
@@ -0,0 +1,161 @@
+#include "PollScheduler.h"
+
+//========= Helpers =========
+
+// Comparacion que soporta el desborde de millis()
+static bool before(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) < 0;
+}
+
+void PollScheduler::schedule(uint32_t now, uint32_t delay) {
+    if (delay < MIN_INTERVAL_MS)
+        delay = MIN_INTERVAL_MS;
+
+    // Recien despues de un comando se consulta seguido para ver el resultado enseguida
+    if (boosting && !before(now, boostUntil))
+        boosting = false;
+    if (boosting && delay > BOOST_INTERVAL_MS)
+        delay = BOOST_INTERVAL_MS;
+
+    nextPollAt = now + delay;
+
+    if (rateLimited(now) && before(nextPollAt, blockedUntil))
+        nextPollAt = blockedUntil;
+}
+
+void PollScheduler::refill(uint32_t now) {
+    uint32_t elapsed = now - budgetRefilledAt;
+    budgetRefilledAt = now;
+
+    // budgetPerMinute peticiones por minuto = budgetPerMinute / 60 milesimas de peticion por ms
+    int64_t added = (int64_t)elapsed * budgetPerMinute / 60;
+    int64_t total = budget + added;
+    if (total > BUDGET_BURST * 1000)
+        total = BUDGET_BURST * 1000;
+    budget = (int32_t)total;
+}
+
+//========= Schedule =========
+
+uint32_t PollScheduler::msUntilNextPoll(uint32_t now) const {
+    if (!before(now, nextPollAt))
+        return 0;
+    return nextPollAt - now;
+}
+
+bool PollScheduler::rateLimited(uint32_t now) {
+    // Los flags evitan que un tiempo viejo parezca futuro cuando millis() da la vuelta
+    if (blocked && !before(now, blockedUntil))
+        blocked = false;
+    return blocked;
+}
+
+bool PollScheduler::acquire(uint32_t now, bool userInitiated) {
+    refill(now);
+
+    if (rateLimited(now) || (budget < 1000 && !userInitiated) || budget < -BUDGET_BURST * 1000) {
+        deniedCount++;
+        return false;
+    }
+
+    budget -= 1000;
+    if (!userInitiated)
+        backgroundCount++;
+    return true;
+}
+
+void PollScheduler::onPlaying(uint32_t now, int32_t progressMs, int32_t durationMs) {
+    idleIntervalMs = BASELINE_INTERVAL_MS;
+
+    // La cancion termina en "remaining": se consulta un poco despues para mostrar la siguiente enseguida
+    uint32_t delay = playingIntervalMs;
+    int32_t remaining = durationMs - progressMs;
+    if (remaining >= 0 && (uint32_t)remaining + TRACK_END_MARGIN_MS < delay)
+        delay = remaining + TRACK_END_MARGIN_MS;
+
+    schedule(now, delay);
+}
+
+void PollScheduler::onPaused(uint32_t now) {
+    schedule(now, idleIntervalMs);
+
+    idleIntervalMs *= 2;
+    if (idleIntervalMs > maxIdleIntervalMs)
+        idleIntervalMs = maxIdleIntervalMs;
+}
+
+void PollScheduler::onIdle(uint32_t now) {
+    onPaused(now);
+}
+
+void PollScheduler::onRateLimited(uint32_t now, uint32_t retryAfterSeconds) {
+    rateLimitedCount++;
+
+    // Sin Retry-After se espera lo mismo que en pausa
+    uint32_t wait = retryAfterSeconds > 0 ? retryAfterSeconds * 1000 : idleIntervalMs;
+    blockedUntil = now + wait;
+    blocked = true;
+    budget = 0;
+    schedule(now, wait);
+}
+
+void PollScheduler::onError(uint32_t now, uint32_t minDelayMs) {
+    schedule(now, minDelayMs > BASELINE_INTERVAL_MS ? minDelayMs : BASELINE_INTERVAL_MS);
+}
+
+void PollScheduler::onUserCommand(uint32_t now) {
+    boostUntil = now + BOOST_DURATION_MS;
+    boosting = true;
+    idleIntervalMs = BASELINE_INTERVAL_MS;
+    nextPollAt = rateLimited(now) ? blockedUntil : now + COMMAND_SETTLE_MS;
+}
+
+void PollScheduler::onReconnected(uint32_t now) {
+    idleIntervalMs = BASELINE_INTERVAL_MS;
+    nextPollAt = rateLimited(now) ? blockedUntil : now;
+}
+
+void PollScheduler::begin(uint32_t now) {
+    startedAt = now;
+    budgetRefilledAt = now;
+    nextPollAt = now;
+}
+
+//========= Stats =========
+
+uint32_t PollScheduler::backgroundRequests() const {
+    return backgroundCount;
+}
+
+uint32_t PollScheduler::baselinePolls(uint32_t now) const {
+    return (now - startedAt) / BASELINE_INTERVAL_MS;
+}
+
+uint32_t PollScheduler::rateLimitedResponses() const {
+    return rateLimitedCount;
+}
+
+uint32_t PollScheduler::deniedRequests() const {
+    return deniedCount;
+}
+
+PollScheduler::PollScheduler(uint32_t playingIntervalMs, uint32_t maxIdleIntervalMs, uint32_t budgetPerMinute) {
+    this->playingIntervalMs = playingIntervalMs;
+    this->maxIdleIntervalMs = maxIdleIntervalMs;
+    this->budgetPerMinute = budgetPerMinute;
+
+    nextPollAt = 0;
+    idleIntervalMs = BASELINE_INTERVAL_MS;
+    boostUntil = 0;
+    boosting = false;
+    blockedUntil = 0;
+    blocked = false;
+
+    budget = BUDGET_BURST * 1000;
+    budgetRefilledAt = 0;
+
+    startedAt = 0;
+    backgroundCount = 0;
+    rateLimitedCount = 0;
+    deniedCount = 0;
+}
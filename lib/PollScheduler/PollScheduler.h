@@ -0,0 +1,81 @@
+#ifndef POLLSCHEDULER_H
+#define POLLSCHEDULER_H
+
+#include <stdint.h>
+
+// Decide cuando consultar /currently-playing en lugar de hacerlo cada 5 s fijos:
+//  - reproduciendo: justo despues del final previsto de la cancion (o cada playingIntervalMs para ver cambios externos)
+//  - en pausa o sin reproduccion (204): espera exponencial hasta maxIdleIntervalMs
+//  - despues de un comando del usuario: consultas seguidas durante un rato
+//  - 429: no se hace ninguna peticion hasta que pase el Retry-After
+// Ademas lleva un presupuesto global de peticiones (token bucket) compartido por consultas y comandos.
+// Todos los tiempos son millis() que pasa quien lo usa.
+class PollScheduler {
+
+  private:
+    uint32_t playingIntervalMs;
+    uint32_t maxIdleIntervalMs;
+    uint32_t budgetPerMinute;
+
+    uint32_t nextPollAt;
+    uint32_t idleIntervalMs;
+    uint32_t boostUntil;
+    bool boosting;
+    uint32_t blockedUntil;
+    bool blocked;
+
+    // Presupuesto en milesimas de peticion, para no usar float
+    int32_t budget;
+    uint32_t budgetRefilledAt;
+
+    uint32_t startedAt;
+    uint32_t backgroundCount;
+    uint32_t rateLimitedCount;
+    uint32_t deniedCount;
+
+    void schedule(uint32_t now, uint32_t delay);
+    void refill(uint32_t now);
+
+  public:
+    // Intervalo del timer fijo que reemplaza, para calcular cuantas consultas se ahorraron
+    static const uint32_t BASELINE_INTERVAL_MS = 5000;
+    static const uint32_t MIN_INTERVAL_MS = 1000;
+    static const uint32_t TRACK_END_MARGIN_MS = 600;
+    static const uint32_t BOOST_INTERVAL_MS = 1500;
+    // Spotify tarda un poco en reflejar un comando, se espera esto antes de consultar
+    static const uint32_t COMMAND_SETTLE_MS = 300;
+    static const uint32_t BOOST_DURATION_MS = 8000;
+    static const int32_t BUDGET_BURST = 8;
+
+    void begin(uint32_t now);
+
+    uint32_t msUntilNextPoll(uint32_t now) const;
+    bool rateLimited(uint32_t now);
+
+    // Toma una peticion del presupuesto. Las del usuario pueden endeudarlo (hasta una rafaga),
+    // las de fondo no. Durante un Retry-After no pasa ninguna
+    bool acquire(uint32_t now, bool userInitiated);
+
+    // Resultado de cada consulta
+    void onPlaying(uint32_t now, int32_t progressMs, int32_t durationMs);
+    void onPaused(uint32_t now);
+    void onIdle(uint32_t now);
+    void onRateLimited(uint32_t now, uint32_t retryAfterSeconds);
+    // minDelayMs: p.ej. la espera del token despues de un fallo, si es mayor que la de siempre
+    void onError(uint32_t now, uint32_t minDelayMs = 0);
+
+    void onUserCommand(uint32_t now);
+
+    // Volvio la red: lo que se sabia del estado puede haber cambiado, se consulta ya (salvo un Retry-After)
+    void onReconnected(uint32_t now);
+
+    // Peticiones que no pidio el usuario (consultas y cola) contra las que habria hecho el timer fijo
+    uint32_t backgroundRequests() const;
+    uint32_t baselinePolls(uint32_t now) const;
+    uint32_t rateLimitedResponses() const;
+    uint32_t deniedRequests() const;
+
+    PollScheduler(uint32_t playingIntervalMs = 15000, uint32_t maxIdleIntervalMs = 60000, uint32_t budgetPerMinute = 30);
+};
+
+#endif
@@ -0,0 +1,79 @@
+#include "ProgressClock.h"
+
+int32_t ProgressClock::rawProgressAt(uint32_t now) const {
+    int32_t progress = baseProgressMs;
+    if (playing)
+        progress += (int32_t)(now - baseAt);
+    return progress;
+}
+
+void ProgressClock::sample(int32_t progressMs, uint32_t sampledAt, int32_t durationMs, bool playing, bool sameTrack) {
+    int32_t shown = progressAt(sampledAt);
+
+    this->baseProgressMs = progressMs;
+    this->baseAt = sampledAt;
+    this->durationMs = durationMs > 0 ? durationMs : 1;
+    this->playing = playing;
+
+    int32_t error = shown - progressMs;
+    if (sameTrack && error > -SNAP_THRESHOLD_MS && error < SNAP_THRESHOLD_MS) {
+        correctionMs = error;
+        correctionAt = sampledAt;
+    } else {
+        correctionMs = 0;
+    }
+}
+
+void ProgressClock::setPlaying(bool playing, uint32_t now) {
+    if (playing == this->playing)
+        return;
+    baseProgressMs = progressAt(now);
+    baseAt = now;
+    correctionMs = 0;
+    this->playing = playing;
+}
+
+void ProgressClock::restart(uint32_t now) {
+    baseProgressMs = 0;
+    baseAt = now;
+    correctionMs = 0;
+}
+
+void ProgressClock::seek(int32_t progressMs, uint32_t now) {
+    baseProgressMs = progressMs;
+    baseAt = now;
+    correctionMs = 0;
+}
+
+int32_t ProgressClock::progressAt(uint32_t now) const {
+    int32_t progress = rawProgressAt(now);
+
+    if (correctionMs != 0) {
+        uint32_t elapsed = now - correctionAt;
+        if (elapsed < SLEW_MS)
+            progress += (int32_t)((int64_t)correctionMs * (int32_t)(SLEW_MS - elapsed) / (int32_t)SLEW_MS);
+    }
+
+    if (progress < 0)
+        progress = 0;
+    if (progress > durationMs)
+        progress = durationMs;
+    return progress;
+}
+
+int32_t ProgressClock::duration() const {
+    return durationMs;
+}
+
+bool ProgressClock::isPlaying() const {
+    return playing;
+}
+
+ProgressClock::ProgressClock() {
+    baseProgressMs = 0;
+    baseAt = 0;
+    durationMs = 1;
+    playing = false;
+    correctionMs = 0;
+    correctionAt = 0;
+}
@@ -0,0 +1,43 @@
+#ifndef PROGRESSCLOCK_H
+#define PROGRESSCLOCK_H
+
+#include <stdint.h>
+
+// Progreso de la cancion calculado como (progreso informado por spotify + tiempo monotono transcurrido
+// desde que se tomo la muestra), en lugar de sumar 1000 en cada tick del timer.
+// Las correcciones chicas se reparten en SLEW_MS para que la barra no salte; las grandes (seek, otra cancion) se aplican de una.
+class ProgressClock {
+
+  private:
+    int32_t baseProgressMs;
+    uint32_t baseAt;
+    int32_t durationMs;
+    bool playing;
+
+    // Diferencia entre lo que se mostraba y la muestra nueva, que se va descontando hasta cero
+    int32_t correctionMs;
+    uint32_t correctionAt;
+
+    int32_t rawProgressAt(uint32_t now) const;
+
+  public:
+    static const uint32_t SLEW_MS = 2000;
+    static const int32_t SNAP_THRESHOLD_MS = 1500;
+
+    // Muestra de spotify. sampledAt es el millis() estimado en el que el servidor midio progressMs.
+    // Si sameTrack es false el progreso salta directo a la muestra
+    void sample(int32_t progressMs, uint32_t sampledAt, int32_t durationMs, bool playing, bool sameTrack);
+
+    // Cambios locales (optimistas) sin esperar a spotify
+    void setPlaying(bool playing, uint32_t now);
+    void restart(uint32_t now);
+    void seek(int32_t progressMs, uint32_t now);
+
+    int32_t progressAt(uint32_t now) const;
+    int32_t duration() const;
+    bool isPlaying() const;
+
+    ProgressClock();
+};
+
+#endif
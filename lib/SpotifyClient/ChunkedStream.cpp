@@ -0,0 +1,113 @@
+#include "ChunkedStream.h"
+
+int ChunkedStream::timedClientRead() {
+    unsigned long start = millis();
+    while (millis() - start < client->getTimeout()) {
+        if (client->available())
+            return client->read();
+        if (!client->connected())
+            return -1;
+        yield();
+    }
+    return -1;
+}
+
+// Lee la cabecera "<tamaño hex>[;ext]\r\n" del siguiente chunk
+bool ChunkedStream::nextChunk() {
+    if (finished)
+        return false;
+
+    // Despues de los datos de un chunk viene un \r\n
+    if (remaining == 0) {
+        int32_t size = 0;
+        bool digits = false;
+        bool extension = false;
+        int c;
+        while ((c = timedClientRead()) >= 0 && c != '\n') {
+            if (extension || c == '\r')
+                continue;
+            if (c == ';') {
+                extension = true;
+            } else if (isxdigit(c)) {
+                size = size * 16 + (isdigit(c) ? c - '0' : (tolower(c) - 'a' + 10));
+                digits = true;
+            }
+        }
+        if (c < 0) {
+            finished = true;
+            return false;
+        }
+        if (!digits) {
+            // Linea vacia: era el \r\n que cierra el chunk anterior
+            return nextChunk();
+        }
+        if (size == 0) {
+            // Ultimo chunk: se descartan los trailers hasta la linea vacia
+            int len = 0;
+            while ((c = timedClientRead()) >= 0) {
+                if (c == '\n') {
+                    if (len == 0)
+                        break;
+                    len = 0;
+                } else if (c != '\r') {
+                    len++;
+                }
+            }
+            finished = true;
+            return false;
+        }
+        remaining = size;
+    }
+    return true;
+}
+
+void ChunkedStream::begin(Client* client) {
+    this->client = client;
+    remaining = 0;
+    finished = (client == nullptr);
+    if (client != nullptr)
+        setTimeout(client->getTimeout());
+}
+
+void ChunkedStream::drain() {
+    if (client == nullptr)
+        return;
+    while (read() >= 0) {
+    }
+}
+
+int ChunkedStream::available() {
+    if (finished || client == nullptr)
+        return 0;
+    if (remaining > 0)
+        return min((int)remaining, client->available());
+    return client->available() > 0 ? 1 : 0;
+}
+
+int ChunkedStream::read() {
+    if (client == nullptr || !nextChunk())
+        return -1;
+    int c = timedClientRead();
+    if (c < 0) {
+        finished = true;
+        return -1;
+    }
+    remaining--;
+    return c;
+}
+
+int ChunkedStream::peek() {
+    if (client == nullptr || !nextChunk())
+        return -1;
+    return client->peek();
+}
+
+size_t ChunkedStream::write(uint8_t) {
+    return 0;
+}
+
+ChunkedStream::ChunkedStream() {
+    client = nullptr;
+    remaining = 0;
+    finished = true;
+}
@@ -0,0 +1,33 @@
+#ifndef CHUNKEDSTREAM_H
+#define CHUNKEDSTREAM_H
+
+#include <Arduino.h>
+#include <Client.h>
+
+// Decodifica "Transfer-Encoding: chunked" al vuelo para poder leer el cuerpo como un Stream
+// (HTTPClient solo lo decodifica en getString()/writeToStream()).
+class ChunkedStream : public Stream {
+
+  private:
+    Client* client;
+    int32_t remaining;
+    bool finished;
+
+    bool nextChunk();
+    int timedClientRead();
+
+  public:
+    void begin(Client* client);
+
+    // Consume lo que quede del cuerpo (incluido el chunk final) para poder reutilizar el socket
+    void drain();
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t write(uint8_t) override;
+
+    ChunkedStream();
+};
+
+#endif
@@ -0,0 +1,169 @@
+#include "SpotifyClient.h"
+
+//========= Requests =========
+
+// Conecta antes que HTTPClient para medir por separado el DNS y el handshake. La segunda
+// resolucion, la de connect(), sale de la cache de lwIP
+bool SpotifyClient::connect() {
+    IPAddress ip;
+    uint32_t start = micros();
+    if (!WiFi.hostByName(host.c_str(), ip))
+        return false;
+    metrics.record(STAGE_DNS, micros() - start);
+
+    start = micros();
+    if (!client->connect(host.c_str(), port))
+        return false;
+    if (secure)
+        metrics.record(STAGE_TLS, micros() - start);
+    return true;
+}
+
+int SpotifyClient::send(const char* method, const char* path, const String& body, const char* contentType) {
+    // Si el socket sigue abierto HTTPClient lo reutiliza, si no, se hace un handshake nuevo
+    if (!client->connected()) {
+        // Solo cuentan los handshakes hechos: con el enlace caido connect() falla sin peticion
+        if (!connect())
+            return HTTPC_ERROR_CONNECTION_REFUSED;
+        handshakeCount++;
+    }
+    requestCount++;
+
+    // HTTPClient recibe Strings: se reutiliza el mismo buffer en lugar de armar uno temporal por peticion
+    uri = path;
+    if (!http.begin(*client, host, port, uri, secure)) {
+        return HTTPC_ERROR_CONNECTION_REFUSED;
+    }
+
+    if (authorization.length() > 0) {
+        http.addHeader("Authorization", authorization);
+    }
+    if (ifNoneMatch.length() > 0 && strcmp(method, "GET") == 0) {
+        http.addHeader("If-None-Match", ifNoneMatch);
+    }
+    // Solo para esta peticion; se vacia sin liberar el buffer
+    ifNoneMatch = "";
+    if (contentType != nullptr) {
+        http.addHeader("Content-Type", contentType);
+    }
+    // HTTPClient no manda Content-Length con el cuerpo vacio y spotify rechaza el PUT/POST sin el
+    if (body.length() == 0 && strcmp(method, "GET") != 0) {
+        http.addHeader("Content-Length", "0");
+    }
+
+    uint32_t start = micros();
+    int httpCode = http.sendRequest(method, body);
+    metrics.record(STAGE_HTTP_WAIT, micros() - start);
+    chunked = http.header("Transfer-Encoding").equalsIgnoreCase("chunked");
+    return httpCode;
+}
+
+int SpotifyClient::GET(const char* path) {
+    return send("GET", path, "", nullptr);
+}
+
+int SpotifyClient::PUT(const char* path, const String& body, const char* contentType) {
+    return send("PUT", path, body, contentType);
+}
+
+int SpotifyClient::POST(const char* path, const String& body, const char* contentType) {
+    return send("POST", path, body, contentType);
+}
+
+String SpotifyClient::getString() {
+    return http.getString();
+}
+
+WiFiClient* SpotifyClient::getStreamPtr() {
+    return http.getStreamPtr();
+}
+
+Stream& SpotifyClient::getBodyStream() {
+    WiFiClient* stream = http.getStreamPtr();
+    // Sin conexion se devuelve un stream vacio
+    if (chunked || stream == nullptr) {
+        chunkedBody.begin(stream);
+        return chunkedBody;
+    }
+    return *stream;
+}
+
+bool SpotifyClient::etag(char* out, size_t size) {
+    String value = http.header("ETag");
+    return strlcpy(out, value.c_str(), size) < size;
+}
+
+uint32_t SpotifyClient::retryAfter() {
+    return http.header("Retry-After").toInt();
+}
+
+int SpotifyClient::getSize() {
+    return http.getSize();
+}
+
+void SpotifyClient::abort() {
+    client->stop();
+    http.end();
+}
+
+void SpotifyClient::end() {
+    // Lo que no se haya leido del cuerpo (p.ej. el chunk final despues del JSON) romperia la siguiente respuesta
+    chunkedBody.drain();
+    // Con setReuse(true) end() no cierra el socket salvo que el servidor haya pedido "Connection: close"
+    http.end();
+}
+
+void SpotifyClient::setIfNoneMatch(const char* etag) {
+    ifNoneMatch = etag != nullptr ? etag : "";
+}
+
+void SpotifyClient::setAuthorization(const String& value) {
+    // Solo se copia cuando cambia el token, asi el header no se vuelve a armar en cada peticion
+    if (authorization != value)
+        authorization = value;
+}
+
+//========= Stats =========
+
+uint32_t SpotifyClient::requests() const {
+    return requestCount;
+}
+
+uint32_t SpotifyClient::handshakes() const {
+    return handshakeCount;
+}
+
+uint32_t SpotifyClient::handshakesSaved() const {
+    return requestCount - handshakeCount;
+}
+
+void SpotifyClient::printStats() {
+    Serial.printf("[%s] peticiones: %u, handshakes: %u, handshakes ahorrados: %u\n",
+                  host.c_str(), requestCount, handshakeCount, handshakesSaved());
+}
+
+SpotifyClient::SpotifyClient(const char* host, uint16_t port, bool secure) {
+    this->host = host;
+    this->port = port;
+    this->secure = secure;
+    client = secure ? (WiFiClient*)&secureClient : &plainClient;
+
+    requestCount = 0;
+    handshakeCount = 0;
+
+    // Igual que HTTPClient::begin(url) sin certificado: no se valida la cadena del servidor
+    secureClient.setInsecure();
+
+    http.setReuse(true);
+    uri.reserve(64);
+    ifNoneMatch.reserve(64);
+
+    const char* headerKeys[] = {"Transfer-Encoding", "Retry-After", "ETag"};
+    http.collectHeaders(headerKeys, 3);
+    chunked = false;
+}
+
+SpotifyClient::~SpotifyClient() {
+    http.end();
+    client->stop();
+}
@@ -0,0 +1,81 @@
+#ifndef SPOTIFYCLIENT_H
+#define SPOTIFYCLIENT_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <HTTPClient.h>
+
+#include "ChunkedStream.h"
+#include "HttpTransport.h"
+#include "Metrics.h"
+
+// Conexion HTTPS persistente contra un unico host (api.spotify.com, accounts.spotify.com, ...).
+// Todas las peticiones comparten el mismo socket TLS mientras el servidor lo mantenga abierto,
+// asi el handshake solo se paga cuando la conexion se cae y se reconecta sola en la siguiente peticion.
+// Con secure = false es HTTP plano (el puente de la LAN).
+class SpotifyClient : public HttpTransport {
+
+  private:
+    WiFiClientSecure secureClient;
+    WiFiClient plainClient;
+    WiFiClient* client;
+    bool secure;
+    HTTPClient http;
+    ChunkedStream chunkedBody;
+    bool chunked;
+
+    String host;
+    uint16_t port;
+    String authorization;
+    String uri;
+    String ifNoneMatch;
+
+    uint32_t requestCount;
+    uint32_t handshakeCount;
+
+    bool connect();
+    int send(const char* method, const char* path, const String& body, const char* contentType);
+
+  public:
+    // Header "Authorization" que se agrega a cada peticion (vacio para no mandarlo)
+    void setAuthorization(const String& value) override;
+    void setIfNoneMatch(const char* etag) override;
+
+    int GET(const char* path) override;
+    int PUT(const char* path, const String& body = "", const char* contentType = nullptr) override;
+    int POST(const char* path, const String& body = "", const char* contentType = nullptr) override;
+
+    // Cuerpo de la ultima respuesta
+    String getString() override;
+    WiFiClient* getStreamPtr();
+
+    // Cuerpo de la ultima respuesta como Stream, ya sin el framing de chunked si lo hubiera.
+    // Permite parsear sin copiar toda la respuesta a un String
+    Stream& getBodyStream() override;
+
+    // Largo del cuerpo segun Content-Length, -1 si no vino
+    int getSize() override;
+
+    bool etag(char* out, size_t size) override;
+
+    // Segundos del header Retry-After de la ultima respuesta (429), 0 si no vino
+    uint32_t retryAfter() override;
+
+    // Libera la peticion actual dejando el socket abierto para la siguiente
+    void end() override;
+
+    // Cierra el socket; para cuando el cuerpo quedo a medio leer
+    void abort() override;
+
+    uint32_t requests() const override;
+    uint32_t handshakes() const;
+    uint32_t handshakesSaved() const;
+    void printStats() override;
+
+    SpotifyClient(const char* host, uint16_t port = 443, bool secure = true);
+
+    ~SpotifyClient();
+};
+
+#endif
@@ -0,0 +1,47 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <stddef.h>
+
+// Cola circular sin locks para exactamente un productor y un consumidor (p.ej. tarea de red -> UI).
+// Los elementos se copian al entrar y al salir, asi ninguna de las dos tareas comparte memoria viva.
+template <typename T, size_t N>
+class SpscQueue {
+
+  private:
+    // Un lugar queda siempre libre para distinguir llena de vacia
+    T items[N + 1];
+    std::atomic<size_t> head;  // Solo la escribe el consumidor
+    std::atomic<size_t> tail;  // Solo la escribe el productor
+
+  public:
+    // Productor. Devuelve false si la cola esta llena
+    bool push(const T& item) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        size_t next = (t + 1) % (N + 1);
+        if (next == head.load(std::memory_order_acquire))
+            return false;
+        items[t] = item;
+        tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumidor. Devuelve false si la cola esta vacia
+    bool pop(T& item) {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+        item = items[h];
+        head.store((h + 1) % (N + 1), std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head.load(std::memory_order_acquire) == tail.load(std::memory_order_acquire);
+    }
+
+    SpscQueue() : head(0), tail(0) {}
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include "TftDmaDisplay.h"
+
+//========= LVGL callbacks =========
+
+void TftDmaDisplay::flush(lv_display_t* disp, const lv_area_t* area, uint8_t* px_map) {
+    TftDmaDisplay* self = (TftDmaDisplay*)lv_display_get_user_data(disp);
+    uint32_t w = lv_area_get_width(area);
+    uint32_t h = lv_area_get_height(area);
+
+    uint32_t flushStart = micros();
+
+    // El panel espera RGB565 big endian
+    lv_draw_sw_rgb565_swap(px_map, w * h);
+
+    // pushImageDMA espera a que termine la transferencia anterior antes de arrancar esta
+    uint32_t start = micros();
+    self->tft->dmaWait();
+    self->dmaWaitUs += micros() - start;
+
+    self->tft->pushImageDMA(area->x1, area->y1, w, h, (uint16_t*)px_map);
+
+    // El buffer que se esta mandando no se toca hasta el proximo flush (que espera el DMA);
+    // mientras tanto LVGL dibuja en el otro
+    self->flushes++;
+    self->flushedPixels += w * h;
+    metrics.record(STAGE_FLUSH, micros() - flushStart);
+    lv_display_flush_ready(disp);
+}
+
+// Igual que lv_tft_espi: la rotacion de LVGL se traslada al controlador
+void TftDmaDisplay::resolutionChanged(lv_event_t* e) {
+    lv_display_t* disp = (lv_display_t*)lv_event_get_target(e);
+    TftDmaDisplay* self = (TftDmaDisplay*)lv_display_get_user_data(disp);
+
+    self->waitIdle();
+    switch (lv_display_get_rotation(disp)) {
+        case LV_DISPLAY_ROTATION_0:
+            self->tft->setRotation(0);
+            break;
+        case LV_DISPLAY_ROTATION_90:
+            self->tft->setRotation(1);
+            break;
+        case LV_DISPLAY_ROTATION_180:
+            self->tft->setRotation(2);
+            break;
+        case LV_DISPLAY_ROTATION_270:
+            self->tft->setRotation(3);
+            break;
+    }
+}
+
+void TftDmaDisplay::refreshStart(lv_event_t* e) {
+    TftDmaDisplay* self = (TftDmaDisplay*)lv_event_get_user_data(e);
+    self->frameStartedAt = micros();
+    self->flushesAtStart = self->flushes;
+}
+
+void TftDmaDisplay::refreshReady(lv_event_t* e) {
+    TftDmaDisplay* self = (TftDmaDisplay*)lv_event_get_user_data(e);
+    // Solo cuentan los refrescos que dibujaron algo
+    if (self->flushes == self->flushesAtStart)
+        return;
+    uint32_t us = micros() - self->frameStartedAt;
+    self->frameUs += us;
+    self->frames++;
+    metrics.record(STAGE_RENDER, us);
+}
+
+// Cada widget que cambia marca su area; LVGL despues junta las que se pisan antes de dibujar.
+// Se cuenta lo pedido, sin juntar, para ver que widgets se invalidan de mas
+void TftDmaDisplay::areaInvalidated(lv_event_t* e) {
+    TftDmaDisplay* self = (TftDmaDisplay*)lv_event_get_user_data(e);
+    const lv_area_t* area = (const lv_area_t*)lv_event_get_param(e);
+    if (area == nullptr)
+        return;
+    uint32_t pixels = lv_area_get_size(area);
+    self->invalidatedPixels += pixels;
+    self->invalidations++;
+    metrics.count(COUNTER_INVALIDATED_PIXELS, pixels);
+}
+
+//========= Public =========
+
+lv_display_t* TftDmaDisplay::create(TFT_eSPI& tft, int32_t width, int32_t height, void* buf1, void* buf2, uint32_t size) {
+    this->tft = &tft;
+
+    // Con DMA la transaccion SPI queda abierta todo el tiempo (el tactil usa otro bus)
+    tft.initDMA();
+    tft.startWrite();
+
+    display = lv_display_create(width, height);
+    lv_display_set_user_data(display, this);
+    lv_display_set_flush_cb(display, flush);
+    lv_display_set_buffers(display, buf1, buf2, size, LV_DISPLAY_RENDER_MODE_PARTIAL);
+    lv_display_add_event_cb(display, resolutionChanged, LV_EVENT_RESOLUTION_CHANGED, NULL);
+    lv_display_add_event_cb(display, refreshStart, LV_EVENT_REFR_START, this);
+    lv_display_add_event_cb(display, refreshReady, LV_EVENT_REFR_READY, this);
+    lv_display_add_event_cb(display, areaInvalidated, LV_EVENT_INVALIDATE_AREA, this);
+
+    statsStartedAt = millis();
+    return display;
+}
+
+void TftDmaDisplay::waitIdle() {
+    if (tft != nullptr)
+        tft->dmaWait();
+}
+
+void TftDmaDisplay::printStats() {
+    uint32_t elapsed = millis() - statsStartedAt;
+    if (elapsed == 0)
+        return;
+
+    Serial.printf("[display] %u.%u FPS, render %u us/frame, %u flushes, %u px, esperando DMA %u us\n",
+                  frames * 1000 / elapsed, (frames * 10000 / elapsed) % 10,
+                  frames ? frameUs / frames : 0, flushes, flushedPixels, dmaWaitUs);
+    Serial.printf("[display] invalidado %u px/s en %u areas, enviado %u px/s\n",
+                  (uint32_t)((uint64_t)invalidatedPixels * 1000 / elapsed), invalidations,
+                  (uint32_t)((uint64_t)flushedPixels * 1000 / elapsed));
+
+    frames = 0;
+    flushes = 0;
+    flushedPixels = 0;
+    invalidatedPixels = 0;
+    invalidations = 0;
+    frameUs = 0;
+    dmaWaitUs = 0;
+    statsStartedAt = millis();
+}
+
+TftDmaDisplay::TftDmaDisplay() {
+    tft = nullptr;
+    display = nullptr;
+    frames = 0;
+    flushes = 0;
+    flushedPixels = 0;
+    invalidatedPixels = 0;
+    invalidations = 0;
+    frameUs = 0;
+    dmaWaitUs = 0;
+    frameStartedAt = 0;
+    flushesAtStart = 0;
+    statsStartedAt = 0;
+}
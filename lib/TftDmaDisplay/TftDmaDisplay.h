@@ -0,0 +1,49 @@
+#ifndef TFTDMADISPLAY_H
+#define TFTDMADISPLAY_H
+
+#include <Arduino.h>
+#include <lvgl.h>
+#include <TFT_eSPI.h>
+
+#include "Metrics.h"
+
+// Display de LVGL sobre TFT_eSPI con dos buffers y flush por DMA: mientras el SPI manda una franja,
+// LVGL ya esta dibujando la siguiente en el otro buffer. Reemplaza a lv_tft_espi_create.
+class TftDmaDisplay {
+
+  private:
+    TFT_eSPI* tft;
+    lv_display_t* display;
+
+    uint32_t frames;
+    uint32_t flushes;
+    uint32_t flushedPixels;
+    uint32_t invalidatedPixels;
+    uint32_t invalidations;
+    uint32_t frameUs;
+    uint32_t dmaWaitUs;
+    uint32_t frameStartedAt;
+    uint32_t flushesAtStart;
+    uint32_t statsStartedAt;
+
+    static void flush(lv_display_t* disp, const lv_area_t* area, uint8_t* px_map);
+    static void resolutionChanged(lv_event_t* e);
+    static void refreshStart(lv_event_t* e);
+    static void refreshReady(lv_event_t* e);
+    static void areaInvalidated(lv_event_t* e);
+
+  public:
+    // buf1 y buf2 tienen que poder usarse con DMA (RAM interna), size en bytes cada uno
+    lv_display_t* create(TFT_eSPI& tft, int32_t width, int32_t height, void* buf1, void* buf2, uint32_t size);
+
+    // Espera a que termine el DMA en curso; hay que llamarlo antes de dibujar directo con tft
+    void waitIdle();
+
+    // FPS, tiempo de render por frame, pixeles invalidados y enviados por segundo y tiempo bloqueado
+    // esperando al DMA desde la ultima llamada
+    void printStats();
+
+    TftDmaDisplay();
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include "ThumbPool.h"
+
+//========= Escala =========
+
+uint8_t thumbScaleFor(uint16_t width) {
+    uint8_t scale = 1;
+    while (scale < 8 && width > THUMB_SIZE * scale)
+        scale *= 2;
+    return scale;
+}
+
+//========= Slots =========
+
+void ThumbPool::beginFrame() {
+    frame++;
+}
+
+int ThumbPool::find(uint32_t key) {
+    for (int i = 0; i < THUMB_SLOTS; i++) {
+        if (states[i] != THUMB_FREE && keys[i] == key) {
+            if (lastUsed[i] != frame && states[i] == THUMB_READY)
+                hitCount++;
+            lastUsed[i] = frame;
+            return i;
+        }
+    }
+    return -1;
+}
+
+int ThumbPool::reserve(uint32_t key) {
+    int slot = -1;
+    for (int i = 0; i < THUMB_SLOTS; i++) {
+        if (states[i] == THUMB_FREE) {
+            slot = i;
+            break;
+        }
+        if (states[i] == THUMB_LOADING || lastUsed[i] == frame)
+            continue;
+        if (slot < 0 || lastUsed[i] < lastUsed[slot])
+            slot = i;
+    }
+    if (slot < 0)
+        return -1;
+
+    if (states[slot] != THUMB_FREE)
+        evictionCount++;
+    keys[slot] = key;
+    states[slot] = THUMB_LOADING;
+    lastUsed[slot] = frame;
+    return slot;
+}
+
+void ThumbPool::finish(const ThumbResult& result) {
+    if (result.slot >= THUMB_SLOTS || states[result.slot] != THUMB_LOADING || keys[result.slot] != result.key)
+        return;
+    states[result.slot] = result.ok ? THUMB_READY : THUMB_FAILED;
+    if (result.ok)
+        loadCount++;
+    else
+        failureCount++;
+}
+
+void ThumbPool::release(int slot) {
+    if (states[slot] == THUMB_LOADING)
+        states[slot] = THUMB_FREE;
+}
+
+ThumbState ThumbPool::state(int slot) const {
+    return states[slot];
+}
+
+uint32_t ThumbPool::key(int slot) const {
+    return keys[slot];
+}
+
+uint16_t* ThumbPool::buffer(int slot) {
+    return pixels[slot];
+}
+
+//========= Stats =========
+
+uint32_t ThumbPool::hits() const {
+    return hitCount;
+}
+
+uint32_t ThumbPool::loads() const {
+    return loadCount;
+}
+
+uint32_t ThumbPool::evictions() const {
+    return evictionCount;
+}
+
+uint32_t ThumbPool::failures() const {
+    return failureCount;
+}
+
+uint32_t ThumbPool::bytes() const {
+    return sizeof(pixels);
+}
+
+ThumbPool::ThumbPool() {
+    for (int i = 0; i < THUMB_SLOTS; i++) {
+        keys[i] = 0;
+        states[i] = THUMB_FREE;
+        lastUsed[i] = 0;
+    }
+    frame = 1;
+    hitCount = 0;
+    loadCount = 0;
+    evictionCount = 0;
+    failureCount = 0;
+}
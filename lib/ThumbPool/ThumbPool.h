@@ -0,0 +1,91 @@
+#ifndef THUMBPOOL_H
+#define THUMBPOOL_H
+
+#include <stdint.h>
+
+#include "PlaybackState.h"
+
+// Lado de cada miniatura en pantalla
+#define THUMB_SIZE THUMB_TARGET_SIZE
+
+// Memoria fija para todas las miniaturas decodificadas; con 32 px son 8, algo mas que las filas visibles
+#ifndef THUMB_BUDGET_BYTES
+#define THUMB_BUDGET_BYTES (16 * 1024)
+#endif
+
+#define THUMB_SLOTS (THUMB_BUDGET_BYTES / (THUMB_SIZE * THUMB_SIZE * 2))
+
+enum ThumbState : uint8_t {
+    THUMB_FREE,
+    THUMB_LOADING,  // Lo esta escribiendo la tarea de red
+    THUMB_READY,
+    THUMB_FAILED    // Se recuerda para no volver a pedirla mientras siga en el pool
+};
+
+// UI -> tarea de red: bajar url y decodificarla en el buffer del slot
+struct ThumbRequest {
+    uint8_t slot;
+    uint32_t key;
+    uint16_t width;  // Ancho de la imagen segun spotify
+    uint8_t scale;   // thumbScaleFor(width)
+    char url[sizeof(BrowserItem::thumbUrl)];
+};
+
+// La escala de tjpgd (1, 2, 4, 8) mas chica que deja una imagen de width dentro de THUMB_SIZE
+uint8_t thumbScaleFor(uint16_t width);
+
+// Tarea de red -> UI
+struct ThumbResult {
+    uint8_t slot;
+    uint32_t key;
+    bool ok;
+};
+
+// Miniaturas del navegador en RGB565, en THUMB_SLOTS buffers fijos. El estado lo maneja solo la UI;
+// la tarea de red escribe los pixeles de un slot en THUMB_LOADING y lo devuelve con un ThumbResult.
+// Se desaloja la menos usada, nunca una que se mostro en el frame actual ni una que se esta cargando.
+class ThumbPool {
+
+  private:
+    uint16_t pixels[THUMB_SLOTS][THUMB_SIZE * THUMB_SIZE];
+    uint32_t keys[THUMB_SLOTS];
+    ThumbState states[THUMB_SLOTS];
+    uint32_t lastUsed[THUMB_SLOTS];
+    uint32_t frame;
+
+    uint32_t hitCount;
+    uint32_t loadCount;
+    uint32_t evictionCount;
+    uint32_t failureCount;
+
+  public:
+    // Una vez por cada pasada de la UI sobre las filas visibles
+    void beginFrame();
+
+    // Slot con la miniatura de key (lista, cargando o fallida), -1 si no esta. La marca como usada
+    int find(uint32_t key);
+
+    // Reserva un slot para cargar key. -1 si todos estan en uso en este frame o cargando
+    int reserve(uint32_t key);
+
+    void finish(const ThumbResult& result);
+
+    // Devuelve un slot reservado cuyo pedido no llego a salir (la cola estaba llena)
+    void release(int slot);
+
+    ThumbState state(int slot) const;
+    uint32_t key(int slot) const;
+
+    // La tarea de red escribe aca mientras el slot esta en THUMB_LOADING; la UI lo lee solo en THUMB_READY
+    uint16_t* buffer(int slot);
+
+    uint32_t hits() const;
+    uint32_t loads() const;
+    uint32_t evictions() const;
+    uint32_t failures() const;
+    uint32_t bytes() const;
+
+    ThumbPool();
+};
+
+#endif
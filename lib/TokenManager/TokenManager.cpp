@@ -0,0 +1,196 @@
+#include "TokenManager.h"
+
+#include <ArduinoJson.h>
+#include <time.h>
+
+#include "Metrics.h"
+
+// Antes de esto el reloj todavia no se sincronizo por NTP
+#define VALID_EPOCH 1600000000
+// Cuanto se espera a NTP al arrancar antes de dar por desconocido el vencimiento guardado
+#define CLOCK_SYNC_WAIT_MS 2000
+
+static bool clockSynced() {
+    return time(nullptr) > VALID_EPOCH;
+}
+
+bool TokenManager::begin() {
+    accessToken = preferences->getString("access_token", "");
+    expiresAt = (time_t)preferences->getULong64("token_expiry", 0);
+
+    struct tm timeinfo;
+    if (accessToken.length() > 0 && expiresAt > 0 && !clockSynced())
+        getLocalTime(&timeinfo, CLOCK_SYNC_WAIT_MS);
+
+    time_t now = time(nullptr);
+    if (accessToken.length() > 0 && clockSynced() && expiresAt > now) {
+        authorization = "Bearer " + accessToken;
+        obtainedAt = millis();
+        lifetimeMs = (uint32_t)(expiresAt - now) * 1000UL;
+        generation++;
+
+        if (lifetimeMs > REFRESH_MARGIN_MS) {
+            Serial.printf("Token guardado vigente por %u s mas\n", lifetimeMs / 1000);
+            return true;
+        }
+    } else {
+        accessToken = "";
+    }
+
+    // Sin token, vencido o sin hora para saberlo: se pide uno antes de la primera consulta
+    return refreshIfDue(millis());
+}
+
+const String& TokenManager::authorizationHeader() const {
+    return authorization;
+}
+
+uint32_t TokenManager::currentGeneration() const {
+    return generation;
+}
+
+uint32_t TokenManager::msUntilExpiry(uint32_t now) const {
+    if (accessToken.length() == 0)
+        return 0;
+    uint32_t elapsed = now - obtainedAt;
+    return elapsed < lifetimeMs ? lifetimeMs - elapsed : 0;
+}
+
+bool TokenManager::valid(uint32_t now) const {
+    return msUntilExpiry(now) > 0;
+}
+
+uint32_t TokenManager::msUntilRefresh(uint32_t now) const {
+    uint32_t untilExpiry = msUntilExpiry(now);
+    uint32_t wait = untilExpiry > REFRESH_MARGIN_MS ? untilExpiry - REFRESH_MARGIN_MS : 0;
+
+    // Despues de un fallo se espera aunque el token ya este por vencer, para no martillar accounts
+    uint32_t untilRetry = msUntilRetry(now);
+    return untilRetry > wait ? untilRetry : wait;
+}
+
+uint32_t TokenManager::msUntilRetry(uint32_t now) const {
+    if (retryDelayMs == 0)
+        return 0;
+    uint32_t sinceFailure = now - failedAt;
+    return sinceFailure < retryDelayMs ? retryDelayMs - sinceFailure : 0;
+}
+
+bool TokenManager::refreshIfDue(uint32_t now) {
+    if (msUntilRefresh(now) > 0)
+        return true;
+
+    bool stillValid = valid(now);
+    uint32_t seen = generation;
+
+    xSemaphoreTake(refreshLock, portMAX_DELAY);
+    // Si otra tarea lo renovo mientras se esperaba el lock, se usa ese
+    bool renewed = generation != seen || requestToken();
+    xSemaphoreGive(refreshLock);
+
+    if (renewed && stillValid)
+        proactiveCount++;
+    return renewed;
+}
+
+bool TokenManager::onUnauthorized(uint32_t failedGeneration) {
+    xSemaphoreTake(refreshLock, portMAX_DELAY);
+    // Con el refresh token revocado cada 401 pediria otro: la espera del ultimo fallo vale tambien aca
+    bool renewed = generation != failedGeneration || (msUntilRetry(millis()) == 0 && requestToken());
+    xSemaphoreGive(refreshLock);
+    return renewed;
+}
+
+void TokenManager::onFailure() {
+    failureCount++;
+    metrics.count(COUNTER_TOKEN_FAILURE);
+    failedAt = millis();
+    if (retryDelayMs == 0)
+        retryDelayMs = RETRY_MIN_MS;
+    else if (retryDelayMs < RETRY_MAX_MS / 2)
+        retryDelayMs *= 2;
+    else
+        retryDelayMs = RETRY_MAX_MS;
+}
+
+bool TokenManager::requestToken() {
+    String body = "grant_type=refresh_token&refresh_token=" + refreshToken + "&client_id=" + clientId + "&client_secret=" + clientSecret;
+
+    int httpCode = accounts->POST("/api/token", body, "application/x-www-form-urlencoded");
+
+    if (httpCode != 200) {
+        Serial.printf("Error al refrescar el token, Código HTTP: %d\n", httpCode);
+        accounts->end();
+        onFailure();
+        return false;
+    }
+
+    JsonDocument filter;
+    filter["access_token"] = true;
+    filter["expires_in"] = true;
+
+    JsonDocument doc;
+    DeserializationError error = deserializeJson(doc, accounts->getBodyStream(), DeserializationOption::Filter(filter));
+    accounts->end();
+
+    const char* token = doc["access_token"] | "";
+    if (error || token[0] == '\0') {
+        Serial.println("Respuesta de token invalida");
+        onFailure();
+        return false;
+    }
+
+    store(token, doc["expires_in"] | 3600);
+    retryDelayMs = 0;
+    refreshCount++;
+    metrics.count(COUNTER_TOKEN_REFRESH);
+    Serial.println("Token refrescado");
+    return true;
+}
+
+void TokenManager::store(const String& token, uint32_t expiresIn) {
+    accessToken = token;
+    authorization = "Bearer " + accessToken;
+    obtainedAt = millis();
+    lifetimeMs = expiresIn * 1000UL;
+    generation++;
+
+    // Sin hora de NTP el vencimiento no sirve despues de un reinicio, se guarda 0 y se renueva al arrancar
+    expiresAt = clockSynced() ? time(nullptr) + expiresIn : 0;
+    preferences->putString("access_token", accessToken);
+    preferences->putULong64("token_expiry", (uint64_t)expiresAt);
+}
+
+uint32_t TokenManager::refreshes() const {
+    return refreshCount;
+}
+
+uint32_t TokenManager::failures() const {
+    return failureCount;
+}
+
+void TokenManager::printStats() {
+    Serial.printf("Token: %u renovaciones (%u antes de vencer), %u fallidas, vence en %u s\n",
+                  refreshCount, proactiveCount, failureCount, msUntilExpiry(millis()) / 1000);
+}
+
+TokenManager::TokenManager(HttpTransport& accounts, Preferences& preferences, const String& refreshToken,
+                           const String& clientId, const String& clientSecret) {
+    this->accounts = &accounts;
+    this->preferences = &preferences;
+    this->refreshToken = refreshToken;
+    this->clientId = clientId;
+    this->clientSecret = clientSecret;
+
+    expiresAt = 0;
+    obtainedAt = 0;
+    lifetimeMs = 0;
+    generation = 0;
+    failedAt = 0;
+    retryDelayMs = 0;
+    refreshCount = 0;
+    failureCount = 0;
+    proactiveCount = 0;
+
+    refreshLock = xSemaphoreCreateMutex();
+}
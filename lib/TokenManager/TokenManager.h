@@ -0,0 +1,82 @@
+#ifndef TOKENMANAGER_H
+#define TOKENMANAGER_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+#include "HttpTransport.h"
+
+// Ciclo de vida del access token de spotify. El token se renueva antes de que venza, en los ratos libres
+// de la tarea de red, asi ninguna peticion del usuario se encuentra con un 401.
+// El token y su vencimiento (epoch en segundos) se guardan en Preferences; al arrancar se reusa si sigue vigente.
+class TokenManager {
+
+  private:
+    HttpTransport* accounts;
+    Preferences* preferences;
+    String refreshToken;
+    String clientId;
+    String clientSecret;
+
+    String accessToken;
+    String authorization;  // "Bearer <token>", listo para SpotifyClient::setAuthorization
+    time_t expiresAt;      // 0 si no se conoce (sin token o sin hora de NTP)
+    uint32_t obtainedAt;   // millis() en que se obtuvo el token actual
+    uint32_t lifetimeMs;   // Vigencia segun expires_in
+    uint32_t generation;   // Aumenta con cada token nuevo
+
+    // Reintentos cuando falla la renovacion
+    uint32_t failedAt;
+    uint32_t retryDelayMs;
+
+    SemaphoreHandle_t refreshLock;
+
+    uint32_t refreshCount;
+    uint32_t failureCount;
+    uint32_t proactiveCount;
+
+    bool requestToken();
+    void onFailure();
+    void store(const String& token, uint32_t expiresIn);
+    uint32_t msUntilExpiry(uint32_t now) const;
+
+  public:
+    // Se renueva cuando faltan menos de REFRESH_MARGIN_MS para el vencimiento
+    static const uint32_t REFRESH_MARGIN_MS = 5 * 60 * 1000UL;
+    static const uint32_t RETRY_MIN_MS = 5000;
+    static const uint32_t RETRY_MAX_MS = 5 * 60 * 1000UL;
+
+    // Lee el token guardado. Si no hay, vencio o no se sabe la hora, se pide uno nuevo
+    bool begin();
+
+    // Header "Authorization" con el token actual
+    const String& authorizationHeader() const;
+    uint32_t currentGeneration() const;
+
+    // true si hay un token que se puede usar ahora mismo
+    bool valid(uint32_t now) const;
+
+    // Cuanto falta para la proxima renovacion en segundo plano (0 = ya)
+    uint32_t msUntilRefresh(uint32_t now) const;
+
+    // Despues de un fallo, cuanto falta para poder volver a pedir un token (0 = se puede ya)
+    uint32_t msUntilRetry(uint32_t now) const;
+
+    // Renueva si ya toca. Pensado para la vuelta de la tarea de red, antes de las consultas
+    bool refreshIfDue(uint32_t now);
+
+    // Spotify rechazo el token de la generacion indicada. Si otro ya lo renovo no se vuelve a pedir, y
+    // mientras dure la espera de un fallo anterior devuelve false sin ir a accounts
+    bool onUnauthorized(uint32_t failedGeneration);
+
+    uint32_t refreshes() const;
+    uint32_t failures() const;
+    void printStats();
+
+    TokenManager(HttpTransport& accounts, Preferences& preferences, const String& refreshToken,
+                 const String& clientId, const String& clientSecret);
+};
+
+#endif
@@ -0,0 +1,68 @@
+#include "WifiLink.h"
+
+//========= NetworkLink =========
+
+uint32_t WifiLink::connect(uint32_t attempt) {
+    // Los datos de la red ya estan en secrets.h; asi WiFi.begin no escribe la flash en cada intento
+    WiFi.persistent(false);
+    WiFi.mode(WIFI_STA);
+    WiFi.setAutoReconnect(false);
+
+    WifiFastConnect fast;
+    fastAttempt = attempt == 0 && preferences->getBytes("fast", &fast, sizeof(fast)) == sizeof(fast);
+    if (fastAttempt) {
+        WiFi.config(IPAddress(fast.ip), IPAddress(fast.gateway), IPAddress(fast.subnet), IPAddress(fast.dns));
+        WiFi.begin(ssid, password, fast.channel, fast.bssid);
+        return FAST_TIMEOUT_MS;
+    }
+
+    if (attempt == 1)
+        Serial.println("Reconexion rapida fallida, se busca la red");
+    WiFi.config(INADDR_NONE, INADDR_NONE, INADDR_NONE);
+    WiFi.begin(ssid, password);
+    return TIMEOUT_MS;
+}
+
+bool WifiLink::isUp() {
+    return WiFi.status() == WL_CONNECTED;
+}
+
+void WifiLink::disconnect() {
+    WiFi.disconnect();
+}
+
+void WifiLink::onConnected() {
+    lastFast = fastAttempt;
+
+    // Lo que dio el DHCP queda para la proxima: la mayoria de los routers renuevan la misma IP para la misma MAC
+    if (!fastAttempt) {
+        WifiFastConnect fast;
+        memcpy(fast.bssid, WiFi.BSSID(), sizeof(fast.bssid));
+        fast.channel = WiFi.channel();
+        fast.ip = WiFi.localIP();
+        fast.gateway = WiFi.gatewayIP();
+        fast.subnet = WiFi.subnetMask();
+        fast.dns = WiFi.dnsIP(0);
+        preferences->putBytes("fast", &fast, sizeof(fast));
+    }
+
+    Serial.println("Conectado al WiFi!");
+    Serial.print("Red: ");
+    Serial.println(WiFi.SSID());
+    Serial.print("Direccion IP: ");
+    Serial.println(WiFi.localIP());
+    Serial.print("Fuerza de la señal (RSSI): ");
+    Serial.println(WiFi.RSSI());
+}
+
+bool WifiLink::lastConnectFast() const {
+    return lastFast;
+}
+
+WifiLink::WifiLink(const char* ssid, const char* password, Preferences& preferences) {
+    this->ssid = ssid;
+    this->password = password;
+    this->preferences = &preferences;
+    fastAttempt = false;
+    lastFast = false;
+}
@@ -0,0 +1,50 @@
+#ifndef WIFILINK_H
+#define WIFILINK_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <Preferences.h>
+
+#include "NetworkLink.h"
+
+// Datos de la ultima conexion buena: con el BSSID y el canal no se escanea, con la IP no se espera al DHCP
+struct WifiFastConnect {
+    uint8_t bssid[6];
+    int32_t channel;
+    uint32_t ip;
+    uint32_t gateway;
+    uint32_t subnet;
+    uint32_t dns;
+};
+
+// El WiFi del ESP32 para ConnectivityManager. El primer intento de cada caida reusa la ultima conexion
+// (casi siempre es el mismo AP que se reinicio); los siguientes escanean y piden IP por DHCP.
+// La reconexion automatica del framework queda apagada: los reintentos y la espera los maneja el manager.
+class WifiLink : public NetworkLink {
+
+  private:
+    const char* ssid;
+    const char* password;
+    Preferences* preferences;  // Namespace ya abierto, clave "fast"
+    bool fastAttempt;
+    bool lastFast;
+
+  public:
+    // Si no se asocia en FAST_TIMEOUT_MS (el AP cambio de canal o de BSSID) se vuelve al camino normal.
+    // La IP reusada no se verifica: si el router se la dio a otro equipo, el enlace queda arriba con la IP
+    // en conflicto y recien se pide una por DHCP en la proxima caida que no se resuelva al primer intento
+    static const uint32_t FAST_TIMEOUT_MS = 3000;
+    static const uint32_t TIMEOUT_MS = 10000;
+
+    uint32_t connect(uint32_t attempt) override;
+    bool isUp() override;
+    void disconnect() override;
+    void onConnected() override;
+
+    // Si la ultima conexion salio por el camino rapido
+    bool lastConnectFast() const;
+
+    WifiLink(const char* ssid, const char* password, Preferences& preferences);
+};
+
+#endif
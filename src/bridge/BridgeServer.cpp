@@ -0,0 +1,388 @@
+#include "BridgeServer.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// Un controlador que no lee no puede frenar a los demas mas que esto por mensaje
+#define BRIDGE_SEND_TIMEOUT_MS 2000
+#define BRIDGE_INPUT_MAX 4096
+
+//========= Sockets =========
+
+bool BridgeServer::begin(uint16_t port) {
+    listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listenFd < 0)
+        return false;
+    int one = 1;
+    setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in address = {};
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_ANY);
+    address.sin_port = htons(port);
+    if (bind(listenFd, (struct sockaddr*)&address, sizeof(address)) != 0 || listen(listenFd, 16) != 0) {
+        close(listenFd);
+        listenFd = -1;
+        return false;
+    }
+    Serial.printf("[puente] escuchando en el puerto %u\n", port);
+    return true;
+}
+
+void BridgeServer::accept() {
+    int fd = ::accept(listenFd, nullptr, nullptr);
+    if (fd < 0)
+        return;
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    struct timeval timeout = {BRIDGE_SEND_TIMEOUT_MS / 1000, (BRIDGE_SEND_TIMEOUT_MS % 1000) * 1000};
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+
+    BridgeClientState client = {};
+    client.fd = fd;
+    client.lastSentAt = millis();
+    clients.push_back(client);
+}
+
+void BridgeServer::drop(size_t index) {
+    BridgeClientState& client = clients[index];
+    if (client.subscribed)
+        Serial.printf("[puente] se fue %s\n", client.name.c_str());
+    close(client.fd);
+    clients.erase(clients.begin() + index);
+}
+
+bool BridgeServer::sendRaw(BridgeClientState& client, const std::string& text) {
+    size_t sent = 0;
+    while (sent < text.size()) {
+        ssize_t n = send(client.fd, text.data() + sent, text.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0)
+            return false;
+        sent += n;
+    }
+    byteCount += text.size();
+    client.lastSentAt = millis();
+    return true;
+}
+
+// Lee lo que haya y procesa las lineas completas. false si el controlador cerro
+bool BridgeServer::receive(BridgeClientState& client) {
+    char buff[512];
+    ssize_t n = recv(client.fd, buff, sizeof(buff), 0);
+    if (n <= 0)
+        return false;
+    client.input.append(buff, n);
+    if (client.input.size() > BRIDGE_INPUT_MAX)
+        return false;
+
+    // Pedido de una tapa: se contesta cuando llegan todos los headers y se cierra
+    if (!client.subscribed && client.input.compare(0, 4, "GET ") == 0) {
+        if (client.input.find("\r\n\r\n") == std::string::npos && client.input.find("\n\n") == std::string::npos)
+            return true;
+        serveArt(client, client.input.substr(0, client.input.find_first_of("\r\n")));
+        return false;
+    }
+
+    size_t newline;
+    while ((newline = client.input.find('\n')) != std::string::npos) {
+        std::string line = client.input.substr(0, newline);
+        client.input.erase(0, newline + 1);
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        handleLine(client, line);
+    }
+    return true;
+}
+
+//========= Protocolo =========
+
+void BridgeServer::handleLine(BridgeClientState& client, const std::string& line) {
+    if (line.compare(0, 4, "SUB ") == 0) {
+        client.name = line.substr(4);
+        client.subscribed = true;
+        client.sentAny = false;
+        Serial.printf("[puente] se suscribio %s (%zu controladores)\n", client.name.c_str(), clients.size());
+        sendState(client, millis());
+    } else if (line.compare(0, 4, "CMD ") == 0) {
+        unsigned long seq;
+        int skip, play;
+        int seek = -1, volume = -1;
+        // Los controladores anteriores al seek mandan solo los tres primeros
+        if (sscanf(line.c_str() + 4, "%lu %d %d %d %d", &seq, &skip, &play, &seek, &volume) < 3)
+            return;
+        commandCount++;
+
+        // Se pasan como toques: el coalescer recorta el skip y junta los de todas las pantallas
+        uint32_t local = 0;
+        for (int i = 0; i < skip && i < 10; i++)
+            local = commands->next();
+        for (int i = 0; i > skip && i > -10; i--)
+            local = commands->prev();
+        if (play >= 0)
+            local = commands->setPlaying(play == 1);
+        // Si varias pantallas arrastran a la vez gana la ultima, como en una sola
+        if (seek >= 0)
+            local = commands->seekTo(seek);
+        if (volume >= 0)
+            local = commands->setVolume(volume > 100 ? 100 : volume);
+
+        if (local != 0)
+            client.pendingCommands.push_back({(uint32_t)seq, local});
+        else
+            client.ack = seq;
+    }
+}
+
+// "GET /art/xxxxxxxx HTTP/1.1": se responde como HTTP/1.0 y drop() cierra la conexion
+void BridgeServer::serveArt(BridgeClientState& client, const std::string& request) {
+    uint32_t key = 0;
+    fs::File f;
+    char path[32];
+    if (sscanf(request.c_str(), "GET /art/%8x", &key) == 1 && cache->lookup(key, path, sizeof(path)))
+        f = fs->open(path, "r");
+
+    if (!f) {
+        sendRaw(client, "HTTP/1.0 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n");
+    } else {
+        char header[128];
+        snprintf(header, sizeof(header), "HTTP/1.0 200 OK\r\nContent-Type: image/jpeg\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n", f.size());
+        std::string response = header;
+        uint8_t buff[1024];
+        size_t n;
+        while ((n = f.read(buff, sizeof(buff))) > 0)
+            response.append((const char*)buff, n);
+        f.close();
+        sendRaw(client, response);
+        artServed++;
+    }
+}
+
+// Los textos no pueden traer los separadores del protocolo
+static void appendField(std::string& line, const char* key, const char* value) {
+    line += '\t';
+    line += key;
+    line += '=';
+    for (const char* c = value; *c != '\0'; c++)
+        line += (*c == '\t' || *c == '\n' || *c == '\r') ? ' ' : *c;
+}
+
+static void appendField(std::string& line, const char* key, int32_t value) {
+    char text[16];
+    snprintf(text, sizeof(text), "%d", value);
+    appendField(line, key, text);
+}
+
+// Progreso que el controlador esta mostrando ahora, interpolado desde lo ultimo que se le mando
+static int32_t progressAt(const PlaybackState& state, uint32_t sampledAt, uint32_t now) {
+    return state.progressMs + (state.isPlaying ? (int32_t)(now - sampledAt) : 0);
+}
+
+void BridgeServer::sendState(BridgeClientState& client, uint32_t now) {
+    if (!hasState || !client.subscribed)
+        return;
+
+    const PlaybackState& state = current.state;
+    PlaybackState& sent = client.sent;
+    bool all = !client.sentAny;
+    std::string line = "S";
+
+    if (all || client.sentActive != current.active)
+        appendField(line, "active", current.active ? 1 : 0);
+    if (all || strcmp(sent.id, state.id) != 0)
+        appendField(line, "id", state.id);
+    if (all || strcmp(sent.name, state.name) != 0)
+        appendField(line, "name", state.name);
+    if (all || strcmp(sent.artist, state.artist) != 0)
+        appendField(line, "artist", state.artist);
+    if (all || sent.durationMs != state.durationMs)
+        appendField(line, "dur", state.durationMs);
+    if (all || strcmp(client.sentArt, currentArt) != 0) {
+        appendField(line, "img", currentArt);
+        appendField(line, "w", state.imageWidth);
+    }
+
+    bool playChanged = all || sent.isPlaying != state.isPlaying;
+    if (playChanged)
+        appendField(line, "play", state.isPlaying ? 1 : 0);
+    if (state.volumePercent >= 0 && (all || sent.volumePercent != state.volumePercent))
+        appendField(line, "vol", state.volumePercent);
+
+    int32_t drift = progressAt(state, current.sampledAt, now) - progressAt(sent, client.sentSampledAt, now);
+    if (playChanged || strcmp(sent.id, state.id) != 0 || abs(drift) > BRIDGE_PROGRESS_TOLERANCE_MS) {
+        appendField(line, "prog", state.progressMs);
+        appendField(line, "age", (int32_t)(now - current.sampledAt));
+        client.sentSampledAt = current.sampledAt;
+        sent.progressMs = state.progressMs;
+    }
+
+    if (all || client.sentAck != client.ack)
+        appendField(line, "ack", (int32_t)client.ack);
+
+    if (line.size() == 1)
+        return;
+
+    line += '\n';
+    if (!sendRaw(client, line))
+        return;
+    messageCount++;
+
+    int32_t progressMs = sent.progressMs;
+    sent = state;
+    sent.progressMs = progressMs;
+    client.sentActive = current.active;
+    strlcpy(client.sentArt, currentArt, sizeof(client.sentArt));
+    client.sentAck = client.ack;
+    client.sentAny = true;
+}
+
+//========= Estado =========
+
+void BridgeServer::downloadArt(const char* url) {
+    const char* prefix = "https://i.scdn.co";
+    if (strncmp(url, prefix, strlen(prefix)) != 0)
+        return;
+
+    uint32_t key = ArtCache::keyFor(url);
+    char path[32];
+    if (!cache->lookup(key, path, sizeof(path))) {
+        int httpCode = images->GET(url + strlen(prefix));
+        if (httpCode != 200) {
+            Serial.printf("Error al descargar la tapa, Código HTTP: %d\n", httpCode);
+            images->end();
+            return;
+        }
+
+        // Si el archivo no se pudo escribir entero la tapa no se anuncia: el estado sale sin "img"
+        char temp[32];
+        cache->tempPath(temp, sizeof(temp));
+        fs::File f = fs->open(temp, "w");
+        if (!f) {
+            Serial.printf("[puente] No se pudo abrir %s\n", temp);
+            images->abort();
+            return;
+        }
+        Stream& body = images->getBodyStream();
+        uint8_t buff[1024];
+        size_t n;
+        bool written = true;
+        while (written && (n = body.readBytes(buff, sizeof(buff))) > 0)
+            written = f.write(buff, n) == n;
+        f.close();
+        int32_t size = images->getSize();
+        if (!written) {
+            Serial.printf("[puente] No se pudo escribir %s\n", temp);
+            images->abort();
+            cache->discard();
+            return;
+        }
+        images->end();
+        if (!cache->commit(key, size))
+            return;
+    }
+    snprintf(currentArt, sizeof(currentArt), "/art/%08x", key);
+}
+
+void BridgeServer::onSnapshot(PlaybackSnapshot& snapshot) {
+    current = snapshot;
+    hasState = true;
+
+    // Tema nuevo: primero el texto y el ack, la tapa sale en otro mensaje cuando este en la cache
+    bool newArt = snapshot.active && strcmp(artUrl, snapshot.state.imageUrl) != 0;
+    if (newArt) {
+        strlcpy(artUrl, snapshot.state.imageUrl, sizeof(artUrl));
+        currentArt[0] = '\0';
+    }
+
+    uint32_t now = millis();
+    for (BridgeClientState& client : clients) {
+        while (!client.pendingCommands.empty() && (int32_t)(snapshot.commandSeq - client.pendingCommands.front().second) >= 0) {
+            client.ack = client.pendingCommands.front().first;
+            client.pendingCommands.pop_front();
+        }
+        sendState(client, now);
+    }
+
+    if (newArt) {
+        downloadArt(snapshot.state.imageUrl);
+        now = millis();
+        for (BridgeClientState& client : clients)
+            sendState(client, now);
+    }
+}
+
+void BridgeServer::poll(uint32_t waitMs) {
+    uint32_t now = millis();
+    // Los aciertos de GET /art solo tocan el LRU en RAM; va al disco de vez en cuando
+    cache->flush(now);
+    for (const BridgeClientState& client : clients) {
+        if (!client.subscribed)
+            continue;
+        uint32_t since = now - client.lastSentAt;
+        waitMs = min(waitMs, since >= BRIDGE_HEARTBEAT_MS ? (uint32_t)0 : BRIDGE_HEARTBEAT_MS - since);
+    }
+
+    std::vector<struct pollfd> fds;
+    fds.push_back({listenFd, POLLIN, 0});
+    for (const BridgeClientState& client : clients)
+        fds.push_back({client.fd, POLLIN, 0});
+
+    int ready = ::poll(fds.data(), fds.size(), waitMs);
+    if (ready < 0 && errno != EINTR)
+        Serial.printf("[puente] poll: %s\n", strerror(errno));
+
+    // De atras para adelante: drop() borra del vector
+    for (size_t i = clients.size(); i-- > 0;) {
+        if ((fds[i + 1].revents & (POLLIN | POLLHUP | POLLERR)) && !receive(clients[i]))
+            drop(i);
+    }
+    if (fds[0].revents & POLLIN)
+        accept();
+
+    now = millis();
+    for (size_t i = clients.size(); i-- > 0;) {
+        BridgeClientState& client = clients[i];
+        if (client.subscribed && now - client.lastSentAt >= BRIDGE_HEARTBEAT_MS && !sendRaw(client, "P\n"))
+            drop(i);
+    }
+}
+
+//========= Stats =========
+
+size_t BridgeServer::clientCount() const {
+    return clients.size();
+}
+
+void BridgeServer::printStats() {
+    Serial.printf("[puente] %zu controladores, %u mensajes de estado, %u bytes, %u comandos, %u tapas servidas\n",
+                  clients.size(), messageCount, byteCount, commandCount, artServed);
+    cache->printStats();
+}
+
+BridgeServer::BridgeServer(CommandCoalescer& commands, HttpTransport& images, ArtCache& cache, fs::FS& fs) {
+    listenFd = -1;
+    this->commands = &commands;
+    this->images = &images;
+    this->cache = &cache;
+    this->fs = &fs;
+
+    hasState = false;
+    memset(&current, 0, sizeof(current));
+    currentArt[0] = '\0';
+    artUrl[0] = '\0';
+
+    messageCount = 0;
+    byteCount = 0;
+    commandCount = 0;
+    artServed = 0;
+}
+
+BridgeServer::~BridgeServer() {
+    for (const BridgeClientState& client : clients)
+        close(client.fd);
+    if (listenFd >= 0)
+        close(listenFd);
+}
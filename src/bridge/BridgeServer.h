@@ -0,0 +1,85 @@
+#ifndef BRIDGESERVER_H
+#define BRIDGESERVER_H
+
+#include <Arduino.h>
+#include <FS.h>
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "ArtCache.h"
+#include "BridgeProtocol.h"
+#include "CommandCoalescer.h"
+#include "HttpTransport.h"
+#include "PlayerSession.h"
+
+// Lo que el puente ya le mando a un controlador, para mandarle solo lo que cambio
+struct BridgeClientState {
+    int fd;
+    std::string name;
+    std::string input;
+    bool subscribed;
+
+    bool sentAny;
+    PlaybackState sent;
+    bool sentActive;
+    char sentArt[16];
+    uint32_t sentSampledAt;
+    uint32_t sentAck;
+    uint32_t lastSentAt;
+
+    // CMD del controlador -> secuencia del CommandCoalescer del puente, hasta que el estado lo refleje
+    std::deque<std::pair<uint32_t, uint32_t>> pendingCommands;
+    uint32_t ack;
+};
+
+// Servidor del puente: recibe el estado de PlayerSession (es su PlayerListener), baja la tapa una sola vez
+// y manda a cada controlador suscripto solo los campos que cambiaron. Los CMD de todos los controladores
+// van al mismo CommandCoalescer, asi varios toques de distintas pantallas siguen siendo una sola llamada.
+class BridgeServer : public PlayerListener {
+
+  private:
+    int listenFd;
+    std::vector<BridgeClientState> clients;
+
+    CommandCoalescer* commands;
+    HttpTransport* images;
+    ArtCache* cache;
+    fs::FS* fs;
+
+    bool hasState;
+    PlaybackSnapshot current;
+    char currentArt[16];  // "/art/xxxxxxxx" o vacio
+    char artUrl[sizeof(PlaybackState::imageUrl)];
+
+    uint32_t messageCount;
+    uint32_t byteCount;
+    uint32_t commandCount;
+    uint32_t artServed;
+
+    void accept();
+    void drop(size_t index);
+    bool receive(BridgeClientState& client);
+    void handleLine(BridgeClientState& client, const std::string& line);
+    void serveArt(BridgeClientState& client, const std::string& request);
+    void downloadArt(const char* url);
+    void sendState(BridgeClientState& client, uint32_t now);
+    bool sendRaw(BridgeClientState& client, const std::string& text);
+
+  public:
+    // Abre el puerto; false si no se pudo
+    bool begin(uint16_t port);
+
+    void onSnapshot(PlaybackSnapshot& snapshot) override;
+
+    // Atiende sockets hasta waitMs o hasta que un controlador mande un comando
+    void poll(uint32_t waitMs);
+
+    size_t clientCount() const;
+    void printStats();
+
+    BridgeServer(CommandCoalescer& commands, HttpTransport& images, ArtCache& cache, fs::FS& fs);
+    ~BridgeServer();
+};
+
+#endif
@@ -0,0 +1,185 @@
+#include "CurlTransport.h"
+
+#include <strings.h>
+
+//========= Callbacks de curl =========
+
+size_t CurlTransport::onBody(char* data, size_t size, size_t count, void* user) {
+    CurlTransport* self = (CurlTransport*)user;
+    self->responseBody.append(data, size * count);
+    return size * count;
+}
+
+// Cada header llega entero, con el \r\n
+size_t CurlTransport::onHeader(char* data, size_t size, size_t count, void* user) {
+    CurlTransport* self = (CurlTransport*)user;
+    size_t length = size * count;
+    std::string line(data, length);
+    while (!line.empty() && (line.back() == '\r' || line.back() == '\n'))
+        line.pop_back();
+
+    size_t colon = line.find(':');
+    if (colon == std::string::npos)
+        return length;
+    std::string value = line.substr(colon + 1);
+    value.erase(0, value.find_first_not_of(' '));
+
+    if (strncasecmp(line.c_str(), "ETag", colon) == 0 && colon == 4)
+        self->responseEtag = value;
+    else if (strncasecmp(line.c_str(), "Retry-After", colon) == 0 && colon == 11)
+        self->responseRetryAfter = strtoul(value.c_str(), nullptr, 10);
+    else if (strncasecmp(line.c_str(), "Content-Length", colon) == 0 && colon == 14)
+        self->responseSize = strtol(value.c_str(), nullptr, 10);
+    return length;
+}
+
+//========= Requests =========
+
+int CurlTransport::send(const char* method, const char* path, const String& body, const char* contentType) {
+    requestCount++;
+    responseBody.clear();
+    responseEtag.clear();
+    responseRetryAfter = 0;
+    responseSize = -1;
+    readPosition = 0;
+
+    std::string url = "https://" + host + path;
+    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+
+    if (headers != nullptr)
+        curl_slist_free_all(headers);
+    headers = nullptr;
+    if (!authorization.empty())
+        headers = curl_slist_append(headers, ("Authorization: " + authorization).c_str());
+    if (!ifNoneMatch.empty() && strcmp(method, "GET") == 0)
+        headers = curl_slist_append(headers, ("If-None-Match: " + ifNoneMatch).c_str());
+    ifNoneMatch.clear();
+    if (contentType != nullptr)
+        headers = curl_slist_append(headers, (std::string("Content-Type: ") + contentType).c_str());
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+
+    if (strcmp(method, "GET") == 0) {
+        curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, nullptr);
+    } else {
+        // Con un cuerpo vacio curl igual manda Content-Length: 0, que es lo que pide spotify
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, (long)body.length());
+        curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, body.c_str());
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method);
+    }
+
+    CURLcode result = curl_easy_perform(curl);
+    if (result != CURLE_OK) {
+        Serial.printf("[%s] %s\n", host.c_str(), curl_easy_strerror(result));
+        return -1;
+    }
+
+    long connects = 0;
+    curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &connects);
+    connectCount += connects;
+
+    long status = 0;
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &status);
+    return status;
+}
+
+int CurlTransport::GET(const char* path) {
+    return send("GET", path, "", nullptr);
+}
+
+int CurlTransport::PUT(const char* path, const String& body, const char* contentType) {
+    return send("PUT", path, body, contentType);
+}
+
+int CurlTransport::POST(const char* path, const String& body, const char* contentType) {
+    return send("POST", path, body, contentType);
+}
+
+String CurlTransport::getString() {
+    return String(responseBody.c_str());
+}
+
+Stream& CurlTransport::getBodyStream() {
+    return body;
+}
+
+int CurlTransport::getSize() {
+    return responseSize;
+}
+
+bool CurlTransport::etag(char* out, size_t size) {
+    return strlcpy(out, responseEtag.c_str(), size) < size;
+}
+
+uint32_t CurlTransport::retryAfter() {
+    return responseRetryAfter;
+}
+
+void CurlTransport::end() {
+    responseBody.clear();
+    readPosition = 0;
+}
+
+// El cuerpo ya esta entero en memoria; no hace falta cerrar la conexion
+void CurlTransport::abort() {
+    end();
+}
+
+void CurlTransport::setAuthorization(const String& value) {
+    authorization = value.c_str();
+}
+
+void CurlTransport::setIfNoneMatch(const char* etag) {
+    ifNoneMatch = etag != nullptr ? etag : "";
+}
+
+int CurlTransport::BodyStream::available() {
+    return owner->responseBody.size() - owner->readPosition;
+}
+
+int CurlTransport::BodyStream::read() {
+    if (owner->readPosition >= owner->responseBody.size())
+        return -1;
+    return (uint8_t)owner->responseBody[owner->readPosition++];
+}
+
+int CurlTransport::BodyStream::peek() {
+    if (owner->readPosition >= owner->responseBody.size())
+        return -1;
+    return (uint8_t)owner->responseBody[owner->readPosition];
+}
+
+//========= Stats =========
+
+uint32_t CurlTransport::requests() const {
+    return requestCount;
+}
+
+void CurlTransport::printStats() {
+    Serial.printf("[%s] peticiones: %u, conexiones: %u\n", host.c_str(), requestCount, connectCount);
+}
+
+CurlTransport::CurlTransport(const char* host) {
+    this->host = host;
+    headers = nullptr;
+    responseRetryAfter = 0;
+    responseSize = -1;
+    readPosition = 0;
+    body.owner = this;
+    requestCount = 0;
+    connectCount = 0;
+
+    curl = curl_easy_init();
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, onBody);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, this);
+    curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, onHeader);
+    curl_easy_setopt(curl, CURLOPT_HEADERDATA, this);
+    curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+}
+
+CurlTransport::~CurlTransport() {
+    if (headers != nullptr)
+        curl_slist_free_all(headers);
+    curl_easy_cleanup(curl);
+}
@@ -0,0 +1,68 @@
+#ifndef CURLTRANSPORT_H
+#define CURLTRANSPORT_H
+
+#include <Arduino.h>
+#include <curl/curl.h>
+#include <string>
+
+#include "HttpTransport.h"
+
+// HttpTransport de Linux para el puente: HTTPS con libcurl contra un unico host. Un handle por host,
+// asi curl reutiliza la conexion como SpotifyClient en el ESP32. El cuerpo entero queda en memoria.
+class CurlTransport : public HttpTransport {
+
+  private:
+    CURL* curl;
+    struct curl_slist* headers;
+    std::string host;
+    std::string authorization;
+    std::string ifNoneMatch;
+
+    std::string responseBody;
+    std::string responseEtag;
+    uint32_t responseRetryAfter;
+    int32_t responseSize;
+    size_t readPosition;
+
+    class BodyStream : public Stream {
+
+      public:
+        CurlTransport* owner;
+
+        size_t write(uint8_t c) override { return 0; }
+        int available() override;
+        int read() override;
+        int peek() override;
+    } body;
+
+    uint32_t requestCount;
+    uint32_t connectCount;
+
+    static size_t onBody(char* data, size_t size, size_t count, void* user);
+    static size_t onHeader(char* data, size_t size, size_t count, void* user);
+    int send(const char* method, const char* path, const String& body, const char* contentType);
+
+  public:
+    void setAuthorization(const String& value) override;
+    void setIfNoneMatch(const char* etag) override;
+
+    int GET(const char* path) override;
+    int PUT(const char* path, const String& body = "", const char* contentType = nullptr) override;
+    int POST(const char* path, const String& body = "", const char* contentType = nullptr) override;
+
+    String getString() override;
+    Stream& getBodyStream() override;
+    int getSize() override;
+    bool etag(char* out, size_t size) override;
+    uint32_t retryAfter() override;
+    void end() override;
+    void abort() override;
+
+    uint32_t requests() const override;
+    void printStats() override;
+
+    CurlTransport(const char* host);
+    ~CurlTransport();
+};
+
+#endif
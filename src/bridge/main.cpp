@@ -0,0 +1,121 @@
+// env:bridge: puente de la LAN para varias pantallas en la misma cuenta. Consulta a spotify una sola vez
+// (la misma PlayerSession que corre en el ESP32), baja cada tapa una vez y le manda a cada controlador
+// solo lo que cambio. Ver lib/BridgeClient/BridgeProtocol.h para el protocolo.
+//
+//   SPOTIFY_REFRESH_TOKEN=... SPOTIFY_CLIENT_ID=... SPOTIFY_CLIENT_SECRET=... program [--port 4680] [--fs dir]
+//   program --mock [--scenario archivo] [--port 4680] [--fs dir]
+//
+// Con --mock consulta al spotify falso de env:native en tiempo real; para probar en una sola maquina
+// junto con los controladores simulados (env:native --clients).
+
+#include <Arduino.h>
+#include <FS.h>
+#include <Preferences.h>
+
+#include <memory>
+
+#include "BridgeServer.h"
+#include "CurlTransport.h"
+#include "../native/MockSpotify.h"
+#include "NativeClock.h"
+#include "PlayerSession.h"
+#include "TokenManager.h"
+#include "CommandCoalescer.h"
+#include "ArtCache.h"
+#include "Metrics.h"
+
+// El puente tiene disco de sobra, pero la tapa solo sirve mientras suena
+#define ART_CACHE_BUDGET_BYTES (4 * 1024 * 1024)
+#define STATS_INTERVAL_MS 60000
+
+int main(int argc, char** argv) {
+    // El log del puente suele ir a un archivo o a journald
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+
+    bool useMock = false;
+    const char* scenario = nullptr;
+    const char* fsRoot = ".bridge_fs";
+    uint16_t port = BRIDGE_PORT;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mock") == 0)
+            useMock = true;
+        else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc)
+            scenario = argv[++i];
+        else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc)
+            port = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--fs") == 0 && i + 1 < argc)
+            fsRoot = argv[++i];
+        else {
+            fprintf(stderr, "uso: %s [--mock [--scenario archivo]] [--port %u] [--fs dir]\n", argv[0], BRIDGE_PORT);
+            return 2;
+        }
+    }
+
+    const char* refreshToken = getenv("SPOTIFY_REFRESH_TOKEN");
+    const char* clientId = getenv("SPOTIFY_CLIENT_ID");
+    const char* clientSecret = getenv("SPOTIFY_CLIENT_SECRET");
+    if (!useMock && (refreshToken == nullptr || clientId == nullptr || clientSecret == nullptr)) {
+        fprintf(stderr, "faltan SPOTIFY_REFRESH_TOKEN, SPOTIFY_CLIENT_ID o SPOTIFY_CLIENT_SECRET (o usar --mock)\n");
+        return 2;
+    }
+
+    // Los mismos tres hosts que el ESP32, reales o del mock
+    MockSpotify mock;
+    std::unique_ptr<HttpTransport> api, accounts, images;
+    if (useMock) {
+        if (scenario != nullptr && !mock.load(scenario))
+            return 1;
+        mock.loadDefaults();
+        // El puente corre hasta que lo corten
+        mock.setDuration(UINT64_MAX);
+        api.reset(new MockTransport(mock, "api"));
+        accounts.reset(new MockTransport(mock, "accounts"));
+        images.reset(new MockTransport(mock, "images"));
+        refreshToken = "mock-refresh-token";
+        clientId = "mock-client-id";
+        clientSecret = "mock-client-secret";
+    } else {
+        curl_global_init(CURL_GLOBAL_DEFAULT);
+        api.reset(new CurlTransport("api.spotify.com"));
+        accounts.reset(new CurlTransport("accounts.spotify.com"));
+        images.reset(new CurlTransport("i.scdn.co"));
+    }
+
+    Preferences preferences;
+    preferences.begin("spotify", false);
+    TokenManager tokens(*accounts, preferences, refreshToken, clientId, clientSecret);
+
+    fs::FS hostFs(fsRoot);
+    ArtCache artCache(hostFs, "/art", ART_CACHE_BUDGET_BYTES);
+    artCache.begin();
+
+    CommandCoalescer commands;
+    BridgeServer server(commands, *images, artCache, hostFs);
+    if (!server.begin(port)) {
+        fprintf(stderr, "no se pudo abrir el puerto %u\n", port);
+        return 1;
+    }
+
+    PlayerSession session(*api, tokens, commands, server);
+    session.begin();
+
+    uint32_t lastStats = millis();
+    for (;;) {
+        uint32_t wait = session.step();
+
+        // Un CMD de cualquier controlador corta la espera y la proxima vuelta lo manda
+        server.poll(wait);
+
+        if (millis() - lastStats >= STATS_INTERVAL_MS) {
+            api->printStats();
+            accounts->printStats();
+            images->printStats();
+            tokens.printStats();
+            session.printStats();
+            server.printStats();
+            metrics.printCompact(Serial);
+            lastStats = millis();
+        }
+    }
+}
@@ -8,14 +8,32 @@
 #include <Preferences.h>
 #include <TJpg_Decoder.h>
 #include <FS.h>
+#include <esp_pm.h>
 #include "secrets.h"
 
 #include "RGBLedController.h"
-
-#include <iostream>
-#include <iomanip>   // Para setw y setfill
-#include <sstream>   // Para ostringstream
-#include <string>
+#include "SpotifyClient.h"
+#include "PlaybackState.h"
+#include "SpscQueue.h"
+#include "CommandCoalescer.h"
+#include "ArtDecoder.h"
+#include "ArtCache.h"
+#include "ArtPalette.h"
+#include "TftDmaDisplay.h"
+#include "PollScheduler.h"
+#include "ProgressClock.h"
+#include "TokenManager.h"
+#include "PlayerSession.h"
+#include "PlaybackView.h"
+#include "HeapMonitor.h"
+#include "Metrics.h"
+#include "PlaybackStore.h"
+#include "ConnectivityManager.h"
+#include "WifiLink.h"
+#include "BrowserController.h"
+#ifdef BRIDGE_HOST
+#include "BridgeClient.h"
+#endif
 
 //========= Touch Screen =========
 // Touchscreen pins
@@ -26,7 +44,8 @@
 #define XPT2046_CS 33    // T_CS
 
 SPIClass touchscreenSPI = SPIClass(VSPI);
-XPT2046_Touchscreen touchscreen(XPT2046_CS, XPT2046_IRQ);
+// Sin el pin de IRQ: la interrupcion la maneja onTouchIrq para despertar a la UI
+XPT2046_Touchscreen touchscreen(XPT2046_CS);
 
 #define SCREEN_WIDTH 240
 #define SCREEN_HEIGHT 320
@@ -34,10 +53,52 @@ XPT2046_Touchscreen touchscreen(XPT2046_CS, XPT2046_IRQ);
 // Touchscreen coordinates: (x, y) and pressure (z)
 int x, y, z;
 
+//========= Despertar la UI =========
+// loop() duerme hasta que pasa algo: un toque (IRQ del XPT2046), un snapshot o un bloque de tapa
+// de la tarea de red, o el proximo timer de LVGL. Entre medio el core queda libre
+
+// Tope de cada siesta, tambien es la demora maxima para atender un comando por el puerto serie
+#define UI_MAX_SLEEP_MS 1000
+// Con el dedo apoyado se lee el tactil a este ritmo para seguir arrastres y detectar cuando se suelta
+#define TOUCH_READ_MS 10
+// Frecuencia minima de la CPU entre eventos, si el framework trae el manejo de energia (CONFIG_PM_ENABLE)
+#ifndef UI_MIN_CPU_MHZ
+#define UI_MIN_CPU_MHZ 80
+#endif
+
+TaskHandle_t uiTaskHandle = NULL;
+lv_indev_t * touchIndev;
+volatile bool touchIrq = false;
+bool touchPressed = false;
+
+// Tiempo que loop() paso durmiendo, para el porcentaje de inactividad
+uint32_t uiSleptUs = 0;
+uint32_t uiStatsStartedAt = 0;
+
+// PENIRQ baja cuando se apoya el dedo
+static void IRAM_ATTR onTouchIrq() {
+  touchIrq = true;
+  BaseType_t woken = pdFALSE;
+  if (uiTaskHandle != NULL)
+    vTaskNotifyGiveFromISR(uiTaskHandle, &woken);
+  portYIELD_FROM_ISR(woken);
+}
+
+// Desde la tarea de red, despues de dejarle algo en una cola
+static void wakeUi() {
+  if (uiTaskHandle != NULL)
+    xTaskNotifyGive(uiTaskHandle);
+}
+
+static uint32_t uiTickMs() {
+  return millis();
+}
+
 // Get the Touchscreen data
 void touchscreen_read(lv_indev_t * indev, lv_indev_data_t * data) {
-  // Checks if Touchscreen was touched, and prints X, Y and Pressure (Z)
-  if(touchscreen.tirqTouched() && touchscreen.touched()) {
+  // PENIRQ queda en bajo mientras hay un dedo apoyado: si esta en alto no hace falta hablar por SPI
+  touchPressed = digitalRead(XPT2046_IRQ) == LOW && touchscreen.touched();
+  if(touchPressed) {
     // Get Touchscreen points
     TS_Point p = touchscreen.getPoint();
     // Calibrate Touchscreen points with map function to the correct width and height
@@ -67,65 +128,107 @@ void touchscreen_read(lv_indev_t * indev, lv_indev_data_t * data) {
 
 //========= LVGL =========
 
-#define DRAW_BUF_SIZE (SCREEN_WIDTH * SCREEN_HEIGHT / 10 * (LV_COLOR_DEPTH / 8))
-uint32_t draw_buf[DRAW_BUF_SIZE / 4];
+// Lineas de cada uno de los dos buffers de render (se puede cambiar con -D DRAW_BUF_LINES=...)
+#ifndef DRAW_BUF_LINES
+#define DRAW_BUF_LINES 32
+#endif
+
+// SCREEN_HEIGHT es el lado largo, que despues de rotar es el ancho de cada franja
+#define DRAW_BUF_SIZE (SCREEN_HEIGHT * DRAW_BUF_LINES * (LV_COLOR_DEPTH / 8))
+DMA_ATTR uint32_t draw_buf_1[DRAW_BUF_SIZE / 4];
+DMA_ATTR uint32_t draw_buf_2[DRAW_BUF_SIZE / 4];
+
+TftDmaDisplay tftDisplay;
 
 //========= Spotify =========
 
 lv_obj_t * song_title;
 lv_obj_t * artist;
 lv_obj_t * play_pause_button;
+lv_obj_t * play_pause_label;
 
 lv_obj_t *progress;
 lv_obj_t *duration;
 
+// Slider: se puede arrastrar para mover la posicion
 lv_obj_t *progress_bar;
+lv_obj_t *volume_slider;
 
-String current_song_id = "";
-String current_playing_state = "";
-String artworkURL = "";
+// Mientras el dedo esta sobre un slider, ni el timer ni las consultas lo mueven
+bool seekDragging = false;
+bool volumeDragging = false;
 
-volatile int32_t progress_ms = 0;
-volatile int32_t duration_ms = 1;
+// Aviso de sin conexion; la pantalla sigue con el ultimo estado mientras la tarea de red reconecta
+lv_obj_t *offline_icon;
+bool offlineShown = false;
 
-String accessToken = "";
+// Estado que muestra la pantalla. Buffers fijos para que el camino de cada consulta no use el heap;
+// los labels de titulo y artista apuntan directo a shownView.name y shownView.artist
+PlaybackView shownView;
 
-RGBLedController ledController;
+// Textos de los labels de tiempo (lv_label_set_text_static, LVGL no los copia)
+char progressText[8] = "00:00";
+char durationText[8] = "00:00";
 
-//========= WIFI =========
+// Progreso interpolado con millis() entre consultas
+ProgressClock progressClock;
+// Solo corre mientras suena algo
+lv_timer_t * progressTimer = NULL;
 
-void connectToWifi(const char* ssid, const char* password) {
-  Serial.println("Conectando al WiFi...");
+RGBLedController ledController;
 
-  ledController.setLedRed();
+// Se pueden redefinir con build_flags para apuntar a un servidor HTTPS local de pruebas
+#ifndef SPOTIFY_API_HOST
+#define SPOTIFY_API_HOST "api.spotify.com"
+#endif
+#ifndef SPOTIFY_ACCOUNTS_HOST
+#define SPOTIFY_ACCOUNTS_HOST "accounts.spotify.com"
+#endif
+#ifndef SPOTIFY_PORT
+#define SPOTIFY_PORT 443
+#endif
+#ifndef SPOTIFY_IMAGES_HOST
+#define SPOTIFY_IMAGES_HOST "i.scdn.co"
+#endif
+
+// Una conexion keep-alive por host, compartida por todas las peticiones
+SpotifyClient spotifyApi(SPOTIFY_API_HOST, SPOTIFY_PORT);
+SpotifyClient spotifyAccounts(SPOTIFY_ACCOUNTS_HOST, SPOTIFY_PORT);
+SpotifyClient spotifyImages(SPOTIFY_IMAGES_HOST, SPOTIFY_PORT);
+
+// Modo puente (-DBRIDGE_HOST=\"192.168.1.10\"): el estado y las tapas llegan del puente de la LAN (src/bridge)
+// y solo se consulta a spotify mientras el puente no contesta
+#ifdef BRIDGE_HOST
+#ifndef BRIDGE_NAME
+#define BRIDGE_NAME "controlador"
+#endif
+WiFiClient bridgeSocket;
+SpotifyClient bridgeArt(BRIDGE_HOST, BRIDGE_PORT, false);
+#endif
+
+//========= WIFI =========
 
-  // Connect to Wi-Fi network
-  WiFi.begin(ssid, password);
+TaskHandle_t networkTaskHandle = NULL;
 
-  // Wait for the connection
-  int cicles = 0;
-  while (WiFi.status() != WL_CONNECTED) {
-    if (cicles == 10)
-      ESP.restart();
-    delay(1000);
-    cicles++;
-    Serial.println("Conectando...");
-  }
+Preferences wifiPreferences;
+WifiLink wifiLink(ssid, password, wifiPreferences);
 
-  ledController.setLedGreen();
+// Sin red no se reinicia: reconecta en segundo plano y la UI sigue con el ultimo estado
+ConnectivityManager connectivity(wifiLink);
 
-  // Once connected, print the local IP address
-  Serial.println("Conectado al WiFi!");
-  Serial.print("Red: ");
-  Serial.println(WiFi.SSID());
-  Serial.print("Direccion IP: ");
-  Serial.println(WiFi.localIP());
-  Serial.print("Fuerza de la señal (RSSI): ");
-  Serial.println(WiFi.RSSI());
+// Lo escribe la tarea de red, lo lee la UI para mostrar el aviso de sin conexion
+volatile bool linkOnline = false;
 
-  delay(1000);
+// Tiempos de arranque en ms desde el reset; los completan la tarea de red y la UI
+uint32_t bootWifiMs = 0;
+bool bootWifiFast = false;
 
-  ledController.turnOffLed();
+// Corre en la tarea de eventos del WiFi: solo despierta a la tarea de red para que lo vea el manager
+static void onWifiEvent(arduino_event_id_t event) {
+  if (event == ARDUINO_EVENT_WIFI_STA_DISCONNECTED || event == ARDUINO_EVENT_WIFI_STA_GOT_IP) {
+    if (networkTaskHandle != NULL)
+      xTaskNotifyGive(networkTaskHandle);
+  }
 }
 
 // If logging is enabled, it will inform the user about what is happening in the library
@@ -140,11 +243,34 @@ void log_print(lv_log_level_t level, const char * buf) {
 
 TFT_eSPI tft = TFT_eSPI(); 
 
+// Esquina de la tapa en pantalla
+#define ART_X 5
+#define ART_Y 5
+
+// Borde derecho e inferior (exclusivos) de lo que ya se dibujo de la tapa: al cambiar el fondo se
+// invalida solo lo que queda afuera
+int16_t artRight = 0;
+int16_t artBottom = 0;
+
+// Cuando la UI decodifica la tapa con TJpgDec (poco heap) los colores salen de estos mismos bloques
+ArtPalette uiArtPalette;
+bool uiArtPaletteActive = false;
+
 bool tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap)
 {
   // Stop further decoding as image is running off bottom of screen
   if ( y >= tft.height() ) return 0;
 
+  if (x + w > artRight)
+    artRight = x + w;
+  if (y + h > artBottom)
+    artBottom = y + h;
+  if (uiArtPaletteActive)
+    uiArtPalette.add(x - ART_X, y - ART_Y, w, h, bitmap, true);
+
+  // LVGL puede tener un flush por DMA en curso
+  tftDisplay.waitIdle();
+
   // This function will clip the image block rendering automatically at the TFT boundaries
   tft.pushImage(x, y, w, h, bitmap);
 
@@ -155,260 +281,1011 @@ bool tft_output(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap)
 //========= Access Token =========
 Preferences preferences;
 
-bool tokenSaved() {
-  String token = preferences.getString("access_token", "");
-  return token.length() > 0;  // Retorna true si el token no está vacío
+// Hora real para saber si el token guardado sigue vigente despues de un reinicio
+#define NTP_SERVER "pool.ntp.org"
+
+TokenManager tokenManager(spotifyAccounts, preferences, refreshToken, clientId, clientSecret);
+
+// "mm:ss" en un buffer del que llama
+void formatMinutesSeconds(int32_t ms, char* out, size_t size) {
+  int32_t totalSegundos = ms / 1000;
+  int minutos = totalSegundos / 60;
+  int segundos = totalSegundos % 60;
+
+  snprintf(out, size, "%02d:%02d", minutos, segundos);
 }
 
-void saveAccessToken(String token) {
-  preferences.putString("access_token", token);
-  Serial.println("Access Token guardado correctamente.");
+// Solo los labels de la mascara: cada set_text invalida su area aunque el texto sea el mismo
+void updateSongInfo(uint8_t widgets) {
+  if (widgets & WIDGET_TITLE) {
+    Serial.printf("Nombre: %s\n", shownView.name);
+    lv_label_set_text_static(song_title, shownView.name);
+  }
+  if (widgets & WIDGET_ARTIST) {
+    Serial.printf("Artista: %s\n", shownView.artist);
+    lv_label_set_text_static(artist, shownView.artist);
+  }
+  if (widgets & WIDGET_DURATION) {
+    formatMinutesSeconds(shownView.durationSeconds * 1000, durationText, sizeof(durationText));
+    lv_label_set_text_static(duration, durationText);
+  }
 }
 
-String readAccessToken() {
-  return preferences.getString("access_token", "");
+// El label del boton se crea una vez en drawMainGui; aca solo cambia el simbolo
+void updatePlayPauseButton() {
+  // LVGL ya trae parte de los simbolos de FontAwesome
+  lv_label_set_text_static(play_pause_label, shownView.playState == PLAY_STATE_PLAYING ? LV_SYMBOL_PAUSE : LV_SYMBOL_PLAY);
+
+  // En pausa el progreso no se mueve, asi que su timer tampoco despierta a la UI
+  if (shownView.playState == PLAY_STATE_PLAYING)
+    lv_timer_resume(progressTimer);
+  else
+    lv_timer_pause(progressTimer);
 }
 
-String getNewAccessToken() {
-  HTTPClient http;
-  http.begin("https://accounts.spotify.com/api/token");
-  http.addHeader("Content-Type", "application/x-www-form-urlencoded");
-  String body = "grant_type=refresh_token&refresh_token=" + refreshToken + "&client_id=" + clientId + "&client_secret=" + clientSecret;
+// La barra va en milesimas del tema: a 250 ms por tick se mueve de a poco sin necesitar animacion
+#define PROGRESS_BAR_RANGE 1000
+#define PROGRESS_TICK_MS 250
 
-  int httpCode = http.POST(body);  // Realiza la petición POST
+static void drawProgress() {
+  int32_t progress_ms = progressClock.progressAt(millis());
+  int32_t value = (int32_t)((int64_t)progress_ms * PROGRESS_BAR_RANGE / progressClock.duration());
 
-  if (httpCode != 200) {
-    Serial.println("Error al refrescar el token");
-    return "";
+  uint8_t widgets = shownView.progressChanges(progress_ms, value);
+  shownView.applyProgress(progress_ms, value);
+
+  if (widgets & WIDGET_PROGRESS_TEXT) {
+    formatMinutesSeconds(progress_ms, progressText, sizeof(progressText));
+    lv_label_set_text_static(progress, progressText);
   }
+  if ((widgets & WIDGET_PROGRESS_BAR) && !seekDragging)
+    lv_bar_set_value(progress_bar, value, LV_ANIM_OFF);
+}
 
-  String response = http.getString();
+// Con el primer volumen que informa el dispositivo se habilita el slider
+void updateVolumeSlider() {
+  lv_obj_remove_state(volume_slider, LV_STATE_DISABLED);
+  if (!volumeDragging)
+    lv_slider_set_value(volume_slider, shownView.volume, LV_ANIM_OFF);
+}
 
-  JsonDocument doc;
-  deserializeJson(doc, response);
-    
-  Serial.println("Token refrescado");
-  return doc["access_token"];
+static void updateProgressBar(lv_timer_t *timer) {
+  drawProgress();
+}
+
+//========= Snapshots =========
+
+// Tarea de red -> UI. La UI solo aplica el ultimo snapshot, nunca hace peticiones
+SpscQueue<PlaybackSnapshot, 4> snapshotQueue;
+
+// UI -> tarea de red. Las rafagas de toques se juntan en un solo lote
+CommandCoalescer commands;
+
+// Ultimo comando que la UI ya mostro de forma optimista
+uint32_t pendingCommandSeq = 0;
+
+uint32_t drawnArtVersion = 0;
+
+// Bloques MCU de la tapa que la tarea de red va decodificando mientras descarga
+#define ART_BLOCK_MAX_PIXELS (16 * 16)
+
+struct ArtBlock {
+  int16_t x;
+  int16_t y;
+  uint16_t w;
+  uint16_t h;
+  uint16_t pixels[ART_BLOCK_MAX_PIXELS];
+};
+
+SpscQueue<ArtBlock, 24> artQueue;
 
-  http.end();
+// Navegador de la cola y las playlists: la UI pide paginas y miniaturas, la tarea de red las trae
+ThumbPool thumbPool;
+BrowserQueues browserQueues;
+bool browserOpen = false;
+
+// La tapa se dibuja fuera de LVGL: al volver del navegador la pantalla principal se pinta entera y la
+// tarea de red la vuelve a mandar desde la cache
+volatile bool artRedrawRequested = false;
+
+// Se llama en cada vuelta del loop: la tapa aparece de a bloques mientras todavia se esta descargando.
+// Con el navegador abierto se descartan (taparian la lista) y se redibuja al cerrarlo
+static void drawArtBlocks() {
+  ArtBlock block;
+  while (artQueue.pop(block)) {
+    if (!browserOpen)
+      tft_output(block.x, block.y, block.w, block.h, block.pixels);
+  }
 }
 
-void downloadImage(const char* url) {
+static void applyArtColors(uint32_t palette);
 
-  if (String(url) == artworkURL) {
-    Serial.println("Arte de tapa ya descargado");
+void applySnapshot(const PlaybackSnapshot& snapshot) {
+  const PlaybackState& state = snapshot.state;
+
+  // Hasta que la tarea de red no consulte despues de ejecutar el ultimo comando, el snapshot es
+  // anterior a lo que ya muestra la pantalla y lo pisaria
+  if ((int32_t)(snapshot.commandSeq - pendingCommandSeq) < 0)
     return;
+
+  // Si la tapa no se pudo dibujar en streaming, se dibuja desde el archivo que ya dejo la tarea de red
+  if (snapshot.artVersion != drawnArtVersion && !browserOpen) {
+    drawnArtVersion = snapshot.artVersion;
+    if (snapshot.artPath[0] != '\0') {
+      // Sin colores en la cache se sacan de esta misma decodificacion
+      uiArtPalette.reset();
+      uiArtPaletteActive = snapshot.artPalette == 0;
+      uint32_t start = micros();
+      TJpgDec.setJpgScale(snapshot.artScale);
+      TJpgDec.drawFsJpg(ART_X, ART_Y, snapshot.artPath);
+      metrics.record(STAGE_ART_REDRAW, micros() - start);
+      if (uiArtPaletteActive)
+        applyArtColors(ArtPalette::pack(uiArtPalette.colors()));
+      uiArtPaletteActive = false;
+    }
   }
-  
-  artworkURL = url;
-  
-  if(SPIFFS.exists("/albumArt.jpg") == true) {
-    SPIFFS.remove("/albumArt.jpg");
+  if (snapshot.artPalette != 0)
+    applyArtColors(snapshot.artPalette);
+
+  bool same_song = strcmp(shownView.songId, state.id) == 0;
+  progressClock.sample(state.progressMs, snapshot.sampledAt, state.durationMs, state.isPlaying, same_song);
+  drawProgress();
+
+  // El id se guarda siempre, aunque ningun widget cambie (otro tema con el mismo titulo y artista)
+  uint8_t widgets = shownView.changes(state);
+  shownView.apply(state);
+  if (widgets == 0) {
+    Serial.println("La cancion y el estado no cambiaron");
+    return;
   }
 
-  getFile(url, "/albumArt.jpg");
+  if (widgets & (WIDGET_TITLE | WIDGET_ARTIST | WIDGET_DURATION)) {
+    Serial.println("La cancion cambio");
+    updateSongInfo(widgets);
+  }
+
+  if (widgets & WIDGET_PLAY_BUTTON) {
+    Serial.println("El estado cambio");
+    updatePlayPauseButton();
+  }
 
-  TJpgDec.drawFsJpg(5, 5, "/albumArt.jpg");
+  if (widgets & WIDGET_VOLUME)
+    updateVolumeSlider();
 }
 
-std::string convertirMSaMinutosSegundos(long ms) {
-  long totalSegundos = ms / 1000;
-  int minutos = totalSegundos / 60;
-  int segundos = totalSegundos % 60;
+// Tiempos de arranque que mide la UI, en ms desde el reset: se toman despues del lv_timer_handler que los dibujo
+uint32_t bootFirstFrameMs = 0;  // Primer frame, con o sin estado
+uint32_t bootRestoredMs = 0;    // Ultimo tema guardado en pantalla
+uint32_t bootLiveMs = 0;        // Primer estado real (spotify o el puente) en pantalla
+enum BootMark { BOOT_MARK_NONE, BOOT_MARK_RESTORED, BOOT_MARK_LIVE };
+BootMark bootMark = BOOT_MARK_NONE;
 
-  std::ostringstream oss;
-  oss << std::setfill('0') << std::setw(2) << minutos << ":"
-      << std::setfill('0') << std::setw(2) << segundos;
+static void applySnapshots() {
+  PlaybackSnapshot snapshot;
+  bool received = false;
 
-  return oss.str();
+  // Cada snapshot es el estado completo, si se acumularon solo importa el ultimo
+  while (snapshotQueue.pop(snapshot))
+    received = true;
+
+  if (received && snapshot.active)
+    applySnapshot(snapshot);
+
+  if (received && bootLiveMs == 0)
+    bootMark = snapshot.restored ? BOOT_MARK_RESTORED : BOOT_MARK_LIVE;
 }
 
-void updateSongInfo(JsonDocument doc){
+static void recordBootFrame() {
+  if (bootFirstFrameMs == 0)
+    bootFirstFrameMs = millis();
 
-  const char* imageUrl = doc["item"]["album"]["images"][1]["url"];
-  downloadImage(imageUrl);
+  if (bootMark == BOOT_MARK_RESTORED && bootRestoredMs == 0) {
+    bootRestoredMs = millis();
+  } else if (bootMark == BOOT_MARK_LIVE) {
+    bootLiveMs = millis();
+    Serial.printf("[boot] primer frame %u ms, tema guardado %u ms, WiFi %u ms (%s), estado real %u ms\n",
+                  bootFirstFrameMs, bootRestoredMs, bootWifiMs, bootWifiFast ? "rapido" : "escaneo", bootLiveMs);
+  }
+  bootMark = BOOT_MARK_NONE;
+}
 
-  const char* track_name = doc["item"]["name"];
-  const char* artist_name = doc["item"]["artists"][0]["name"];
-  Serial.println("Canción actual:");
-  Serial.println("Nombre: " + String(track_name));
-  Serial.println("Artista: " + String(artist_name));
-  lv_label_set_text(song_title, String(track_name).c_str());
-  lv_label_set_text(artist, String(artist_name).c_str());
+static void wakeNetworkTask(uint32_t seq) {
+  pendingCommandSeq = seq;
+  xTaskNotifyGive(networkTaskHandle);
+}
 
-  noInterrupts();
-  progress_ms = doc["progress_ms"];
-  duration_ms = doc["item"]["duration_ms"];
-  lv_label_set_text(progress, convertirMSaMinutosSegundos(progress_ms).c_str());
-  lv_label_set_text(duration, convertirMSaMinutosSegundos(duration_ms).c_str());
-  interrupts();
+// Respuesta inmediata a un salto de cancion: el progreso vuelve a cero hasta que llegue el estado real
+static void showOptimisticSkip() {
+  progressClock.restart(millis());
+  drawProgress();
 }
 
-void updatePlayPauseButton() {
-  lv_obj_clean(play_pause_button);
-  lv_obj_t * btn_label = lv_label_create(play_pause_button);
+static void optimisticNext() {
+  showOptimisticSkip();
+  wakeNetworkTask(commands.next());
+}
 
-  // LVGL ya trae parte de los simbolos de FontAwesome
-  if (current_playing_state == "true") {
-    lv_label_set_text(btn_label, LV_SYMBOL_PAUSE);
-  } else {
-    lv_label_set_text(btn_label, LV_SYMBOL_PLAY);
+static void optimisticPrev() {
+  showOptimisticSkip();
+  wakeNetworkTask(commands.prev());
+}
+
+static void optimisticPlayPause() {
+  bool playing = shownView.playState != PLAY_STATE_PLAYING;
+  shownView.playState = playing ? PLAY_STATE_PLAYING : PLAY_STATE_PAUSED;
+  updatePlayPauseButton();
+  progressClock.setPlaying(playing, millis());
+  wakeNetworkTask(commands.setPlaying(playing));
+}
+
+//========= Network task =========
+
+#define STATS_INTERVAL_MS 60000
+
+// La UI corre en ARDUINO_RUNNING_CORE (1), la red en el otro junto al stack de WiFi
+#define NETWORK_TASK_CORE 0
+#define NETWORK_TASK_STACK 10240
+
+// Estado que solo toca la tarea de red
+char artworkURL[sizeof(PlaybackState::imageUrl)] = "";
+
+// Despues de cada consulta la tapa se resuelve en la tarea de red y el snapshot pasa a la UI
+class DisplayListener : public PlayerListener {
+
+  public:
+    void onSnapshot(PlaybackSnapshot& snapshot) override;
+};
+
+DisplayListener displayListener;
+
+// Lo ultimo que se mostro, para el proximo arranque. Solo lo toca la tarea de red
+PlaybackStore playbackStore(preferences);
+bool liveStateSeen = false;
+
+#ifdef BRIDGE_HOST
+BridgeClient bridge(bridgeSocket, BRIDGE_HOST, BRIDGE_PORT, BRIDGE_NAME, displayListener);
+#endif
+
+// Consultas, comandos y token; la misma logica que corre en env:native contra el mock
+PlayerSession session(spotifyApi, tokenManager, commands, displayListener);
+PollScheduler& pollScheduler = session.pollScheduler();
+
+// Heap libre y bloque mas grande a lo largo del tiempo: la consulta y el tick de progreso no deberian moverlos
+HeapMonitor heapMonitor;
+uint32_t artVersion = 0;
+
+// Margen de heap que se deja libre ademas de lo que necesita el decodificador
+#define ART_STREAM_HEAP_MARGIN 8192
+
+ArtDecoder artDecoder;
+
+// Presupuestos dentro de la particion spiffs (0xF0000 bytes, 960 KB): JPEG originales y tapas ya
+// decodificadas. Entre los dos 576 KB (60%); el resto queda para los indices, los dos temporales de una
+// descarga (JPEG y RGB565 de 45 KB) y para que el GC de SPIFFS tenga bloques libres, que lleno por
+// encima de ~75% se vuelve lento y gasta mas la flash
+#ifndef ART_CACHE_BUDGET_BYTES
+#define ART_CACHE_BUDGET_BYTES (256 * 1024)
+#endif
+#ifndef PIXEL_CACHE_BUDGET_BYTES
+#define PIXEL_CACHE_BUDGET_BYTES (320 * 1024)
+#endif
+
+ArtCache artCache(SPIFFS, "/art", ART_CACHE_BUDGET_BYTES);
+ArtCache pixelCache(SPIFFS, "/px", PIXEL_CACHE_BUDGET_BYTES, ART_CACHE_RGB565);
+
+// Vacio cuando la tapa actual ya se dibujo por bloques
+char currentArtPath[32] = "";
+uint8_t artScale = 2;
+
+// Mientras se decodifica se graban los bloques ya escalados para copiarlos directo la proxima vez
+fs::File pixelRecord;
+uint32_t pixelRecordSize = 0;
+
+uint32_t lastDecodeMs = 0;
+uint32_t lastBlitMs = 0;
+
+// Colores de la tapa actual (ArtPalette::pack), 0 si no se conocen. Se acumulan con los mismos bloques
+// que salen del decodificador y se guardan en el indice de las dos caches
+ArtPalette artPalette;
+bool artPaletteActive = false;
+uint32_t currentArtPalette = 0;
+
+// Lo que llevo el histograma en la ultima tapa, para compararlo con la decodificacion
+uint32_t paletteUs = 0;
+uint32_t paletteBlocks = 0;
+
+// La mayor escala de tjpgd (1, 2, 4, 8) que deja la imagen en al menos ART_TARGET_SIZE
+uint8_t artScaleFor(uint16_t width) {
+  uint8_t scale = 1;
+  while (scale < 8 && width / (scale * 2) >= ART_TARGET_SIZE)
+    scale *= 2;
+  return scale;
+}
+
+// Pasa cada bloque a la UI. Si la cola esta llena se espera: el decodificador va al ritmo de la pantalla
+static bool queueArtBlock(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap) {
+  if ((uint32_t)w * h > ART_BLOCK_MAX_PIXELS)
+    return false;
+
+  ArtBlock block;
+  block.x = x;
+  block.y = y;
+  block.w = w;
+  block.h = h;
+  memcpy(block.pixels, bitmap, (size_t)w * h * sizeof(uint16_t));
+
+  if (artPaletteActive) {
+    uint32_t start = micros();
+    artPalette.add(x - ART_X, y - ART_Y, w, h, bitmap, true);
+    paletteUs += micros() - start;
+    paletteBlocks++;
   }
-  lv_obj_set_style_text_color(btn_label, lv_color_hex(0x000000), 0);
-  lv_obj_center(btn_label);
+
+  if (pixelRecord) {
+    ArtPixelsBlock header = {(int16_t)(x - ART_X), (int16_t)(y - ART_Y), w, h};
+    pixelRecordSize += pixelRecord.write((const uint8_t*)&header, sizeof(header));
+    pixelRecordSize += pixelRecord.write((const uint8_t*)bitmap, (size_t)w * h * sizeof(uint16_t));
+  }
+
+  // Cola llena: se despierta a la UI para que la vacie y se espera
+  while (!artQueue.push(block)) {
+    wakeUi();
+    vTaskDelay(1);
+  }
+  wakeUi();
+  return true;
 }
 
-static void updateProgressBar(lv_timer_t *timer) {
-  if (progress_ms == 0 && duration_ms == 1)
+void beginPixelRecord() {
+  char temp[32];
+  pixelCache.tempPath(temp, sizeof(temp));
+  pixelRecord = SPIFFS.open(temp, "w");
+  if (!pixelRecord)
     return;
 
-  if (current_playing_state == "false")
+  ArtPixelsMarker head = {ART_PIXELS_MAGIC, 0};
+  pixelRecordSize = pixelRecord.write((const uint8_t*)&head, sizeof(head));
+}
+
+void finishPixelRecord(uint32_t key, bool decoded) {
+  if (!pixelRecord)
     return;
 
-  noInterrupts();
-  progress_ms += 1000;
-  lv_label_set_text(progress, convertirMSaMinutosSegundos(progress_ms).c_str());
-  int32_t porcentage = (progress_ms * 100) / duration_ms;
-  lv_bar_set_value(progress_bar, porcentage, LV_ANIM_ON);
-  interrupts();
+  if (decoded) {
+    ArtPixelsMarker tail = {ART_PIXELS_MAGIC, pixelRecordSize + (uint32_t)sizeof(ArtPixelsMarker)};
+    pixelRecord.write((const uint8_t*)&tail, sizeof(tail));
+    pixelRecord.close();
+    pixelCache.commit(key, tail.size);
+  } else {
+    pixelRecord.close();
+    pixelCache.discard();
+  }
 }
 
-static void updateScreen(lv_timer_t *timer) {
-  HTTPClient http;
-  http.begin("https://api.spotify.com/v1/me/player/currently-playing");
-  http.addHeader("Authorization", "Bearer " + accessToken);
+void beginArtPalette() {
+  artPalette.reset();
+  artPaletteActive = true;
+  paletteUs = 0;
+  paletteBlocks = 0;
+}
 
-  int httpCode = http.GET();
+// Con la tapa entera: colores para la UI y para la proxima vez que se copie desde la cache
+void finishArtPalette(uint32_t key, bool decoded, uint32_t decodeMs) {
+  artPaletteActive = false;
+  if (!decoded)
+    return;
 
-  if (httpCode == 200) {
-    String response = http.getString();
+  currentArtPalette = ArtPalette::pack(artPalette.colors());
+  artCache.setPalette(key, currentArtPalette);
+  pixelCache.setPalette(key, currentArtPalette);
 
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, response);
+  // Milesimas: us / ms
+  uint32_t share = decodeMs > 0 ? paletteUs / decodeMs : 0;
+  Serial.printf("Colores de la tapa: %u muestras, %u us en %u bloques (%u us/bloque, %u.%u%% de la decodificacion)\n",
+                artPalette.sampleCount(), paletteUs, paletteBlocks, paletteBlocks ? paletteUs / paletteBlocks : 0,
+                share / 10, share % 10);
+}
 
-    if (error) {
-      Serial.println("Error al parsear el JSON: " + String(error.c_str()));
-      return;
+// Tapa ya decodificada: se copian los bloques tal cual, sin tjpgd. Los colores salen del indice; las
+// entradas de antes de que existieran se completan con los mismos bloques
+bool blitCachedPixels(const char* path, uint32_t key) {
+  uint32_t start = millis();
+  fs::File f = SPIFFS.open(path, "r");
+  if (!f)
+    return false;
+
+  ArtPixelsMarker head;
+  f.read((uint8_t*)&head, sizeof(head));
+
+  currentArtPalette = pixelCache.palette(key);
+  if (currentArtPalette == 0)
+    beginArtPalette();
+
+  size_t end = f.size() - sizeof(ArtPixelsMarker);
+  ArtBlock block;
+  bool ok = true;
+  while (ok && f.position() < end) {
+    ArtPixelsBlock header;
+    ok = f.read((uint8_t*)&header, sizeof(header)) == sizeof(header) && (uint32_t)header.w * header.h <= ART_BLOCK_MAX_PIXELS;
+    if (!ok)
+      break;
+
+    size_t bytes = (size_t)header.w * header.h * sizeof(uint16_t);
+    ok = f.read((uint8_t*)block.pixels, bytes) == bytes;
+    block.x = ART_X + header.x;
+    block.y = ART_Y + header.y;
+    block.w = header.w;
+    block.h = header.h;
+    if (ok && artPaletteActive) {
+      uint32_t paletteStart = micros();
+      artPalette.add(header.x, header.y, header.w, header.h, block.pixels, true);
+      paletteUs += micros() - paletteStart;
+      paletteBlocks++;
     }
-
-    noInterrupts();
-    progress_ms = doc["progress_ms"];
-    lv_label_set_text(progress, convertirMSaMinutosSegundos(progress_ms).c_str());
-    interrupts();
-
-    const char *song_id = doc["item"]["id"];
-    String playing_state = doc["is_playing"];
-    if (current_song_id == song_id  && current_playing_state == playing_state) {
-      http.end();
-      Serial.println("La cancion y el estado no cambiaron");
-      return;
+    while (ok && !artQueue.push(block)) {
+      wakeUi();
+      vTaskDelay(1);
     }
+    wakeUi();
+  }
+  f.close();
 
-    if (current_song_id != song_id  && current_playing_state != playing_state) {
-      current_song_id = song_id;
-      current_playing_state = playing_state;
-      Serial.println("La cancion y el estado cambiaron");
-      updateSongInfo(doc);
-      updatePlayPauseButton();
-    }
+  lastBlitMs = millis() - start;
+  if (artPaletteActive)
+    finishArtPalette(key, ok, lastBlitMs);
+  Serial.printf("Tapa RGB565 desde cache: %u ms (decodificar la ultima llevo %u ms)\n", lastBlitMs, lastDecodeMs);
+  return ok;
+}
 
-    if (current_song_id != song_id) {
-      current_song_id = song_id;
-      Serial.println("La cancion cambio");
-      updateSongInfo(doc);
-    }
-    
-    if (current_playing_state != playing_state) {
-      current_playing_state = playing_state;
-      Serial.println("El estado cambio");
-      updatePlayPauseButton();
-    }
-  } else if (httpCode == 401) {
-    saveAccessToken(getNewAccessToken());
-    http.end();
-    updateScreen(NULL);
-  } else if (httpCode == 204) {
-    Serial.println("No hay reproducción activa en este momento.");
+// Decodifica una tapa que ya esta en la cache, por bloques igual que en streaming
+bool decodeCachedImage(const char* path, uint32_t key) {
+  fs::File f = SPIFFS.open(path, "r");
+  if (!f)
+    return false;
+
+  uint32_t start = micros();
+  beginPixelRecord();
+  beginArtPalette();
+  bool decoded = artDecoder.decode(f, f.size(), ART_X, ART_Y, artScale, queueArtBlock);
+  finishPixelRecord(key, decoded);
+  f.close();
+  metrics.record(STAGE_ART_DECODE, micros() - start);
+  finishArtPalette(key, decoded, artDecoder.totalMs);
+
+  lastDecodeMs = artDecoder.totalMs;
+  Serial.printf("Tapa desde cache: primer bloque a %u ms, decodificada en %u ms\n", artDecoder.firstBlockMs(), artDecoder.totalMs);
+  return decoded;
+}
+
+// Conexion por la que se baja una tapa y el path dentro de ese host: i.scdn.co o el puente
+SpotifyClient* imageTransportFor(const char* url, const char** path) {
+  const char* prefix = "https://" SPOTIFY_IMAGES_HOST;
+  if (strncmp(url, prefix, strlen(prefix)) == 0) {
+    *path = url + strlen(prefix);
+    return &spotifyImages;
+  }
+#ifdef BRIDGE_HOST
+  char bridgePrefix[64];
+  snprintf(bridgePrefix, sizeof(bridgePrefix), "http://%s:%u", BRIDGE_HOST, BRIDGE_PORT);
+  if (strncmp(url, bridgePrefix, strlen(bridgePrefix)) == 0) {
+    *path = url + strlen(bridgePrefix);
+    return &bridgeArt;
+  }
+#endif
+  return nullptr;
+}
+
+// Descarga y decodifica al mismo tiempo; los bytes se van copiando al archivo temporal de la cache
+bool streamImage(const char* url, uint32_t key) {
+  const char* path;
+  SpotifyClient* images = imageTransportFor(url, &path);
+  if (images == nullptr)
+    return false;
+
+  uint32_t start = millis();
+  uint32_t startUs = micros();
+  int httpCode = images->GET(path);
+  if (httpCode != 200) {
+    Serial.printf("Error al descargar la tapa, Código HTTP: %d\n", httpCode);
+    images->end();
+    return false;
+  }
+  uint32_t headersMs = millis() - start;
+  int32_t size = images->getSize();
+
+  char temp[32];
+  artCache.tempPath(temp, sizeof(temp));
+  fs::File copy = SPIFFS.open(temp, "w");
+  if (copy)
+    artDecoder.setCopy(&copy);
+
+  beginPixelRecord();
+  beginArtPalette();
+  bool decoded = artDecoder.decode(images->getBodyStream(), size, ART_X, ART_Y, artScale, queueArtBlock);
+  finishPixelRecord(key, decoded);
+  artDecoder.setCopy(nullptr);
+
+  if (decoded) {
+    images->end();
+    metrics.record(STAGE_ART_DOWNLOAD, micros() - startUs);
   } else {
-    Serial.println("Error al actualizar la cancion, Código HTTP: " + String(httpCode));
-    Serial.println("Respuesta: " + http.getString());
+    images->abort();
   }
 
-  http.end();
+  if (copy) {
+    copy.close();
+    if (decoded)
+      artCache.commit(key, size);
+    else
+      artCache.discard();
+  }
+  finishArtPalette(key, decoded, artDecoder.totalMs);
+
+  lastDecodeMs = artDecoder.totalMs;
+  Serial.printf("Tapa en streaming: %u bytes, primer bloque a %u ms, total %u ms\n",
+                artDecoder.bytesRead, headersMs + artDecoder.firstBlockMs(), headersMs + artDecoder.totalMs);
+  return decoded;
 }
 
-void playAndPause() {
-  HTTPClient http;
+// Camino con poco heap: se baja a la cache en SPIFFS y la UI decodifica desde el archivo
+bool downloadImageToCache(const char* url, uint32_t key) {
+  uint32_t start = millis();
+  char temp[32];
+  artCache.tempPath(temp, sizeof(temp));
+  artCache.discard();
+
+  uint32_t startUs = micros();
+  getFile(url, temp);
+  if (!artCache.commit(key, -1))
+    return false;
+  metrics.record(STAGE_ART_DOWNLOAD, micros() - startUs);
+
+  artCache.pathFor(key, currentArtPath, sizeof(currentArtPath));
+  Serial.printf("Tapa descargada a SPIFFS en %u ms\n", millis() - start);
+  return true;
+}
 
-  if (current_playing_state == "true") {
-    http.begin("https://api.spotify.com/v1/me/player/pause");  // URL para siguiente canción
-  } else {
-    http.begin("https://api.spotify.com/v1/me/player/play");  // URL para siguiente canción
+// offline: al arrancar, antes del WiFi, solo sirve lo que ya este en las caches
+void downloadImage(const char* url, uint16_t width, bool offline) {
+
+  if (url[0] == '\0')
+    return;
+
+  if (strcmp(url, artworkURL) == 0) {
+    Serial.println("Arte de tapa ya descargado");
+    return;
+  }
+  
+  strlcpy(artworkURL, url, sizeof(artworkURL));
+  currentArtPath[0] = '\0';
+  currentArtPalette = 0;
+  artScale = artScaleFor(width);
+
+  uint32_t key = ArtCache::keyFor(url);
+  char path[32];
+
+  // Con el heap justo no se decodifica aca: la UI lo hace desde el archivo, que casi no necesita memoria
+  bool enoughHeap = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) >= ArtDecoder::REQUIRED_HEAP + ART_STREAM_HEAP_MARGIN;
+
+  if (pixelCache.lookup(key, path, sizeof(path)) && blitCachedPixels(path, key)) {
+    // Nada mas que hacer, ya esta en pantalla
+  } else if (artCache.lookup(key, path, sizeof(path))) {
+    if (!enoughHeap || !decodeCachedImage(path, key)) {
+      // La decodifica la UI; si los colores no estan en el indice los saca ella
+      strlcpy(currentArtPath, path, sizeof(currentArtPath));
+      currentArtPalette = artCache.palette(key);
+    }
+  } else if (offline) {
+    // Se baja con el primer estado real
+    artworkURL[0] = '\0';
+    return;
+  } else if (!enoughHeap || !streamImage(url, key)) {
+    downloadImageToCache(url, key);
   }
+  artVersion++;
+}
 
-  http.addHeader("Authorization", "Bearer " + accessToken);  // Cabecera con el token de acceso
-  http.addHeader("Content-Length", "0"); // Agregado a la cabecera para que spotify acepte la solicitud
+//========= Prefetch =========
+
+// Cuantas canciones de la cola se adelantan
+#define PREFETCH_AHEAD QUEUE_ART_MAX
+// Solo se trabaja en segundo plano si no hubo toques en este tiempo...
+#define PREFETCH_IDLE_MS 3000
+// ...y si falta al menos esto para la proxima consulta
+#define PREFETCH_MIN_WINDOW_MS 1500
+
+QueueArt prefetchQueue;
+uint8_t prefetchNext = 0;
+bool prefetchQueueStale = false;
+uint32_t prefetchedImages = 0;
+uint32_t prefetchAborted = 0;
+
+void fetchQueueArt() {
+  prefetchQueue.count = 0;
+  prefetchNext = 0;
+  if (!pollScheduler.acquire(millis(), false))
+    return;
 
-  int httpCode = http.PUT("");  // Enviamos la petición POST (vacía)
+  spotifyApi.setAuthorization(tokenManager.authorizationHeader());
+  int httpCode = spotifyApi.GET("/v1/me/player/queue");
 
   if (httpCode == 200) {
-    String payload = http.getString();  // Obtener la respuesta del servidor
-    Serial.println("Pausado o reanudado exitoso");
-    Serial.println(payload);  // Imprime la respuesta completa
+    parseQueueArt(spotifyApi.getBodyStream(), prefetchQueue);
   } else {
-    Serial.println("Error al enviar la solicitud");
-    Serial.println(httpCode);  // Imprime el código de error HTTP
+    Serial.printf("Error al consultar la cola, Código HTTP: %d\n", httpCode);
+    if (httpCode == 429) {
+      metrics.count(COUNTER_RATE_LIMITED);
+      pollScheduler.onRateLimited(millis(), spotifyApi.retryAfter());
+    }
   }
+  spotifyApi.end();
+}
+
+// Baja una tapa a la cache sin decodificarla. Se corta apenas la UI manda un comando
+void prefetchImage(const char* url) {
+  uint32_t key = ArtCache::keyFor(url);
+  if (artCache.contains(key))
+    return;
+
+  const char* path;
+  SpotifyClient* images = imageTransportFor(url, &path);
+  if (images == nullptr)
+    return;
+
+  uint32_t start = micros();
+  int httpCode = images->GET(path);
+  if (httpCode != 200) {
+    images->end();
+    return;
+  }
+
+  int32_t size = images->getSize();
+  int32_t remaining = size;
+  Stream& body = images->getBodyStream();
 
-  http.end();
+  char temp[32];
+  artCache.tempPath(temp, sizeof(temp));
+  fs::File f = SPIFFS.open(temp, "w");
+  if (!f) {
+    images->abort();
+    return;
+  }
+
+  uint8_t buff[1024];
+  bool aborted = false;
+  while (remaining != 0) {
+    if (commands.pending()) {
+      aborted = true;
+      break;
+    }
+    size_t want = remaining > 0 ? min((int32_t)sizeof(buff), remaining) : sizeof(buff);
+    size_t n = body.readBytes(buff, want);
+    if (n == 0)
+      break;
+    f.write(buff, n);
+    if (remaining > 0)
+      remaining -= n;
+  }
+  f.close();
+
+  if (aborted) {
+    images->abort();
+    artCache.discard();
+    prefetchAborted++;
+    return;
+  }
+
+  images->end();
+  if (artCache.commit(key, size)) {
+    prefetchedImages++;
+    metrics.record(STAGE_ART_DOWNLOAD, micros() - start);
+  }
 }
 
-void nextSong() {
-  HTTPClient http;
-  http.begin("https://api.spotify.com/v1/me/player/next");  // URL para siguiente canción
-  http.addHeader("Authorization", "Bearer " + accessToken);  // Cabecera con el token de acceso
-  http.addHeader("Content-Length", "0"); // Agregado a la cabecera para que spotify acepte la solicitud
-  
-  int httpCode = http.POST("");  // Enviamos la petición POST (vacía)
+// Un paso de trabajo de fondo por vuelta, asi los comandos y las consultas nunca esperan mas que una descarga
+void prefetchStep(uint32_t msUntilPoll) {
+  if (commands.pending() || millis() - session.lastCommandTime() < PREFETCH_IDLE_MS || msUntilPoll < PREFETCH_MIN_WINDOW_MS)
+    return;
+
+  if (prefetchQueueStale) {
+    prefetchQueueStale = false;
+    fetchQueueArt();
+    return;
+  }
+
+  if (prefetchNext < prefetchQueue.count) {
+    prefetchImage(prefetchQueue.urls[prefetchNext]);
+    prefetchNext++;
+    return;
+  }
+
+  // Sin nada para bajar: el orden del LRU va a flash de vez en cuando, no en cada acierto
+  artCache.flush(millis());
+  pixelCache.flush(millis());
+}
 
-  if (httpCode > 0) {
-    String payload = http.getString();  // Obtener la respuesta del servidor
-    Serial.println("Siguiente canción enviada");
-    Serial.println(payload);  // Imprime la respuesta completa
+//========= Navegador (tarea de red) =========
+
+// Los pixeles de la miniatura van directo al buffer del slot, recortados a THUMB_SIZE. La imagen viene
+// centrada: si a su escala queda mas grande que el slot, x e y pueden ser negativos
+uint16_t* thumbTarget = nullptr;
+
+static bool thumbOutput(int16_t x, int16_t y, uint16_t w, uint16_t h, uint16_t* bitmap) {
+  int16_t skip = x < 0 ? -x : 0;
+  if (x >= THUMB_SIZE || y >= THUMB_SIZE || skip >= w)
+    return true;
+  int16_t cols = min((int)w - skip, THUMB_SIZE - (x + skip));
+  for (int16_t row = y < 0 ? -y : 0; row < h && y + row < THUMB_SIZE; row++)
+    memcpy(thumbTarget + (y + row) * THUMB_SIZE + x + skip, bitmap + row * w + skip, cols * sizeof(uint16_t));
+  return true;
+}
+
+// A la escala que eligio el controlador segun el ancho y centrada (64 px a escala 2; los mosaicos de 60 px
+// quedan en 30 con borde, una de 256 px a escala 8 llena el slot). Sin pasar por SPIFFS: se pierden al
+// desalojarlas, pero son chicas
+static void loadThumb(const ThumbRequest& thumb) {
+  ThumbResult result = {thumb.slot, thumb.key, false};
+  const char* path;
+  SpotifyClient* images = imageTransportFor(thumb.url, &path);
+  bool enoughHeap = heap_caps_get_largest_free_block(MALLOC_CAP_8BIT) >= ArtDecoder::REQUIRED_HEAP + ART_STREAM_HEAP_MARGIN;
+
+  if (images != nullptr && enoughHeap) {
+    int httpCode = images->GET(path);
+    if (httpCode == 200) {
+      thumbTarget = thumbPool.buffer(thumb.slot);
+      memset(thumbTarget, 0, THUMB_SIZE * THUMB_SIZE * sizeof(uint16_t));
+      int16_t margin = (THUMB_SIZE - (int16_t)(thumb.width / thumb.scale)) / 2;
+      // LVGL dibuja RGB565 en el orden del CPU; el swap para el panel lo hace el flush
+      artDecoder.setSwapBytes(false);
+      result.ok = artDecoder.decode(images->getBodyStream(), images->getSize(), margin, margin, thumb.scale, thumbOutput);
+      artDecoder.setSwapBytes(true);
+    }
+    if (result.ok)
+      images->end();
+    else
+      images->abort();
+  }
+
+  // Hay un lugar por slot del pool, nunca se llena
+  browserQueues.thumbResults.push(result);
+  wakeUi();
+}
+
+// Un pedido del navegador por vuelta: las paginas primero, despues las miniaturas. Devuelve si quedo
+// algo para hacer. Con el puente no hay sesion propia contra spotify y las paginas vuelven vacias
+static bool browserStep(bool direct) {
+  static BrowserPage page;
+  BrowserRequest request;
+  if (browserQueues.requests.pop(request)) {
+    if (request.play) {
+      if (direct)
+        session.playContext(request.contextId, request.offset);
+    } else {
+      if (direct) {
+        session.fetchBrowserPage(request, page);
+      } else {
+        page.source = request.source;
+        page.generation = request.generation;
+        page.offset = request.offset;
+        page.count = 0;
+        page.total = 0;
+        page.ok = false;
+      }
+      // La UI saca la pagina anterior antes de pedir otra; solo puede estar ocupado si el navegador se cerro
+      if (!browserQueues.pages.push(page))
+        Serial.println("Pagina del navegador descartada");
+      wakeUi();
+    }
   } else {
-    Serial.println("Error al enviar la solicitud");
-    Serial.println(httpCode);  // Imprime el código de error HTTP
+    ThumbRequest thumb;
+    if (!browserQueues.thumbRequests.pop(thumb))
+      return false;
+    loadThumb(thumb);
   }
+  return !browserQueues.requests.empty() || !browserQueues.thumbRequests.empty();
+}
 
-  http.end();
+// Se volvio del navegador: la tapa actual otra vez en pantalla, desde las caches
+static void redrawArt() {
+  if (artworkURL[0] == '\0')
+    return;
+  uint32_t key = ArtCache::keyFor(artworkURL);
+  char path[32];
+  if (pixelCache.lookup(key, path, sizeof(path)) && blitCachedPixels(path, key))
+    return;
+  if (artCache.lookup(key, path, sizeof(path)))
+    decodeCachedImage(path, key);
 }
 
-void prevSong() {
-  HTTPClient http;
-  http.begin("https://api.spotify.com/v1/me/player/previous");  // URL para siguiente canción
-  http.addHeader("Authorization", "Bearer " + accessToken);  // Cabecera con el token de acceso
-  http.addHeader("Content-Length", "0"); // Agregado a la cabecera para que spotify acepte la solicitud
-  
-  int httpCode = http.POST("");  // Enviamos la petición POST (vacía)
+void DisplayListener::onSnapshot(PlaybackSnapshot& snapshot) {
+  if (snapshot.active) {
+    // Cambio la cancion: la cola tambien cambio, se vuelve a pedir cuando haya tiempo libre
+    if (strcmp(artworkURL, snapshot.state.imageUrl) != 0)
+      prefetchQueueStale = true;
+
+    downloadImage(snapshot.state.imageUrl, snapshot.state.imageWidth, snapshot.restored);
+    if (!snapshot.restored)
+      playbackStore.save(snapshot.state);
+  }
+
+  if (!snapshot.restored && !liveStateSeen) {
+    liveStateSeen = true;
+    ledController.turnOffLed();
+  }
+
+  snapshot.artVersion = artVersion;
+  strlcpy(snapshot.artPath, currentArtPath, sizeof(snapshot.artPath));
+  snapshot.artScale = artScale;
+  snapshot.artPalette = currentArtPalette;
 
-  if (httpCode > 0) {
-    String payload = http.getString();  // Obtener la respuesta del servidor
-    Serial.println("Siguiente canción enviada");
-    Serial.println(payload);  // Imprime la respuesta completa
+  if (!snapshotQueue.push(snapshot)) {
+    Serial.println("La UI no consumio los snapshots anteriores, se descarta");
+  }
+  wakeUi();
+}
+
+void printNetworkStats() {
+  spotifyApi.printStats();
+  spotifyAccounts.printStats();
+  tokenManager.printStats();
+  heapMonitor.printStats();
+  Serial.printf("JSON: %u consultas tuvieron que usar el heap\n", jsonArenaFallbacks());
+  spotifyImages.printStats();
+#ifdef BRIDGE_HOST
+  bridge.printStats();
+  bridgeArt.printStats();
+#endif
+  artCache.printStats();
+  pixelCache.printStats();
+  Serial.printf("Prefetch: %u tapas adelantadas, %u cortadas por un comando\n", prefetchedImages, prefetchAborted);
+  session.printStats();
+  connectivity.printStats();
+}
+
+// Sin puente: token, comandos y consultas directo contra spotify, con el prefetch de la cola en el tiempo libre
+static uint32_t directStep() {
+  static bool sessionStarted = false;
+  if (!sessionStarted) {
+    session.begin();
+    heapMonitor.setBaseline();
+    sessionStarted = true;
+  }
+
+  // Lo que se toco sin conexion, despues de descartar lo que ya no tiene sentido
+  TransportBatch held;
+  if (connectivity.releaseCommands(held, millis()))
+    session.runCommands(held);
+
+  // Lo que pide el navegador va antes que el prefetch: alguien esta mirando la lista
+  bool browsing = browserStep(true);
+  // Con tiempo libre se adelantan las tapas de la cola; un comando corta la descarga
+  if (!browsing)
+    prefetchStep(pollScheduler.msUntilNextPoll(millis()));
+
+  uint32_t wait = session.step();
+  connectivity.onApiFailures(session.transportErrors(), millis());
+
+  // Si quedo trabajo de fondo se vuelve a mirar antes
+  if (prefetchQueueStale || prefetchNext < prefetchQueue.count)
+    wait = min(wait, (uint32_t)PREFETCH_IDLE_MS);
+  if (browsing)
+    wait = 0;
+  return wait;
+}
+
+#ifdef BRIDGE_HOST
+// Con puente: los comandos van al puente y el estado vuelve por el mismo socket, no hay consultas ni token
+static uint32_t bridgeStep() {
+  TransportBatch batch;
+  if (connectivity.releaseCommands(batch, millis()))
+    bridge.sendCommand(batch);
+  if (commands.take(batch))
+    bridge.sendCommand(batch);
+  uint32_t wait = bridge.step(millis());
+  return browserStep(false) ? 0 : wait;
+}
+#endif
+
+// Lo que se mostraba antes de apagar, con la tapa de la cache, mientras el WiFi todavia conecta
+static void restoreLastPlayback() {
+  PlaybackSnapshot snapshot;
+  if (!playbackStore.load(snapshot.state))
+    return;
+  snapshot.active = true;
+  snapshot.restored = true;
+  snapshot.commandSeq = 0;
+  snapshot.sampledAt = millis();
+  Serial.printf("Ultimo tema guardado: %s\n", snapshot.state.name);
+  displayListener.onSnapshot(snapshot);
+}
+
+// Se cayo el enlace: LED en rojo y aviso en pantalla. El socket del puente quedo muerto
+static void onLinkDown() {
+  linkOnline = false;
+  wakeUi();
+  ledController.setLedRed();
+#ifdef BRIDGE_HOST
+  bridge.disconnect();
+#endif
+}
+
+// Conecto o volvio el enlace. La primera vez se pide la hora
+static void onLinkUp() {
+  linkOnline = true;
+  wakeUi();
+
+  if (bootWifiMs == 0) {
+    bootWifiMs = millis();
+    bootWifiFast = wifiLink.lastConnectFast();
+    Serial.printf("WiFi en %u ms desde el arranque (%s)\n", bootWifiMs, bootWifiFast ? "reconexion rapida" : "escaneo y DHCP");
+    configTime(0, 0, NTP_SERVER);
   } else {
-    Serial.println("Error al enviar la solicitud");
-    Serial.println(httpCode);  // Imprime el código de error HTTP
+    // Se consulta enseguida en lugar de esperar el intervalo que quedo de antes de la caida
+    session.onReconnected();
   }
 
-  http.end();
+  // El LED queda en verde hasta el primer estado real
+  if (liveStateSeen)
+    ledController.turnOffLed();
+  else
+    ledController.setLedGreen();
+}
+
+static void networkTask(void *parameter) {
+  restoreLastPlayback();
+
+  Serial.println("Conectando al WiFi...");
+  ledController.setLedRed();
+  WiFi.onEvent(onWifiEvent);
+  connectivity.begin(millis());
+
+  uint32_t lastStats = millis();
+#ifdef BRIDGE_HOST
+  heapMonitor.setBaseline();
+#endif
+
+  for (;;) {
+    uint32_t wait = connectivity.step(millis());
+    if (connectivity.reconnected())
+      onLinkUp();
+    else if (linkOnline && !connectivity.online())
+      onLinkDown();
+
+    if (connectivity.online()) {
+#ifdef BRIDGE_HOST
+      // connect() reintenta cada BRIDGE_RETRY_MS; mientras tanto se sigue consultando a spotify
+      if (bridge.connect(millis()))
+        wait = bridgeStep();
+      else
+#endif
+        wait = directStep();
+    } else {
+      // Sin enlace no se intenta nada: los toques quedan guardados y la pantalla sigue con lo ultimo que supo
+      TransportBatch batch;
+      if (commands.take(batch))
+        connectivity.holdCommands(batch, millis());
+    }
+    if (artRedrawRequested) {
+      artRedrawRequested = false;
+      redrawArt();
+    }
+    heapMonitor.sample();
+
+    if (millis() - lastStats >= STATS_INTERVAL_MS) {
+      printNetworkStats();
+      lastStats = millis();
+    }
+
+    // Duerme hasta la proxima consulta o hasta que la UI mande un comando
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+  }
 }
 
 static void event_handler_prev_button(lv_event_t * e) {
   lv_event_code_t code = lv_event_get_code(e);
   if(code == LV_EVENT_CLICKED) {
     LV_LOG_USER("Previous button pressed");
-    prevSong();
-    updateScreen(NULL);
+    optimisticPrev();
   }
 }
 
@@ -416,8 +1293,7 @@ static void event_handler_play_pause_button(lv_event_t * e) {
   lv_event_code_t code = lv_event_get_code(e);
   if(code == LV_EVENT_CLICKED) {
     LV_LOG_USER("Play-Pause button pressed");
-    playAndPause();
-    updateScreen(NULL);
+    optimisticPlayPause();
   }
 }
 
@@ -425,14 +1301,64 @@ static void event_handler_next_button(lv_event_t * e) {
   lv_event_code_t code = lv_event_get_code(e);
   if(code == LV_EVENT_CLICKED) {
     LV_LOG_USER("Next button pressed");
-    nextSong();
-    updateScreen(NULL);
+    optimisticNext();
+  }
+}
+
+// Cada evento del arrastre se muestra ya y pisa al anterior en el coalescer; la tarea de red manda
+// solo el ultimo valor, una peticion a la vez
+static void event_handler_progress_bar(lv_event_t * e) {
+  lv_event_code_t code = lv_event_get_code(e);
+  if (code == LV_EVENT_PRESSED) {
+    seekDragging = true;
+  } else if (code == LV_EVENT_VALUE_CHANGED) {
+    int32_t target = (int32_t)((int64_t)lv_slider_get_value(progress_bar) * progressClock.duration() / PROGRESS_BAR_RANGE);
+    progressClock.seek(target, millis());
+    drawProgress();
+    wakeNetworkTask(commands.seekTo(target));
+  } else if (code == LV_EVENT_RELEASED || code == LV_EVENT_PRESS_LOST) {
+    seekDragging = false;
+  }
+}
+
+static void event_handler_volume_slider(lv_event_t * e) {
+  lv_event_code_t code = lv_event_get_code(e);
+  if (code == LV_EVENT_PRESSED) {
+    volumeDragging = true;
+  } else if (code == LV_EVENT_VALUE_CHANGED) {
+    shownView.volume = lv_slider_get_value(volume_slider);
+    wakeNetworkTask(commands.setVolume(shownView.volume));
+  } else if (code == LV_EVENT_RELEASED || code == LV_EVENT_PRESS_LOST) {
+    volumeDragging = false;
+  }
+}
+
+static void openBrowser(BrowserSource source, const char* contextId);
+
+static void event_handler_list_button(lv_event_t * e) {
+  lv_event_code_t code = lv_event_get_code(e);
+  if(code == LV_EVENT_CLICKED) {
+    LV_LOG_USER("List button pressed");
+    openBrowser(BROWSE_QUEUE, "");
   }
 }
 
+static void printDisplayStats(lv_timer_t *timer) {
+  tftDisplay.printStats();
+
+  uint32_t elapsedUs = (millis() - uiStatsStartedAt) * 1000;
+  if (elapsedUs > 0)
+    Serial.printf("[ui] inactiva %u.%u%% del tiempo\n", (uint32_t)((uint64_t)uiSleptUs * 100 / elapsedUs),
+                  (uint32_t)((uint64_t)uiSleptUs * 1000 / elapsedUs) % 10);
+  uiSleptUs = 0;
+  uiStatsStartedAt = millis();
+}
+
 void screenSetUp() {
   // Start LVGL
   lv_init();
+  // El tick de LVGL sale del esp_timer (millis), sin una interrupcion periodica que despierte al core
+  lv_tick_set_cb(uiTickMs);
   // Register print function for debugging
   lv_log_register_print_cb(log_print);
 
@@ -445,8 +1371,8 @@ void screenSetUp() {
 
   // Create a display object
   lv_display_t * disp;
-  // Initialize the TFT display using the TFT_eSPI library
-  disp = lv_tft_espi_create(SCREEN_WIDTH, SCREEN_HEIGHT, draw_buf, sizeof(draw_buf));
+  // Initialize the TFT display using the TFT_eSPI library, double buffered with DMA flushes
+  disp = tftDisplay.create(tft, SCREEN_WIDTH, SCREEN_HEIGHT, draw_buf_1, draw_buf_2, sizeof(draw_buf_1));
   lv_display_set_rotation(disp, LV_DISPLAY_ROTATION_90);
     
   // Initialize an LVGL input device object (Touchscreen)
@@ -454,9 +1380,16 @@ void screenSetUp() {
   lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
   // Set the callback function to read Touchscreen input
   lv_indev_set_read_cb(indev, touchscreen_read);
+  // Sin timer de lectura: loop() lee cuando llega la IRQ y mientras el dedo siga apoyado
+  lv_indev_set_mode(indev, LV_INDEV_MODE_EVENT);
+  touchIndev = indev;
+
+  pinMode(XPT2046_IRQ, INPUT);
+  attachInterrupt(digitalPinToInterrupt(XPT2046_IRQ), onTouchIrq, FALLING);
 }
 
 void drawMainGui(void) {
+  // Hasta la primera tapa; despues el fondo y el acento salen de ella (applyArtColors)
   lv_obj_set_style_bg_color(lv_screen_active(), lv_color_hex(0x383b39), 0);
 
   song_title = lv_label_create(lv_screen_active());
@@ -482,7 +1415,11 @@ void drawMainGui(void) {
   lv_obj_align(progress, LV_ALIGN_BOTTOM_MID, -120, -55);
   lv_obj_set_style_text_color(progress, lv_color_hex(0xb3b3b3), 0);
 
-  progress_bar = lv_bar_create(lv_screen_active());
+  progress_bar = lv_slider_create(lv_screen_active());
+  lv_obj_add_event_cb(progress_bar, event_handler_progress_bar, LV_EVENT_ALL, NULL);
+  // La barra mide 4 px: el toque se acepta un poco por fuera
+  lv_obj_set_ext_click_area(progress_bar, 12);
+  lv_bar_set_range(progress_bar, 0, PROGRESS_BAR_RANGE);
   lv_bar_set_start_value(progress_bar, 0, LV_ANIM_OFF);
   lv_obj_set_height(progress_bar, 4);
   lv_obj_set_width(progress_bar, lv_pct(60));
@@ -494,6 +1431,8 @@ void drawMainGui(void) {
   
   lv_obj_set_style_bg_color(progress_bar, lv_color_hex(0xFFFFFF), LV_PART_INDICATOR | LV_STATE_DEFAULT);
   lv_obj_set_style_bg_opa(progress_bar, 255, LV_PART_INDICATOR | LV_STATE_DEFAULT);
+  lv_obj_set_style_bg_color(progress_bar, lv_color_hex(0xFFFFFF), LV_PART_KNOB | LV_STATE_DEFAULT);
+  lv_obj_set_style_pad_all(progress_bar, 3, LV_PART_KNOB | LV_STATE_DEFAULT);
   lv_bar_set_value(progress_bar, 0, LV_ANIM_ON);
 
   duration = lv_label_create(lv_screen_active());
@@ -529,10 +1468,10 @@ void drawMainGui(void) {
   lv_obj_set_style_radius(play_pause_button, LV_RADIUS_CIRCLE, 0);
   lv_obj_set_style_shadow_width(play_pause_button, 0, 0);
 
-  btn_label = lv_label_create(play_pause_button);
-  lv_label_set_text(btn_label, LV_SYMBOL_PLAY);
-  lv_obj_set_style_text_color(btn_label, lv_color_hex(0x000000), 0);
-  lv_obj_center(btn_label);
+  play_pause_label = lv_label_create(play_pause_button);
+  lv_label_set_text_static(play_pause_label, LV_SYMBOL_PLAY);
+  lv_obj_set_style_text_color(play_pause_label, lv_color_hex(0x000000), 0);
+  lv_obj_center(play_pause_label);
 
   lv_obj_t * next_button = lv_button_create(lv_screen_active());
   lv_obj_add_event_cb(next_button, event_handler_next_button, LV_EVENT_ALL, NULL);
@@ -547,32 +1486,357 @@ void drawMainGui(void) {
   lv_label_set_text(btn_label, LV_SYMBOL_NEXT);
   lv_obj_set_style_text_color(btn_label, lv_color_hex(0xb3b3b3), 0);
   lv_obj_center(btn_label);
+
+  offline_icon = lv_label_create(lv_screen_active());
+  lv_label_set_text_static(offline_icon, LV_SYMBOL_WIFI);
+  lv_obj_set_style_text_color(offline_icon, lv_color_hex(0xe05555), 0);
+  lv_obj_align(offline_icon, LV_ALIGN_TOP_RIGHT, -8, 8);
+  lv_obj_add_flag(offline_icon, LV_OBJ_FLAG_HIDDEN);
+
+  lv_obj_t * list_button = lv_button_create(lv_screen_active());
+  lv_obj_add_event_cb(list_button, event_handler_list_button, LV_EVENT_ALL, NULL);
+  lv_obj_align(list_button, LV_ALIGN_TOP_RIGHT, -30, 0);
+  lv_obj_remove_flag(list_button, LV_OBJ_FLAG_PRESS_LOCK);
+  lv_obj_set_style_bg_opa(list_button, LV_OPA_TRANSP, 0);
+  lv_obj_set_size(list_button, 35, 35);
+  lv_obj_set_style_border_width(list_button, 0, 0);
+  lv_obj_set_style_shadow_width(list_button, 0, 0);
+
+  btn_label = lv_label_create(list_button);
+  lv_label_set_text(btn_label, LV_SYMBOL_LIST);
+  lv_obj_set_style_text_color(btn_label, lv_color_hex(0xb3b3b3), 0);
+  lv_obj_center(btn_label);
+
+  lv_obj_t * volume_icon = lv_label_create(lv_screen_active());
+  lv_label_set_text_static(volume_icon, LV_SYMBOL_VOLUME_MAX);
+  lv_obj_set_style_text_color(volume_icon, lv_color_hex(0xb3b3b3), 0);
+  lv_obj_align(volume_icon, LV_ALIGN_CENTER, 25, -45);
+
+  // Deshabilitado hasta que el dispositivo informe su volumen
+  volume_slider = lv_slider_create(lv_screen_active());
+  lv_obj_add_event_cb(volume_slider, event_handler_volume_slider, LV_EVENT_ALL, NULL);
+  lv_slider_set_range(volume_slider, 0, 100);
+  lv_obj_set_size(volume_slider, 95, 4);
+  lv_obj_align(volume_slider, LV_ALIGN_CENTER, 95, -45);
+  lv_obj_set_ext_click_area(volume_slider, 12);
+  lv_obj_set_style_bg_color(volume_slider, lv_color_hex(0x535353), LV_PART_MAIN | LV_STATE_DEFAULT);
+  lv_obj_set_style_bg_opa(volume_slider, 255, LV_PART_MAIN | LV_STATE_DEFAULT);
+  lv_obj_set_style_bg_color(volume_slider, lv_color_hex(0xFFFFFF), LV_PART_INDICATOR | LV_STATE_DEFAULT);
+  lv_obj_set_style_bg_color(volume_slider, lv_color_hex(0xFFFFFF), LV_PART_KNOB | LV_STATE_DEFAULT);
+  lv_obj_set_style_pad_all(volume_slider, 3, LV_PART_KNOB | LV_STATE_DEFAULT);
+  lv_obj_add_state(volume_slider, LV_STATE_DISABLED);
+}
+
+// El flag lo cambia la tarea de red y despierta a la UI; el label se toca solo si cambio
+static void updateOfflineIcon() {
+  bool offline = !linkOnline;
+  if (offline == offlineShown)
+    return;
+  offlineShown = offline;
+  if (offline)
+    lv_obj_remove_flag(offline_icon, LV_OBJ_FLAG_HIDDEN);
+  else
+    lv_obj_add_flag(offline_icon, LV_OBJ_FLAG_HIDDEN);
+}
+
+//========= Navegador (UI) =========
+
+// Encabezado con volver y las pestañas; debajo, la lista con 8 filas recicladas
+#define BROWSER_HEADER_H 36
+#define BROWSER_ROW_H 40
+#define BROWSER_VIEW_H (SCREEN_WIDTH - BROWSER_HEADER_H)
+// Tocar un tema de la cola salta hasta el; mas lejos que esto se corta
+#define BROWSER_QUEUE_MAX_SKIPS 10
+
+lv_obj_t *mainScreen;
+lv_obj_t *browserScreen;
+lv_obj_t *browserView;
+lv_obj_t *browserSpacer;
+int32_t browserSpacerHeight = -1;
+bool artRedrawPending = false;
+
+lv_obj_t *browserRows[BROWSER_ROW_SLOTS];
+lv_obj_t *browserRowImages[BROWSER_ROW_SLOTS];
+lv_obj_t *browserRowTitles[BROWSER_ROW_SLOTS];
+lv_obj_t *browserRowSubtitles[BROWSER_ROW_SLOTS];
+// Textos de las filas (lv_label_set_text_static): la pagina de donde salen se puede desalojar
+char browserTitleText[BROWSER_ROW_SLOTS][sizeof(BrowserItem::title)];
+char browserSubtitleText[BROWSER_ROW_SLOTS][sizeof(BrowserItem::subtitle)];
+
+// Una imagen de LVGL por slot del pool, apuntando a su buffer
+lv_image_dsc_t thumbImages[THUMB_SLOTS];
+
+class LvglRowSink : public BrowserRowSink {
+
+  public:
+    void bindRow(uint8_t slot, uint32_t index, const BrowserItem* item) override {
+      strlcpy(browserTitleText[slot], item ? item->title : "", sizeof(browserTitleText[slot]));
+      strlcpy(browserSubtitleText[slot], item ? item->subtitle : "", sizeof(browserSubtitleText[slot]));
+      lv_label_set_text_static(browserRowTitles[slot], browserTitleText[slot]);
+      lv_label_set_text_static(browserRowSubtitles[slot], browserSubtitleText[slot]);
+      lv_obj_set_y(browserRows[slot], index * BROWSER_ROW_H);
+      lv_obj_remove_flag(browserRows[slot], LV_OBJ_FLAG_HIDDEN);
+    }
+
+    void bindThumb(uint8_t slot, int thumbSlot) override {
+      if (thumbSlot < 0) {
+        lv_obj_add_flag(browserRowImages[slot], LV_OBJ_FLAG_HIDDEN);
+        return;
+      }
+      // El buffer del slot pudo haber tenido otra miniatura
+      lv_image_cache_drop(&thumbImages[thumbSlot]);
+      lv_image_set_src(browserRowImages[slot], &thumbImages[thumbSlot]);
+      lv_obj_invalidate(browserRowImages[slot]);
+      lv_obj_remove_flag(browserRowImages[slot], LV_OBJ_FLAG_HIDDEN);
+    }
+
+    void hideRow(uint8_t slot) override {
+      lv_obj_add_flag(browserRows[slot], LV_OBJ_FLAG_HIDDEN);
+    }
+};
+
+LvglRowSink browserRowSink;
+BrowserController browserController(BROWSER_ROW_H, BROWSER_VIEW_H, thumbPool, browserQueues, browserRowSink);
+
+static void openBrowser(BrowserSource source, const char* contextId) {
+  browserController.open(source, contextId);
+  lv_obj_scroll_to_y(browserView, 0, LV_ANIM_OFF);
+  if (!browserOpen) {
+    browserOpen = true;
+    lv_screen_load(browserScreen);
+  }
+}
+
+static void closeBrowser() {
+  browserOpen = false;
+  lv_screen_load(mainScreen);
+  artRedrawPending = true;
+}
+
+// Alto del area de scroll: solo cambia cuando llega el total de la lista
+static void updateBrowserSpacer() {
+  int32_t height = browserController.contentHeight();
+  if (height == browserSpacerHeight)
+    return;
+  browserSpacerHeight = height;
+  lv_obj_set_height(browserSpacer, height > 0 ? height : 1);
+}
+
+static void event_handler_browser_row(lv_event_t * e) {
+  uint8_t slot = (uint8_t)(uintptr_t)lv_event_get_user_data(e);
+  uint32_t index;
+  const BrowserItem* item = browserController.rowItem(slot, &index);
+  if (item == nullptr)
+    return;
+
+  if (browserController.source() == BROWSE_PLAYLISTS) {
+    openBrowser(BROWSE_PLAYLIST_TRACKS, item->id);
+  } else if (browserController.source() == BROWSE_PLAYLIST_TRACKS) {
+    LV_LOG_USER("Play from playlist");
+    showOptimisticSkip();
+    browserController.playFrom(index);
+    xTaskNotifyGive(networkTaskHandle);
+    closeBrowser();
+  } else {
+    // La cola no se puede reproducir desde una posicion: se salta hasta el tema tocado
+    LV_LOG_USER("Skip to queue item");
+    showOptimisticSkip();
+    uint32_t skips = min(index + 1, (uint32_t)BROWSER_QUEUE_MAX_SKIPS);
+    uint32_t seq = 0;
+    for (uint32_t i = 0; i < skips; i++)
+      seq = commands.next();
+    wakeNetworkTask(seq);
+    closeBrowser();
+  }
+}
+
+static void event_handler_browser_back(lv_event_t * e) {
+  closeBrowser();
+}
+
+static void event_handler_browser_queue(lv_event_t * e) {
+  openBrowser(BROWSE_QUEUE, "");
+}
+
+static void event_handler_browser_playlists(lv_event_t * e) {
+  openBrowser(BROWSE_PLAYLISTS, "");
+}
+
+static lv_obj_t* createHeaderButton(lv_obj_t* parent, const char* text, int32_t x, int32_t width, lv_event_cb_t handler) {
+  lv_obj_t * button = lv_button_create(parent);
+  lv_obj_add_event_cb(button, handler, LV_EVENT_CLICKED, NULL);
+  lv_obj_set_pos(button, x, 2);
+  lv_obj_set_size(button, width, BROWSER_HEADER_H - 4);
+  lv_obj_set_style_bg_opa(button, LV_OPA_TRANSP, 0);
+  lv_obj_set_style_shadow_width(button, 0, 0);
+
+  lv_obj_t * label = lv_label_create(button);
+  lv_label_set_text_static(label, text);
+  lv_obj_set_style_text_color(label, lv_color_hex(0xFFFFFF), 0);
+  lv_obj_center(label);
+  return button;
+}
+
+void drawBrowserGui(void) {
+  mainScreen = lv_screen_active();
+
+  for (int i = 0; i < THUMB_SLOTS; i++) {
+    thumbImages[i].header.magic = LV_IMAGE_HEADER_MAGIC;
+    thumbImages[i].header.cf = LV_COLOR_FORMAT_RGB565;
+    thumbImages[i].header.w = THUMB_SIZE;
+    thumbImages[i].header.h = THUMB_SIZE;
+    thumbImages[i].header.stride = THUMB_SIZE * sizeof(uint16_t);
+    thumbImages[i].data_size = THUMB_SIZE * THUMB_SIZE * sizeof(uint16_t);
+    thumbImages[i].data = (const uint8_t*)thumbPool.buffer(i);
+  }
+
+  browserScreen = lv_obj_create(NULL);
+  lv_obj_set_style_bg_color(browserScreen, lv_color_hex(0x383b39), 0);
+  lv_obj_remove_flag(browserScreen, LV_OBJ_FLAG_SCROLLABLE);
+
+  createHeaderButton(browserScreen, LV_SYMBOL_LEFT, 0, 44, event_handler_browser_back);
+  createHeaderButton(browserScreen, "Cola", 60, 100, event_handler_browser_queue);
+  createHeaderButton(browserScreen, "Playlists", 170, 120, event_handler_browser_playlists);
+
+  // Sin layout: cada fila se ubica a mano y el espaciador da el alto de toda la lista
+  browserView = lv_obj_create(browserScreen);
+  lv_obj_remove_style_all(browserView);
+  lv_obj_set_pos(browserView, 0, BROWSER_HEADER_H);
+  lv_obj_set_size(browserView, SCREEN_HEIGHT, BROWSER_VIEW_H);
+  lv_obj_set_scroll_dir(browserView, LV_DIR_VER);
+  lv_obj_set_scrollbar_mode(browserView, LV_SCROLLBAR_MODE_ACTIVE);
+
+  browserSpacer = lv_obj_create(browserView);
+  lv_obj_remove_style_all(browserSpacer);
+  lv_obj_set_size(browserSpacer, 1, 1);
+  lv_obj_remove_flag(browserSpacer, LV_OBJ_FLAG_CLICKABLE);
+
+  for (int slot = 0; slot < BROWSER_ROW_SLOTS; slot++) {
+    lv_obj_t * row = lv_obj_create(browserView);
+    lv_obj_remove_style_all(row);
+    lv_obj_set_size(row, SCREEN_HEIGHT, BROWSER_ROW_H);
+    lv_obj_remove_flag(row, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_add_flag(row, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_add_event_cb(row, event_handler_browser_row, LV_EVENT_CLICKED, (void*)(uintptr_t)slot);
+    browserRows[slot] = row;
+
+    browserRowImages[slot] = lv_image_create(row);
+    lv_obj_set_pos(browserRowImages[slot], 6, (BROWSER_ROW_H - THUMB_SIZE) / 2);
+    lv_obj_set_size(browserRowImages[slot], THUMB_SIZE, THUMB_SIZE);
+    lv_obj_add_flag(browserRowImages[slot], LV_OBJ_FLAG_HIDDEN);
+
+    browserRowTitles[slot] = lv_label_create(row);
+    lv_label_set_long_mode(browserRowTitles[slot], LV_LABEL_LONG_DOT);
+    lv_obj_set_pos(browserRowTitles[slot], THUMB_SIZE + 14, 3);
+    lv_obj_set_width(browserRowTitles[slot], SCREEN_HEIGHT - THUMB_SIZE - 22);
+    lv_obj_set_style_text_color(browserRowTitles[slot], lv_color_hex(0xFFFFFF), 0);
+
+    browserRowSubtitles[slot] = lv_label_create(row);
+    lv_label_set_long_mode(browserRowSubtitles[slot], LV_LABEL_LONG_DOT);
+    lv_obj_set_pos(browserRowSubtitles[slot], THUMB_SIZE + 14, 21);
+    lv_obj_set_width(browserRowSubtitles[slot], SCREEN_HEIGHT - THUMB_SIZE - 22);
+    lv_obj_set_style_text_color(browserRowSubtitles[slot], lv_color_hex(0xb3b3b3), 0);
+  }
+}
+
+// Una pasada del navegador por vuelta del loop, antes de que LVGL dibuje. Devuelve cuando hace falta otra
+static uint32_t browserFrame() {
+  if (!browserOpen)
+    return UINT32_MAX;
+
+  uint32_t wait = browserController.frame(lv_obj_get_scroll_y(browserView), millis());
+  updateBrowserSpacer();
+  if (!browserQueues.requests.empty() || !browserQueues.thumbRequests.empty())
+    xTaskNotifyGive(networkTaskHandle);
+  return wait;
+}
+
+// Con la pantalla principal ya pintada de nuevo; antes, LVGL taparia la tapa
+static void requestArtRedraw() {
+  if (!artRedrawPending)
+    return;
+  artRedrawPending = false;
+  artRedrawRequested = true;
+  xTaskNotifyGive(networkTaskHandle);
+}
+
+//========= Colores de la tapa =========
+
+uint32_t shownArtPalette = 0;
+
+static lv_color_t colorFrom565(uint16_t color) {
+  return lv_color_make((color >> 8) & 0xF8, (color >> 3) & 0xFC, (color << 3) & 0xF8);
+}
+
+// Alrededor de la tapa en cuatro franjas que LVGL no junta: un area que la incluya la taparia con el fondo
+static void invalidateAroundArt() {
+  if (artRight == 0) {
+    lv_obj_invalidate(mainScreen);
+    return;
+  }
+
+  lv_display_t * disp = lv_display_get_default();
+  int32_t width = lv_display_get_horizontal_resolution(disp);
+  int32_t height = lv_display_get_vertical_resolution(disp);
+  lv_area_t strips[4] = {
+    {0, 0, width - 1, ART_Y - 1},
+    {0, artBottom, width - 1, height - 1},
+    {0, ART_Y, ART_X - 1, artBottom - 1},
+    {artRight, ART_Y, width - 1, artBottom - 1},
+  };
+  for (int i = 0; i < 4; i++)
+    lv_inv_area(disp, &strips[i]);
+}
+
+// El fondo cambia con la invalidacion apagada: la tapa esta dibujada fuera de LVGL y un refresco de la
+// pantalla entera la borraria. Los sliders no la tocan y se invalidan solos
+static void applyArtColors(uint32_t palette) {
+  ArtColors colors;
+  if (palette == shownArtPalette || !ArtPalette::unpack(palette, colors))
+    return;
+  shownArtPalette = palette;
+
+  lv_color_t background = colorFrom565(colors.background);
+  lv_color_t accent = colorFrom565(colors.accent);
+
+  lv_display_t * disp = lv_display_get_default();
+  lv_display_enable_invalidation(disp, false);
+  lv_obj_set_style_bg_color(mainScreen, background, 0);
+  lv_obj_set_style_bg_color(browserScreen, background, 0);
+  lv_display_enable_invalidation(disp, true);
+  if (browserOpen)
+    lv_obj_invalidate(browserScreen);
+  else
+    invalidateAroundArt();
+
+  lv_obj_set_style_bg_color(progress_bar, accent, LV_PART_INDICATOR | LV_STATE_DEFAULT);
+  lv_obj_set_style_bg_color(progress_bar, accent, LV_PART_KNOB | LV_STATE_DEFAULT);
+  lv_obj_set_style_bg_color(volume_slider, accent, LV_PART_INDICATOR | LV_STATE_DEFAULT);
+  lv_obj_set_style_bg_color(volume_slider, accent, LV_PART_KNOB | LV_STATE_DEFAULT);
 }
 
 void setup() {
   Serial.begin(115200);
+  // loop() corre en esta misma tarea; la IRQ del tactil y la tarea de red la despiertan con notificaciones
+  uiTaskHandle = xTaskGetCurrentTaskHandle();
   
   String LVGL_Arduino = String("LVGL Library Version: ") + lv_version_major() + "." + lv_version_minor() + "." + lv_version_patch();
   Serial.println(LVGL_Arduino);
   
   ledController = RGBLedController();
 
-  connectToWifi(ssid, password);
-
+  // El WiFi conecta en la tarea de red mientras la pantalla ya muestra el ultimo tema guardado
   preferences.begin("spotify", false);
-
-  if (!tokenSaved()) {
-    Serial.println("No se encontró un Access Token. Generando y guardando uno nuevo...");
-    saveAccessToken(getNewAccessToken());
-  } else {
-    Serial.println("Access Token ya guardado: " + readAccessToken());
-  }
+  wifiPreferences.begin("wifi", false);
 
   if (!SPIFFS.begin(true)) {
     Serial.println("SPIFFS initialisation failed!");
     while (1) yield(); // Stay here twiddling thumbs waiting
   }
 
+  artCache.begin();
+  pixelCache.begin();
+
   tft.begin();
   tft.fillScreen(TFT_BLACK);
   tft.setRotation(2);
@@ -580,20 +1844,56 @@ void setup() {
   TJpgDec.setJpgScale(2);
   TJpgDec.setSwapBytes(true);
   TJpgDec.setCallback(tft_output);
+  artDecoder.setSwapBytes(true);
 
   screenSetUp();
 
   // Function to draw the GUI (text, buttons and sliders)
   drawMainGui();
+  drawBrowserGui();
+
+  progressTimer = lv_timer_create(updateProgressBar, PROGRESS_TICK_MS, NULL);
+  lv_timer_pause(progressTimer);
+  lv_timer_create(printDisplayStats, 10000, NULL);
+  uiStatsStartedAt = millis();
 
-  lv_timer_create(updateScreen, 5000, NULL);
-  lv_timer_create(updateProgressBar, 1000, NULL);
+#if CONFIG_PM_ENABLE
+  // Entre eventos la CPU baja de frecuencia; el APB queda en 80 MHz y no cambia el reloj del SPI
+  esp_pm_config_esp32_t pm = {.max_freq_mhz = 240, .min_freq_mhz = UI_MIN_CPU_MHZ, .light_sleep_enable = false};
+  esp_pm_configure(&pm);
+#endif
 
-  accessToken = readAccessToken();
+  // Consultas, token y descargas de tapas fuera del loop de LVGL
+  xTaskCreatePinnedToCore(networkTask, "spotify", NETWORK_TASK_STACK, NULL, 1, &networkTaskHandle, NETWORK_TASK_CORE);
 }
 
 void loop() {
-  lv_task_handler();  // let the GUI do its work
-  lv_tick_inc(5);     // tell LVGL how much time has passed
-  delay(5);           // let this time pass
-}
\ No newline at end of file
+  // Toque nuevo o dedo todavia apoyado: se lee ya, sin esperar a ningun timer
+  if (touchIrq || touchPressed) {
+    touchIrq = false;
+    lv_indev_read(touchIndev);
+  }
+  applySnapshots();
+  drawArtBlocks();
+  updateOfflineIcon();
+  uint32_t untilBrowser = browserFrame();
+
+  uint32_t frameStart = micros();
+  uint32_t untilTimer = lv_timer_handler();  // let the GUI do its work
+  metrics.record(STAGE_FRAME, micros() - frameStart);
+  requestArtRedraw();
+  if (bootLiveMs == 0)
+    recordBootFrame();
+  // "m", "mj" o "mr" por el monitor serie
+  metrics.serviceSerial(Serial);
+
+  // Duerme hasta el proximo timer de LVGL o hasta que alguien la despierte
+  uint32_t wait = untilTimer < UI_MAX_SLEEP_MS ? untilTimer : UI_MAX_SLEEP_MS;
+  if (untilBrowser < wait)
+    wait = untilBrowser;
+  if (touchPressed && wait > TOUCH_READ_MS)
+    wait = TOUCH_READ_MS;
+  uint32_t sleepStart = micros();
+  ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(wait));
+  uiSleptUs += micros() - sleepStart;
+}
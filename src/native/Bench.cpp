@@ -0,0 +1,262 @@
+#include "Bench.h"
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+#include <algorithm>
+#include <chrono>
+#include <dirent.h>
+#include <string>
+#include <vector>
+
+#include "PlaybackState.h"
+#include "PlaybackView.h"
+
+//========= Entrada =========
+
+// El cuerpo de la respuesta servido desde memoria, como lo entregaria getBodyStream()
+class MemoryStream : public Stream {
+
+  private:
+    const char* data;
+    size_t size;
+    size_t position;
+
+  public:
+    size_t write(uint8_t c) override { return 0; }
+    int available() override { return size - position; }
+    int read() override { return position < size ? (uint8_t)data[position++] : -1; }
+    int peek() override { return position < size ? (uint8_t)data[position] : -1; }
+
+    MemoryStream(const std::string& body) {
+        data = body.data();
+        size = body.size();
+        position = 0;
+    }
+};
+
+struct Payload {
+    std::string name;
+    std::string body;
+};
+
+static bool loadCorpus(const char* dir, std::vector<Payload>& payloads) {
+    DIR* d = opendir(dir);
+    if (d == nullptr) {
+        fprintf(stderr, "No se pudo abrir el corpus %s\n", dir);
+        return false;
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(d)) != nullptr) {
+        std::string name = entry->d_name;
+        if (name.size() <= 5 || name.compare(name.size() - 5, 5, ".json") != 0)
+            continue;
+
+        std::string path = std::string(dir) + "/" + name;
+        FILE* f = fopen(path.c_str(), "rb");
+        if (f == nullptr)
+            continue;
+        Payload payload;
+        payload.name = name.substr(0, name.size() - 5);
+        char buff[4096];
+        size_t n;
+        while ((n = fread(buff, 1, sizeof(buff), f)) > 0)
+            payload.body.append(buff, n);
+        fclose(f);
+        payloads.push_back(payload);
+    }
+    closedir(d);
+
+    // Mismo orden en cada corrida, asi los resultados se pueden comparar linea a linea
+    std::sort(payloads.begin(), payloads.end(), [](const Payload& a, const Payload& b) { return a.name < b.name; });
+    return !payloads.empty();
+}
+
+//========= Variantes =========
+
+// Cuenta la memoria que pide un JsonDocument sin limitarla, para la variante sin arena
+class CountingAllocator : public ArduinoJson::Allocator {
+
+  private:
+    struct Header {
+        size_t size;
+        size_t pad;
+    };
+
+  public:
+    size_t current = 0;
+    size_t peak = 0;
+
+    void* allocate(size_t size) override {
+        Header* h = (Header*)malloc(sizeof(Header) + size);
+        if (h == nullptr)
+            return nullptr;
+        h->size = size;
+        current += size;
+        if (current > peak)
+            peak = current;
+        return h + 1;
+    }
+
+    void deallocate(void* p) override {
+        if (p == nullptr)
+            return;
+        Header* h = (Header*)p - 1;
+        current -= h->size;
+        free(h);
+    }
+
+    void* reallocate(void* p, size_t size) override {
+        if (p == nullptr)
+            return allocate(size);
+        Header* h = (Header*)p - 1;
+        size_t old = h->size;
+        Header* moved = (Header*)realloc(h, sizeof(Header) + size);
+        if (moved == nullptr)
+            return nullptr;
+        moved->size = size;
+        current = current - old + size;
+        if (current > peak)
+            peak = current;
+        return moved + 1;
+    }
+};
+
+// El parser del firmware: filtro y arena estatico leyendo directo del stream
+static bool parseFilteredStream(const std::string& body, PlaybackState& state, size_t* peakBytes) {
+    MemoryStream input(body);
+    return parseCurrentlyPlaying(input, state, peakBytes);
+}
+
+// Como lo hacia el firmware original: getString() con el cuerpo entero y un JsonDocument sin filtro.
+// El pico incluye la copia del cuerpo, que vive mientras se parsea
+static bool parseFullDocument(const std::string& body, PlaybackState& state, size_t* peakBytes) {
+    CountingAllocator allocator;
+    String response = body.c_str();
+    bool ok;
+
+    {
+        JsonDocument doc(&allocator);
+        DeserializationError error = deserializeJson(doc, response.c_str(), response.length());
+        ok = !error;
+        if (ok) {
+            strlcpy(state.id, doc["item"]["id"] | "", sizeof(state.id));
+            strlcpy(state.name, doc["item"]["name"] | "", sizeof(state.name));
+            strlcpy(state.artist, doc["item"]["artists"][0]["name"] | "", sizeof(state.artist));
+            strlcpy(state.imageUrl, doc["item"]["album"]["images"][1]["url"] | "", sizeof(state.imageUrl));
+            state.imageWidth = 0;
+            state.progressMs = doc["progress_ms"] | 0;
+            state.durationMs = doc["item"]["duration_ms"] | 1;
+            state.isPlaying = doc["is_playing"] | false;
+            state.volumePercent = doc["device"]["volume_percent"] | -1;
+        }
+    }
+
+    if (peakBytes != nullptr)
+        *peakBytes = allocator.peak + response.length() + 1;
+    return ok;
+}
+
+struct Variant {
+    const char* name;
+    bool (*parse)(const std::string& body, PlaybackState& state, size_t* peakBytes);
+};
+
+// Un reemplazo del parser se agrega aca y queda medido contra el mismo corpus
+static const Variant variants[] = {
+    {"filtered_stream", parseFilteredStream},
+    {"full_document", parseFullDocument},
+};
+
+//========= Medicion =========
+
+struct Result {
+    bool ok;
+    size_t peakBytes;
+    double minUs;
+    double p50Us;
+    double maxUs;
+    uint8_t firstPaintWidgets;
+    uint8_t repeatWidgets;
+};
+
+static Result measure(const Variant& variant, const Payload& payload, uint32_t iterations) {
+    Result result;
+    PlaybackState state;
+    std::vector<double> times;
+    times.reserve(iterations);
+
+    // Una vuelta de calentamiento que ademas deja el pico de memoria y el estado para la UI
+    result.peakBytes = 0;
+    result.ok = variant.parse(payload.body, state, &result.peakBytes);
+
+    for (uint32_t i = 0; i < iterations; i++) {
+        auto start = std::chrono::steady_clock::now();
+        variant.parse(payload.body, state, nullptr);
+        auto end = std::chrono::steady_clock::now();
+        times.push_back(std::chrono::duration<double, std::micro>(end - start).count());
+    }
+    std::sort(times.begin(), times.end());
+    result.minUs = times.front();
+    result.p50Us = times[times.size() / 2];
+    result.maxUs = times.back();
+
+    // Widgets que toca la UI: pantalla recien encendida y la misma respuesta en la consulta siguiente
+    PlaybackView view;
+    result.firstPaintWidgets = result.ok ? widgetCount(view.changes(state)) : 0;
+    view.apply(state);
+    result.repeatWidgets = result.ok ? widgetCount(view.changes(state)) : 0;
+    return result;
+}
+
+static void jsonString(FILE* out, const char* text) {
+    fputc('"', out);
+    for (; *text != '\0'; text++) {
+        if (*text == '"' || *text == '\\')
+            fputc('\\', out);
+        fputc(*text, out);
+    }
+    fputc('"', out);
+}
+
+int runBench(const char* corpusDir, uint32_t iterations, const char* outPath) {
+    std::vector<Payload> payloads;
+    if (!loadCorpus(corpusDir, payloads))
+        return 1;
+    if (iterations == 0)
+        iterations = 1;
+
+    FILE* out = stdout;
+    if (outPath != nullptr && (out = fopen(outPath, "w")) == nullptr) {
+        fprintf(stderr, "No se pudo escribir %s\n", outPath);
+        return 1;
+    }
+
+    // El parser imprime los errores por Serial; en el reporte alcanza con "ok"
+    Serial.quiet = true;
+    uint32_t fallbacksBefore = jsonArenaFallbacks();
+
+    fprintf(out, "{\n  \"iterations\": %u,\n  \"payloads\": [\n", iterations);
+    for (size_t p = 0; p < payloads.size(); p++) {
+        const Payload& payload = payloads[p];
+        fprintf(out, "    {\"name\": ");
+        jsonString(out, payload.name.c_str());
+        fprintf(out, ", \"bytes\": %zu, \"variants\": {\n", payload.body.size());
+
+        size_t count = sizeof(variants) / sizeof(variants[0]);
+        for (size_t v = 0; v < count; v++) {
+            Result r = measure(variants[v], payload, iterations);
+            fprintf(out, "      \"%s\": {\"ok\": %s, \"peak_bytes\": %zu, \"parse_us\": {\"min\": %.2f, \"p50\": %.2f, \"max\": %.2f}, "
+                         "\"widgets_first_paint\": %u, \"widgets_repeat\": %u}%s\n",
+                    variants[v].name, r.ok ? "true" : "false", r.peakBytes, r.minUs, r.p50Us, r.maxUs,
+                    r.firstPaintWidgets, r.repeatWidgets, v + 1 < count ? "," : "");
+        }
+        fprintf(out, "    }}%s\n", p + 1 < payloads.size() ? "," : "");
+    }
+    fprintf(out, "  ],\n  \"arena_fallbacks\": %u\n}\n", jsonArenaFallbacks() - fallbacksBefore);
+
+    if (out != stdout)
+        fclose(out);
+    return 0;
+}
@@ -0,0 +1,10 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+// Mide el camino de /v1/me/player/currently-playing (parseo y diff de la UI) con cada JSON de corpusDir.
+// Escribe el resultado como JSON en outPath (o stdout si es nulo). Devuelve el codigo de salida del programa
+int runBench(const char* corpusDir, uint32_t iterations, const char* outPath);
+
+#endif
@@ -0,0 +1,239 @@
+#include "Browse.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+
+#include <atomic>
+#include <thread>
+
+#include "ArtCache.h"
+#include "BrowserController.h"
+#include "NativeClock.h"
+#include "PlayerSession.h"
+#include "Samples.h"
+#include "TokenManager.h"
+
+// Como la pantalla del ESP32: filas de 40 px en el area de 320x204 debajo del encabezado
+#define BROWSE_ROW_HEIGHT 40
+#define BROWSE_VIEW_HEIGHT 204
+// Periodo de refresco de LVGL (LV_DEF_REFR_PERIOD)
+#define BROWSE_FRAME_MS 33
+
+// Guion del dedo: filas por segundo durante ms. Se repite; al llegar a una punta cambia de sentido
+struct ScrollPhase {
+    int32_t rowsPerSecond;
+    uint32_t ms;
+};
+
+static const ScrollPhase script[] = {
+    {0, 1500},   // leyendo
+    {6, 3000},   // scroll lento
+    {45, 2000},  // fling
+    {0, 1500},
+    {-20, 1000}, // vuelve un poco
+    {0, 1000},
+    {30, 2500},
+};
+
+//========= Tarea de red =========
+
+class NullListener : public PlayerListener {
+
+  public:
+    void onSnapshot(PlaybackSnapshot& snapshot) override {}
+};
+
+// Lo mismo que hace networkTask() en el ESP32 con el navegador abierto. Las miniaturas no se
+// decodifican (no hay TJpgDec en Linux): se bajan enteras y se llena el buffer del slot
+static void networkLoop(MockSpotify* mock, ThumbPool* thumbs, BrowserQueues* queues, std::atomic<bool>* stop,
+                        uint32_t* browseRequests, uint32_t* thumbBytes) {
+    MockTransport api(*mock, "api");
+    MockTransport accounts(*mock, "accounts");
+    MockTransport images(*mock, "images");
+    Preferences preferences;
+    preferences.begin("browse", false);
+    TokenManager tokens(accounts, preferences, "mock-refresh-token", "mock-client-id", "mock-client-secret");
+    CommandCoalescer commands;
+    NullListener listener;
+    PlayerSession session(api, tokens, commands, listener);
+    session.begin();
+
+    static BrowserPage page;
+    while (!stop->load()) {
+        BrowserRequest request;
+        if (queues->requests.pop(request)) {
+            if (request.play) {
+                session.playContext(request.contextId, request.offset);
+            } else {
+                session.fetchBrowserPage(request, page);
+                queues->pages.push(page);
+            }
+            continue;
+        }
+
+        // De a una miniatura, asi una pagina pedida mientras tanto no espera a todas
+        ThumbRequest thumb;
+        if (queues->thumbRequests.pop(thumb)) {
+            const char* prefix = "https://i.scdn.co";
+            ThumbResult result = {thumb.slot, thumb.key, false};
+            if (strncmp(thumb.url, prefix, strlen(prefix)) == 0 && images.GET(thumb.url + strlen(prefix)) == 200) {
+                Stream& body = images.getBodyStream();
+                uint16_t* pixels = thumbs->buffer(thumb.slot);
+                uint32_t n = 0;
+                int c;
+                while ((c = body.read()) >= 0) {
+                    pixels[n % (THUMB_SIZE * THUMB_SIZE)] ^= (uint16_t)(c * 257);
+                    n++;
+                }
+                *thumbBytes += n;
+                result.ok = true;
+            }
+            images.end();
+            queues->thumbResults.push(result);
+            continue;
+        }
+
+        NativeClock::advance(1);
+    }
+    *browseRequests = session.browseRequests();
+}
+
+//========= UI =========
+
+// Copia los textos como los labels del ESP32 y cuenta lo que se toca por frame
+class CountingSink : public BrowserRowSink {
+
+  public:
+    char titles[BROWSER_ROW_SLOTS][sizeof(BrowserItem::title)];
+    char subtitles[BROWSER_ROW_SLOTS][sizeof(BrowserItem::subtitle)];
+    int32_t y[BROWSER_ROW_SLOTS];
+    uint32_t rowBinds = 0;
+    uint32_t thumbBinds = 0;
+    uint32_t hides = 0;
+
+    void bindRow(uint8_t slot, uint32_t index, const BrowserItem* item) override {
+        strlcpy(titles[slot], item ? item->title : "", sizeof(titles[slot]));
+        strlcpy(subtitles[slot], item ? item->subtitle : "", sizeof(subtitles[slot]));
+        y[slot] = index * BROWSE_ROW_HEIGHT;
+        rowBinds++;
+    }
+
+    void bindThumb(uint8_t slot, int thumbSlot) override {
+        thumbBinds++;
+    }
+
+    void hideRow(uint8_t slot) override {
+        hides++;
+    }
+};
+
+int runBrowse(MockSpotify& mock, uint64_t durationMs, bool json) {
+    NativeClock::setSimulated(false);
+    Serial.quiet = true;
+
+    static ThumbPool thumbs;
+    static BrowserQueues queues;
+    CountingSink sink;
+    BrowserController browser(BROWSE_ROW_HEIGHT, BROWSE_VIEW_HEIGHT, thumbs, queues, sink);
+
+    std::atomic<bool> stop(false);
+    uint32_t browseRequests = 0;
+    uint32_t thumbBytes = 0;
+    std::thread network(networkLoop, &mock, &thumbs, &queues, &stop, &browseRequests, &thumbBytes);
+
+    browser.open(BROWSE_PLAYLIST_TRACKS, "mockplaylist00");
+
+    static Samples frameUs;
+    static Samples fillMs;
+    uint32_t maxRowBinds = 0;
+    uint32_t unfilledStops = 0;
+    uint32_t maxItems = 0;
+
+    double scrollY = 0;
+    int32_t direction = 1;
+    size_t phase = 0;
+    uint64_t start = NativeClock::elapsedMs();
+    uint64_t phaseStart = start;
+    uint64_t stillSince = start;
+    bool filled = false;
+
+    for (uint64_t now = start; now - start < durationMs; now = NativeClock::elapsedMs()) {
+        if (now - phaseStart >= script[phase].ms) {
+            // Se dejo de scrollear sin que se completara la pantalla
+            if (script[phase].rowsPerSecond == 0 && !filled) {
+                unfilledStops++;
+                fillMs.add(now - stillSince);
+            }
+            phase = (phase + 1) % (sizeof(script) / sizeof(script[0]));
+            phaseStart = now;
+            stillSince = now;
+            filled = false;
+        }
+
+        double maxY = browser.contentHeight() - BROWSE_VIEW_HEIGHT;
+        scrollY += direction * script[phase].rowsPerSecond * BROWSE_ROW_HEIGHT * BROWSE_FRAME_MS / 1000.0;
+        if (scrollY > maxY || scrollY < 0) {
+            scrollY = scrollY < 0 ? 0 : maxY > 0 ? maxY : 0;
+            direction = -direction;
+        }
+
+        uint32_t empty = browser.emptyRows();
+        uint32_t missing = browser.missingThumbs();
+        uint32_t binds = sink.rowBinds;
+
+        uint32_t startUs = micros();
+        browser.frame((int32_t)scrollY, millis());
+        frameUs.add(micros() - startUs);
+
+        if (sink.rowBinds - binds > maxRowBinds)
+            maxRowBinds = sink.rowBinds - binds;
+        if (browser.pages().itemsInMemory() > maxItems)
+            maxItems = browser.pages().itemsInMemory();
+
+        // Quieto: cuanto tarda en no quedar ninguna fila vacia ni sin miniatura
+        bool complete = browser.emptyRows() == empty && browser.missingThumbs() == missing;
+        if (script[phase].rowsPerSecond == 0 && !filled && complete && browser.contentHeight() > 0) {
+            fillMs.add(now - stillSince);
+            filled = true;
+        }
+
+        NativeClock::advance(BROWSE_FRAME_MS);
+    }
+
+    stop = true;
+    network.join();
+    Serial.quiet = false;
+
+    const BrowserList& pages = browser.pages();
+    uint32_t totalPages = (pages.size() + BROWSER_PAGE_SIZE - 1) / BROWSER_PAGE_SIZE;
+    double emptyPercent = browser.visibleRows() ? 100.0 * browser.emptyRows() / browser.visibleRows() : 0;
+    double missingPercent = browser.visibleRows() ? 100.0 * browser.missingThumbs() / browser.visibleRows() : 0;
+    uint32_t pageBytes = BROWSER_WINDOW_PAGES * sizeof(BrowserPage);
+
+    if (json) {
+        printf("{\n  \"rows\": %u,\n  \"frames\": %u,\n  \"row_widgets\": %u,\n", pages.size(), browser.frames(), BROWSER_ROW_SLOTS);
+        printf("  \"frame_us\": {\"p50\": %u, \"p99\": %u, \"max\": %u},\n", frameUs.percentile(0.50), frameUs.percentile(0.99), frameUs.max);
+        printf("  \"row_binds\": %u,\n  \"max_row_binds_per_frame\": %u,\n", sink.rowBinds, maxRowBinds);
+        printf("  \"visible_row_frames\": %u,\n  \"empty_row_frames\": %u,\n  \"missing_thumb_frames\": %u,\n",
+               browser.visibleRows(), browser.emptyRows(), browser.missingThumbs());
+        printf("  \"stop_to_complete_ms\": {\"count\": %u, \"p50\": %u, \"p95\": %u, \"max\": %u, \"unfilled\": %u},\n",
+               fillMs.count, fillMs.percentile(0.50), fillMs.percentile(0.95), fillMs.max, unfilledStops);
+        printf("  \"pages\": {\"total\": %u, \"loaded\": %u, \"evicted\": %u, \"requests\": %u, \"max_items\": %u, \"bytes\": %u},\n",
+               totalPages, pages.pagesLoaded(), pages.pagesEvicted(), browseRequests, maxItems, pageBytes);
+        printf("  \"thumbs\": {\"requests\": %u, \"loads\": %u, \"hits\": %u, \"evictions\": %u, \"downloaded_bytes\": %u, \"pool_bytes\": %u}\n}\n",
+               browser.thumbRequests(), thumbs.loads(), thumbs.hits(), thumbs.evictions(), thumbBytes, thumbs.bytes());
+    } else {
+        printf("\nNavegador: %u filas, %u pasadas de %u ms, %u widgets de fila\n", pages.size(), browser.frames(), BROWSE_FRAME_MS,
+               BROWSER_ROW_SLOTS);
+        printf("Pasada de la UI: p50=%u p99=%u max=%u us, %u filas rellenadas (max %u en una pasada)\n", frameUs.percentile(0.50),
+               frameUs.percentile(0.99), frameUs.max, sink.rowBinds, maxRowBinds);
+        printf("Filas visibles: %u, vacias %.1f%%, sin miniatura %.1f%%\n", browser.visibleRows(), emptyPercent, missingPercent);
+        printf("Al dejar de scrollear, pantalla completa en p50=%u p95=%u max=%u ms (%u de %u paradas sin completar)\n",
+               fillMs.percentile(0.50), fillMs.percentile(0.95), fillMs.max, unfilledStops, fillMs.count);
+        printf("Paginas: %u de %u traidas, %u desalojadas, %u peticiones, max %u filas en memoria (%u bytes fijos)\n",
+               pages.pagesLoaded(), totalPages, pages.pagesEvicted(), browseRequests, maxItems, pageBytes);
+        printf("Miniaturas: %u pedidas, %u cargadas, %u aciertos, %u desalojadas, %u bytes bajados, pool de %u bytes\n",
+               browser.thumbRequests(), thumbs.loads(), thumbs.hits(), thumbs.evictions(), thumbBytes, thumbs.bytes());
+    }
+    return pages.size() > 0 ? 0 : 1;
+}
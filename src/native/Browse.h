@@ -0,0 +1,14 @@
+#ifndef BROWSE_H
+#define BROWSE_H
+
+#include <stdint.h>
+
+#include "MockSpotify.h"
+
+// El navegador contra la playlist mas larga del mock, en tiempo real. Este hilo hace de UI y scrollea
+// con un guion (lectura, scroll lento, flings); otro hilo hace de tarea de red y trae paginas y
+// miniaturas por las mismas colas que en el ESP32. Al final imprime cuantas filas se vieron vacias,
+// cuanto tarda la pantalla en completarse cuando se deja de scrollear y la memoria fija que usa.
+int runBrowse(MockSpotify& mock, uint64_t durationMs, bool json);
+
+#endif
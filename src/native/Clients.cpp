@@ -0,0 +1,164 @@
+#include "Clients.h"
+
+#include <Arduino.h>
+#include <Client.h>
+
+#include <deque>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "BridgeClient.h"
+#include "NativeClock.h"
+#include "Samples.h"
+
+// Cada cuanto se mira a todos los controladores
+#define CLIENTS_STEP_MS 5
+#define ART_FETCH_TIMEOUT_MS 2000
+
+struct PendingCommand {
+    uint32_t seq;
+    uint64_t at;
+};
+
+// Lo que haria la UI de cada pantalla: mostrar el snapshot y bajar la tapa del puente
+class SimulatedController : public PlayerListener {
+
+  private:
+    char artUrl[sizeof(PlaybackState::imageUrl)];
+
+    // GET de una sola vez, como getFile() del firmware
+    void fetchArt(const char* url) {
+        char host[64];
+        unsigned port;
+        char path[64];
+        if (sscanf(url, "http://%63[^:]:%u%63s", host, &port, path) != 3)
+            return;
+
+        NativeTcpClient http;
+        if (!http.connect(host, port))
+            return;
+        http.printf("GET %s HTTP/1.0\r\nHost: %s\r\n\r\n", path, host);
+
+        std::string response;
+        uint64_t start = NativeClock::elapsedMs();
+        while (http.connected() && NativeClock::elapsedMs() - start < ART_FETCH_TIMEOUT_MS) {
+            int c = http.read();
+            if (c < 0) {
+                NativeClock::advance(1);
+                continue;
+            }
+            response += (char)c;
+        }
+        if (response.compare(0, 12, "HTTP/1.0 200") == 0) {
+            artFetches++;
+            artBytes += response.size();
+        } else {
+            artFailures++;
+        }
+    }
+
+  public:
+    std::unique_ptr<NativeTcpClient> socket;
+    std::unique_ptr<BridgeClient> bridge;
+    std::string name;
+    std::deque<PendingCommand> pending;
+    uint32_t nextSeq = 0;
+    uint32_t snapshots = 0;
+    uint32_t artFetches = 0;
+    uint32_t artFailures = 0;
+    uint64_t artBytes = 0;
+    Samples* ackLatency = nullptr;
+
+    void onSnapshot(PlaybackSnapshot& snapshot) override {
+        uint64_t now = NativeClock::elapsedMs();
+        snapshots++;
+
+        while (!pending.empty() && (int32_t)(snapshot.commandSeq - pending.front().seq) >= 0) {
+            ackLatency->add(now - pending.front().at);
+            pending.pop_front();
+        }
+
+        if (snapshot.active && strcmp(artUrl, snapshot.state.imageUrl) != 0) {
+            strlcpy(artUrl, snapshot.state.imageUrl, sizeof(artUrl));
+            fetchArt(artUrl);
+        }
+    }
+
+    SimulatedController() {
+        artUrl[0] = '\0';
+    }
+};
+
+int runClients(const char* bridge, uint32_t count, uint64_t durationMs, uint32_t tapEveryMs, bool json) {
+    char host[64];
+    unsigned port = BRIDGE_PORT;
+    if (sscanf(bridge, "%63[^:]:%u", host, &port) < 1)
+        return 2;
+
+    static Samples ackLatency;
+    std::vector<std::unique_ptr<SimulatedController>> controllers;
+    for (uint32_t i = 0; i < count; i++) {
+        SimulatedController* controller = new SimulatedController();
+        controller->name = "sim-" + std::to_string(i);
+        controller->ackLatency = &ackLatency;
+        controller->socket.reset(new NativeTcpClient());
+        controller->bridge.reset(new BridgeClient(*controller->socket, host, port, controller->name.c_str(), *controller));
+        controllers.emplace_back(controller);
+    }
+
+    uint64_t start = NativeClock::elapsedMs();
+    uint64_t nextTapAt = start + tapEveryMs;
+    uint32_t taps = 0;
+
+    while (NativeClock::elapsedMs() - start < durationMs) {
+        uint32_t now = millis();
+        for (auto& controller : controllers) {
+            if (controller->bridge->connect(now))
+                controller->bridge->step(now);
+        }
+
+        if (tapEveryMs > 0 && NativeClock::elapsedMs() >= nextTapAt && count > 0) {
+            SimulatedController& controller = *controllers[taps % count];
+            TransportBatch batch = {1, -1, ++controller.nextSeq, -1, -1};
+            controller.bridge->sendCommand(batch);
+            controller.pending.push_back({batch.seq, NativeClock::elapsedMs()});
+            nextTapAt += tapEveryMs;
+            taps++;
+        }
+
+        NativeClock::advance(CLIENTS_STEP_MS);
+    }
+
+    uint32_t snapshots = 0, messages = 0, connects = 0, artFetches = 0, artFailures = 0, unacked = 0;
+    uint64_t bytes = 0, artBytes = 0;
+    for (auto& controller : controllers) {
+        snapshots += controller->snapshots;
+        messages += controller->bridge->messages();
+        bytes += controller->bridge->bytes();
+        connects += controller->bridge->connects();
+        artFetches += controller->artFetches;
+        artFailures += controller->artFailures;
+        artBytes += controller->artBytes;
+        unacked += controller->pending.size();
+    }
+    double minutes = durationMs / 60000.0;
+
+    if (json) {
+        printf("{\n  \"controllers\": %u,\n  \"duration_ms\": %llu,\n  \"connects\": %u,\n", count, (unsigned long long)durationMs, connects);
+        printf("  \"state_messages\": %u,\n  \"state_bytes\": %llu,\n  \"snapshots\": %u,\n", messages, (unsigned long long)bytes, snapshots);
+        printf("  \"art\": {\"fetches\": %u, \"failures\": %u, \"bytes\": %llu},\n", artFetches, artFailures, (unsigned long long)artBytes);
+        printf("  \"taps\": %u,\n  \"unacked\": %u,\n", taps, unacked);
+        printf("  \"ack_ms\": {\"count\": %u, \"p50\": %u, \"p95\": %u, \"max\": %u}\n}\n",
+               ackLatency.count, ackLatency.percentile(0.50), ackLatency.percentile(0.95), ackLatency.max);
+    } else {
+        printf("\n%u controladores durante %.1f min contra %s:%u (%u conexiones)\n", count, minutes, host, port, connects);
+        printf("Estado: %u mensajes, %llu bytes (%.0f bytes/min por controlador)\n", messages, (unsigned long long)bytes,
+               count > 0 && minutes > 0 ? bytes / minutes / count : 0.0);
+        printf("Tapas bajadas del puente: %u (%llu bytes), %u fallidas\n", artFetches, (unsigned long long)artBytes, artFailures);
+        printf("Comandos: %u, sin confirmar %u, confirmacion p50=%u p95=%u max=%u ms\n", taps, unacked,
+               ackLatency.percentile(0.50), ackLatency.percentile(0.95), ackLatency.max);
+        printf("Las peticiones a spotify son las del puente (su log cada minuto)\n");
+    }
+    return connects > 0 ? 0 : 1;
+}
@@ -0,0 +1,11 @@
+#ifndef CLIENTS_H
+#define CLIENTS_H
+
+#include <stdint.h>
+
+// Varios controladores simulados contra un puente (env:bridge) en host:port, en tiempo real.
+// Cada tapEveryMs uno de ellos, por turno, manda un "next". Al final imprime mensajes, bytes,
+// tapas bajadas del puente y cuanto tardo cada comando en volver confirmado.
+int runClients(const char* bridge, uint32_t count, uint64_t durationMs, uint32_t tapEveryMs, bool json);
+
+#endif
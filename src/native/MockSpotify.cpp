@@ -0,0 +1,769 @@
+#include "MockSpotify.h"
+
+#include "Metrics.h"
+#include "NativeClock.h"
+
+#define DAY_MS (24ULL * 60 * 60 * 1000)
+// La simulacion arranca al mediodia
+#define START_TIME_OF_DAY_MS (12ULL * 60 * 60 * 1000)
+
+//========= Escenario =========
+
+// "80ms", "15s", "10m", "1h", "7d"
+static bool parseTime(const char* text, uint64_t& ms) {
+    char* end;
+    double value = strtod(text, &end);
+    if (end == text)
+        return false;
+
+    if (strcmp(end, "ms") == 0)
+        ms = value;
+    else if (strcmp(end, "s") == 0 || *end == '\0')
+        ms = value * 1000;
+    else if (strcmp(end, "m") == 0)
+        ms = value * 60 * 1000;
+    else if (strcmp(end, "h") == 0)
+        ms = value * 60 * 60 * 1000;
+    else if (strcmp(end, "d") == 0)
+        ms = value * DAY_MS;
+    else
+        return false;
+    return true;
+}
+
+// "1/40"
+static bool parseRatio(const char* text, uint32_t& oneIn) {
+    unsigned n;
+    if (sscanf(text, "1/%u", &n) != 1 || n == 0)
+        return false;
+    oneIn = n;
+    return true;
+}
+
+// "22:30"
+static bool parseTimeOfDay(const char* text, uint64_t& ms) {
+    unsigned hours, minutes;
+    if (sscanf(text, "%u:%u", &hours, &minutes) != 2 || hours > 23 || minutes > 59)
+        return false;
+    ms = (hours * 60ULL + minutes) * 60 * 1000;
+    return true;
+}
+
+bool MockSpotify::load(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        fprintf(stderr, "No se pudo abrir el escenario %s\n", path);
+        return false;
+    }
+
+    faults.clear();
+    taps.clear();
+    tracks.clear();
+    playlists.clear();
+
+    char line[256];
+    int number = 0;
+    bool ok = true;
+    while (ok && fgets(line, sizeof(line), f)) {
+        number++;
+        char* comment = strchr(line, '#');
+        if (comment)
+            *comment = '\0';
+
+        char* words[8];
+        int count = 0;
+        char* rest = nullptr;
+        for (char* word = strtok_r(line, " \t\r\n", &rest); word && count < 8; word = strtok_r(nullptr, " \t\r\n", &rest))
+            words[count++] = word;
+        if (count == 0)
+            continue;
+
+        const char* key = words[0];
+        uint64_t time;
+        if (strcmp(key, "duration") == 0 && count == 2) {
+            ok = parseTime(words[1], durationMs);
+        } else if (strcmp(key, "latency") == 0 && count == 2) {
+            ok = parseTime(words[1], time);
+            latencyMs = time;
+        } else if (strcmp(key, "slow") == 0 && count == 3) {
+            ok = parseRatio(words[1], slowOneIn) && parseTime(words[2], time);
+            slowMs = time;
+        } else if (strcmp(key, "fail") == 0 && (count == 3 || count == 5)) {
+            MockFault fault = {atoi(words[1]), 0, 0};
+            ok = fault.status >= 400 && parseRatio(words[2], fault.oneIn);
+            if (ok && count == 5)
+                ok = strcmp(words[3], "retry") == 0 && parseTime(words[4], time) && (fault.retryAfterSec = time / 1000, true);
+            faults.push_back(fault);
+        } else if (strcmp(key, "token_lifetime") == 0 && count == 2) {
+            ok = parseTime(words[1], time);
+            tokenLifetimeMs = time;
+        } else if (strcmp(key, "token_fail") == 0 && count == 2) {
+            ok = parseRatio(words[1], tokenFailOneIn);
+        } else if (strcmp(key, "idle") == 0 && count == 3) {
+            ok = parseTimeOfDay(words[1], idleFromMs) && parseTimeOfDay(words[2], idleToMs);
+            hasIdle = ok;
+        } else if (strcmp(key, "tap") == 0 && (count == 4 || count == 5) && strcmp(words[2], "every") == 0) {
+            MockTap tap;
+            strlcpy(tap.command, words[1], sizeof(tap.command));
+            tap.count = count == 5 && words[4][0] == 'x' ? atoi(words[4] + 1) : 1;
+            ok = parseTime(words[3], tap.periodMs) && tap.periodMs > 0 && tap.count > 0 &&
+                 (strcmp(tap.command, "next") == 0 || strcmp(tap.command, "prev") == 0 || strcmp(tap.command, "play") == 0 ||
+                  strcmp(tap.command, "seek") == 0 || strcmp(tap.command, "volume") == 0);
+            taps.push_back(tap);
+        } else if (strcmp(key, "track") == 0 && count >= 3) {
+            MockTrack track;
+            ok = parseTime(words[1], time);
+            track.durationMs = time;
+            snprintf(track.id, sizeof(track.id), "mock%04u", (unsigned)tracks.size());
+            std::string name = words[2];
+            for (int i = 3; i < count; i++)
+                name = name + " " + words[i];
+            strlcpy(track.name, name.c_str(), sizeof(track.name));
+            tracks.push_back(track);
+        } else if (strcmp(key, "playlist") == 0 && count >= 3) {
+            MockPlaylist playlist;
+            playlist.size = strtoul(words[1], nullptr, 10);
+            snprintf(playlist.id, sizeof(playlist.id), "mockplaylist%02u", (unsigned)playlists.size());
+            std::string name = words[2];
+            for (int i = 3; i < count; i++)
+                name = name + " " + words[i];
+            strlcpy(playlist.name, name.c_str(), sizeof(playlist.name));
+            ok = playlist.size > 0;
+            playlists.push_back(playlist);
+        } else if (strcmp(key, "etag") == 0 && count == 2) {
+            ok = true;
+            if (strcmp(words[1], "state") == 0)
+                etagMode = ETAG_STATE;
+            else if (strcmp(words[1], "body") == 0)
+                etagMode = ETAG_BODY;
+            else if (strcmp(words[1], "off") == 0)
+                etagMode = ETAG_OFF;
+            else
+                ok = false;
+        } else if (strcmp(key, "flap") == 0 && count == 5 && strcmp(words[1], "every") == 0 && strcmp(words[3], "for") == 0) {
+            ok = parseTime(words[2], flapEveryMs) && parseTime(words[4], flapDownMs) && flapDownMs < flapEveryMs;
+        } else if (strcmp(key, "link_connect") == 0 && count == 2) {
+            ok = parseTime(words[1], time);
+            linkConnectMs = time;
+        } else if (strcmp(key, "seed") == 0 && count == 2) {
+            seed = strtoul(words[1], nullptr, 10);
+        } else {
+            ok = false;
+        }
+
+        if (!ok)
+            fprintf(stderr, "%s:%d: linea invalida\n", path, number);
+    }
+    fclose(f);
+
+    if (tracks.empty())
+        loadDefaults();
+    return ok;
+}
+
+void MockSpotify::loadDefaults() {
+    // Una playlist larga para el navegador
+    if (playlists.empty()) {
+        MockPlaylist playlist = {"mockplaylist00", "Mil temas", 1000};
+        playlists.push_back(playlist);
+    }
+
+    if (!tracks.empty())
+        return;
+    const uint32_t durations[] = {185000, 242000, 201000, 318000, 96000, 264000, 1620000, 227000};
+    for (size_t i = 0; i < sizeof(durations) / sizeof(durations[0]); i++) {
+        MockTrack track;
+        snprintf(track.id, sizeof(track.id), "mock%04u", (unsigned)i);
+        snprintf(track.name, sizeof(track.name), "Cancion de prueba %u", (unsigned)i + 1);
+        track.durationMs = durations[i];
+        tracks.push_back(track);
+    }
+}
+
+//========= Reproduccion =========
+
+uint32_t MockSpotify::random() {
+    // xorshift32: reproducible con el mismo seed
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return seed;
+}
+
+bool MockSpotify::oneIn(uint32_t n) {
+    return n > 0 && random() % n == 0;
+}
+
+uint64_t MockSpotify::now() const {
+    return NativeClock::elapsedMs();
+}
+
+bool MockSpotify::inIdleWindow(uint64_t at) const {
+    if (!hasIdle)
+        return false;
+    uint64_t timeOfDay = (at + START_TIME_OF_DAY_MS) % DAY_MS;
+    if (idleFromMs <= idleToMs)
+        return timeOfDay >= idleFromMs && timeOfDay < idleToMs;
+    return timeOfDay >= idleFromMs || timeOfDay < idleToMs;
+}
+
+// Avanza la reproduccion hasta ahora: fin de canciones y la ventana sin reproduccion
+void MockSpotify::update() {
+    uint64_t at = now();
+
+    while (playing && at - trackStartedAt >= tracks[current].durationMs) {
+        trackStartedAt += tracks[current].durationMs;
+        current = (current + 1) % tracks.size();
+        currentSince = trackStartedAt;
+    }
+
+    bool idleNow = inIdleWindow(at);
+    if (idleNow && !idle)
+        setPlaying(false);
+    else if (!idleNow && idle)
+        setPlaying(true);
+    idle = idleNow;
+}
+
+uint32_t MockSpotify::progressMs() {
+    return playing ? (uint32_t)(now() - trackStartedAt) : pausedProgressMs;
+}
+
+void MockSpotify::skip(int delta) {
+    current = (current + tracks.size() + delta) % tracks.size();
+    trackStartedAt = now();
+    pausedProgressMs = 0;
+    currentSince = now();
+}
+
+void MockSpotify::setPlaying(bool play) {
+    if (play == playing)
+        return;
+    if (play)
+        trackStartedAt = now() - pausedProgressMs;
+    else
+        pausedProgressMs = progressMs();
+    playing = play;
+}
+
+void MockSpotify::seek(uint32_t positionMs) {
+    update();
+    if (positionMs > tracks[current].durationMs)
+        positionMs = tracks[current].durationMs;
+    if (playing)
+        trackStartedAt = now() - positionMs;
+    else
+        pausedProgressMs = positionMs;
+}
+
+const char* MockSpotify::currentId() {
+    update();
+    return tracks[current].id;
+}
+
+uint64_t MockSpotify::currentTrackSince() {
+    update();
+    return currentSince;
+}
+
+//========= Respuestas =========
+
+void MockSpotify::imagesJson(std::string& out, const MockTrack& track) const {
+    const uint16_t widths[] = {640, 300, 64};
+    char image[128];
+    out += "\"images\":[";
+    for (int i = 0; i < 3; i++) {
+        snprintf(image, sizeof(image), "%s{\"height\":%u,\"url\":\"https://i.scdn.co/image/%s-%u\",\"width\":%u}",
+                 i > 0 ? "," : "", widths[i], track.id, widths[i], widths[i]);
+        out += image;
+    }
+    out += "]";
+}
+
+MockResponse MockSpotify::currentlyPlaying(const char* ifNoneMatch) {
+    if (idle)
+        return {204, "", 0, ""};
+
+    const MockTrack& track = tracks[current];
+    char head[512];
+    snprintf(head, sizeof(head),
+             "{\"timestamp\":%llu,\"context\":null,\"progress_ms\":%u,\"item\":{\"album\":{\"album_type\":\"album\",",
+             (unsigned long long)currentSince, progressMs());
+
+    MockResponse response = {200, head, 0, ""};
+    imagesJson(response.body, track);
+    snprintf(head, sizeof(head),
+             ",\"name\":\"Album de prueba\"},\"artists\":[{\"name\":\"Artista de prueba\",\"type\":\"artist\"}],"
+             "\"duration_ms\":%u,\"explicit\":false,\"id\":\"%s\",\"name\":\"%s\",\"popularity\":50,\"type\":\"track\"},"
+             "\"currently_playing_type\":\"track\",\"device\":{\"type\":\"Computer\",\"volume_percent\":%u},\"is_playing\":%s}",
+             track.durationMs, track.id, track.name, volumePercent, playing ? "true" : "false");
+    response.body += head;
+
+    char etag[48] = "";
+    if (etagMode == ETAG_STATE) {
+        // trackStartedAt cambia con un seek aunque siga sonando lo mismo
+        snprintf(etag, sizeof(etag), "\"%s-%llu-%s%u\"", track.id, (unsigned long long)trackStartedAt,
+                 playing ? "play" : "pause", playing ? 0 : progressMs());
+    } else if (etagMode == ETAG_BODY) {
+        uint32_t hash = 2166136261u;
+        for (char c : response.body)
+            hash = (hash ^ (uint8_t)c) * 16777619u;
+        snprintf(etag, sizeof(etag), "\"%08x\"", hash);
+    }
+    if (etag[0] != '\0' && strcmp(etag, ifNoneMatch) == 0)
+        return {304, "", 0, etag};
+    response.etag = etag;
+    return response;
+}
+
+void MockSpotify::trackJson(std::string& out, const MockTrack& track) const {
+    char text[512];
+    out += "{\"album\":{\"album_type\":\"album\",";
+    imagesJson(out, track);
+    snprintf(text, sizeof(text),
+             ",\"name\":\"Album de prueba\"},\"artists\":[{\"name\":\"Artista de prueba\",\"type\":\"artist\"}],"
+             "\"duration_ms\":%u,\"explicit\":false,\"id\":\"%s\",\"name\":\"%s\",\"type\":\"track\"}",
+             track.durationMs, track.id, track.name);
+    out += text;
+}
+
+// Como spotify: los proximos 20, aunque la lista se repita
+MockResponse MockSpotify::queue() {
+    MockResponse response = {200, "{\"queue\":[", 0, ""};
+    for (size_t i = 1; i <= 20; i++) {
+        if (i > 1)
+            response.body += ",";
+        trackJson(response.body, tracks[(current + i) % tracks.size()]);
+    }
+    response.body += "]}";
+    return response;
+}
+
+// "offset=24&limit=12" dentro de la query
+static uint32_t queryValue(const char* query, const char* name, uint32_t fallback) {
+    size_t length = strlen(name);
+    for (const char* at = query; at != nullptr && *at; at = strchr(at, '&')) {
+        if (*at == '&' || *at == '?')
+            at++;
+        if (strncmp(at, name, length) == 0 && at[length] == '=')
+            return strtoul(at + length + 1, nullptr, 10);
+    }
+    return fallback;
+}
+
+MockResponse MockSpotify::userPlaylists(const char* query) {
+    uint32_t offset = queryValue(query, "offset", 0);
+    uint32_t limit = queryValue(query, "limit", 20);
+
+    MockResponse response = {200, "{\"items\":[", 0, ""};
+    char text[768];
+    char images[384];
+    for (uint32_t i = offset; i < playlists.size() && i < offset + limit; i++) {
+        const MockPlaylist& playlist = playlists[i];
+        // Como spotify: los mosaicos vienen en 640, 300 y 60 px; las tapas propias, una sola y sin medidas
+        if (i % 4 == 3) {
+            snprintf(images, sizeof(images), "{\"height\":null,\"url\":\"https://i.scdn.co/image/%s-640\",\"width\":null}", playlist.id);
+        } else {
+            snprintf(images, sizeof(images),
+                     "{\"height\":640,\"url\":\"https://mosaic.scdn.co/640/%s\",\"width\":640},"
+                     "{\"height\":300,\"url\":\"https://mosaic.scdn.co/300/%s\",\"width\":300},"
+                     "{\"height\":60,\"url\":\"https://i.scdn.co/image/%s-60\",\"width\":60}",
+                     playlist.id, playlist.id, playlist.id);
+        }
+        snprintf(text, sizeof(text),
+                 "%s{\"collaborative\":false,\"id\":\"%s\",\"images\":[%s],"
+                 "\"name\":\"%s\",\"tracks\":{\"total\":%u},\"type\":\"playlist\"}",
+                 i > offset ? "," : "", playlist.id, images, playlist.name, playlist.size);
+        response.body += text;
+    }
+    snprintf(text, sizeof(text), "],\"limit\":%u,\"offset\":%u,\"total\":%u}", limit, offset, (unsigned)playlists.size());
+    response.body += text;
+    return response;
+}
+
+// Temas numerados; cada uno con su tapa, asi el navegador baja una miniatura por fila
+MockResponse MockSpotify::playlistTracks(const char* id, const char* query) {
+    const MockPlaylist* playlist = nullptr;
+    for (const MockPlaylist& p : playlists) {
+        if (strncmp(id, p.id, strlen(p.id)) == 0 && (id[strlen(p.id)] == '/' || id[strlen(p.id)] == '\0'))
+            playlist = &p;
+    }
+    if (playlist == nullptr)
+        return {404, "", 0, ""};
+
+    uint32_t offset = queryValue(query, "offset", 0);
+    uint32_t limit = queryValue(query, "limit", 100);
+
+    MockResponse response = {200, "{\"items\":[", 0, ""};
+    for (uint32_t i = offset; i < playlist->size && i < offset + limit; i++) {
+        MockTrack track;
+        snprintf(track.id, sizeof(track.id), "pl%s-%05u", playlist->id + 12, (unsigned)i);
+        snprintf(track.name, sizeof(track.name), "Tema %u de %s", (unsigned)i + 1, playlist->name);
+        track.durationMs = 150000 + (i * 7919) % 120000;
+        response.body += i > offset ? ",{\"added_at\":\"2024-01-01T00:00:00Z\",\"track\":" : "{\"added_at\":\"2024-01-01T00:00:00Z\",\"track\":";
+        trackJson(response.body, track);
+        response.body += "}";
+    }
+    char text[96];
+    snprintf(text, sizeof(text), "],\"limit\":%u,\"offset\":%u,\"total\":%u}", limit, offset, playlist->size);
+    response.body += text;
+    return response;
+}
+
+MockResponse MockSpotify::api(const char* method, const char* path, const String& authorization, const char* ifNoneMatch) {
+    std::string expected = "Bearer " + token;
+    if (token.empty() || expected != authorization.c_str())
+        return {401, "{\"error\":{\"status\":401,\"message\":\"Invalid access token\"}}", 0, ""};
+    if (now() - tokenIssuedAt >= tokenLifetimeMs) {
+        expired401++;
+        return {401, "{\"error\":{\"status\":401,\"message\":\"The access token expired\"}}", 0, ""};
+    }
+
+    for (const MockFault& fault : faults) {
+        if (!oneIn(fault.oneIn))
+            continue;
+        injected++;
+        // Un 401 inyectado es un token revocado: sigue fallando hasta que se pida otro
+        if (fault.status == 401)
+            token.clear();
+        return {fault.status, "", fault.retryAfterSec, ""};
+    }
+
+    if (strcmp(method, "GET") == 0 && strcmp(path, "/v1/me/player/currently-playing") == 0)
+        return currentlyPlaying(ifNoneMatch);
+    if (strcmp(method, "GET") == 0 && strcmp(path, "/v1/me/player/queue") == 0)
+        return queue();
+    if (strcmp(method, "GET") == 0 && strncmp(path, "/v1/me/playlists", 16) == 0)
+        return userPlaylists(strchr(path, '?'));
+    if (strcmp(method, "GET") == 0 && strncmp(path, "/v1/playlists/", 14) == 0)
+        return playlistTracks(path + 14, strchr(path, '?'));
+    if (strcmp(method, "POST") == 0 && strcmp(path, "/v1/me/player/next") == 0) {
+        skip(1);
+        return {204, "", 0, ""};
+    }
+    if (strcmp(method, "POST") == 0 && strcmp(path, "/v1/me/player/previous") == 0) {
+        skip(-1);
+        return {204, "", 0, ""};
+    }
+    if (strcmp(method, "PUT") == 0 && strcmp(path, "/v1/me/player/play") == 0) {
+        setPlaying(true);
+        return {204, "", 0, ""};
+    }
+    if (strcmp(method, "PUT") == 0 && strcmp(path, "/v1/me/player/pause") == 0) {
+        setPlaying(false);
+        return {204, "", 0, ""};
+    }
+    if (strcmp(method, "PUT") == 0 && strncmp(path, "/v1/me/player/seek?", 19) == 0) {
+        seek(queryValue(path + 18, "position_ms", 0));
+        return {204, "", 0, ""};
+    }
+    if (strcmp(method, "PUT") == 0 && strncmp(path, "/v1/me/player/volume?", 21) == 0) {
+        uint32_t percent = queryValue(path + 20, "volume_percent", 0);
+        volumePercent = percent > 100 ? 100 : percent;
+        return {204, "", 0, ""};
+    }
+    return {404, "", 0, ""};
+}
+
+MockResponse MockSpotify::accounts(const char* path) {
+    if (strcmp(path, "/api/token") != 0)
+        return {404, "", 0, ""};
+    if (oneIn(tokenFailOneIn)) {
+        injected++;
+        return {503, "", 0, ""};
+    }
+
+    tokenSerial++;
+    token = "mock-token-" + std::to_string(tokenSerial);
+    tokenIssuedAt = now();
+
+    char body[160];
+    snprintf(body, sizeof(body), "{\"access_token\":\"%s\",\"token_type\":\"Bearer\",\"expires_in\":%u,\"scope\":\"user-read-playback-state\"}",
+             token.c_str(), tokenLifetimeMs / 1000);
+    return {200, body, 0, ""};
+}
+
+MockResponse MockSpotify::images(const char* path) {
+    // JPEG de mentira: alcanza con SOI/EOI para que la cache lo valide
+    uint32_t hash = 2166136261u;
+    for (const char* c = path; *c; c++)
+        hash = (hash ^ (uint8_t)*c) * 16777619u;
+
+    // Las de 64 y 60 px (miniaturas del navegador) pesan como las de spotify, unos 2 KB
+    size_t length = strlen(path);
+    bool thumb = length > 3 && (strcmp(path + length - 3, "-64") == 0 || strcmp(path + length - 3, "-60") == 0);
+    MockResponse response = {200, std::string(thumb ? 1500 + hash % 1500 : 6000 + hash % 6000, '\0'), 0, ""};
+    for (size_t i = 2; i < response.body.size() - 2; i++)
+        response.body[i] = (char)(hash >> (i % 24));
+    response.body[0] = (char)0xFF;
+    response.body[1] = (char)0xD8;
+    response.body[response.body.size() - 2] = (char)0xFF;
+    response.body[response.body.size() - 1] = (char)0xD9;
+    return response;
+}
+
+MockResponse MockSpotify::handle(const char* host, const char* method, const char* path, const String& authorization,
+                                 const char* ifNoneMatch) {
+    uint32_t latency = latencyMs;
+    if (oneIn(slowOneIn))
+        latency += slowMs;
+
+    // Sin AP no hay respuesta: lwIP corta enseguida porque la interfaz no tiene ruta
+    if (!linkAvailable()) {
+        NativeClock::advance(10);
+        return {-1, "", 0, ""};
+    }
+
+    // El servidor contesta con el estado de la mitad del viaje
+    NativeClock::advance(latency / 2);
+    update();
+
+    MockResponse response;
+    if (strcmp(host, "api") == 0)
+        response = api(method, path, authorization, ifNoneMatch);
+    else if (strcmp(host, "accounts") == 0)
+        response = accounts(path);
+    else
+        response = images(path);
+
+    NativeClock::advance(latency - latency / 2);
+    return response;
+}
+
+uint64_t MockSpotify::duration() const {
+    return durationMs;
+}
+
+void MockSpotify::setDuration(uint64_t ms) {
+    durationMs = ms;
+}
+
+const std::vector<MockTap>& MockSpotify::scriptedTaps() const {
+    return taps;
+}
+
+uint32_t MockSpotify::expiredTokenRejections() const {
+    return expired401;
+}
+
+uint32_t MockSpotify::injectedFaults() const {
+    return injected;
+}
+
+//========= WiFi =========
+
+// Las caidas empiezan en cada multiplo de flapEveryMs y duran flapDownMs
+bool MockSpotify::linkAvailable() const {
+    if (flapEveryMs == 0)
+        return true;
+    uint64_t at = now();
+    return at < flapEveryMs || at % flapEveryMs >= flapDownMs;
+}
+
+uint64_t MockSpotify::nextLinkChangeAt() const {
+    if (flapEveryMs == 0)
+        return UINT64_MAX;
+    uint64_t at = now();
+    uint64_t start = at - at % flapEveryMs;
+    if (at >= flapEveryMs && at - start < flapDownMs)
+        return start + flapDownMs;
+    return start + flapEveryMs;
+}
+
+uint64_t MockSpotify::linkRestoredAt() const {
+    uint64_t at = now();
+    if (flapEveryMs == 0 || at < flapEveryMs + flapDownMs)
+        return 0;
+    uint64_t restored = at - at % flapEveryMs + flapDownMs;
+    return restored <= at ? restored : restored - flapEveryMs;
+}
+
+uint32_t MockSpotify::linkConnectTime() const {
+    return linkConnectMs;
+}
+
+uint32_t MockSpotify::linkDrops() const {
+    return flapEveryMs == 0 ? 0 : now() / flapEveryMs;
+}
+
+MockSpotify::MockSpotify() {
+    durationMs = 7 * DAY_MS;
+    latencyMs = 120;
+    slowOneIn = 0;
+    slowMs = 0;
+    tokenLifetimeMs = 3600 * 1000;
+    tokenFailOneIn = 0;
+    etagMode = ETAG_OFF;
+    hasIdle = false;
+    idleFromMs = 0;
+    idleToMs = 0;
+    seed = 2463534242u;
+    flapEveryMs = 0;
+    flapDownMs = 0;
+    linkConnectMs = 1500;
+
+    current = 0;
+    playing = true;
+    volumePercent = 60;
+    idle = false;
+    trackStartedAt = 0;
+    pausedProgressMs = 0;
+    currentSince = 0;
+
+    tokenIssuedAt = 0;
+    tokenSerial = 0;
+    expired401 = 0;
+    injected = 0;
+}
+
+//========= Transporte =========
+
+int MockTransport::BodyStream::available() {
+    return owner->response.body.size() - owner->readPosition;
+}
+
+int MockTransport::BodyStream::read() {
+    if (owner->readPosition >= owner->response.body.size())
+        return -1;
+    return (uint8_t)owner->response.body[owner->readPosition++];
+}
+
+int MockTransport::BodyStream::peek() {
+    if (owner->readPosition >= owner->response.body.size())
+        return -1;
+    return (uint8_t)owner->response.body[owner->readPosition];
+}
+
+int MockTransport::send(const char* method, const char* path) {
+    uint64_t start = NativeClock::elapsedMs();
+    requestCount++;
+
+    // If-None-Match solo acompaña a un GET y solo a esa peticion, igual que en SpotifyClient
+    response = server->handle(host, method, path, authorization, strcmp(method, "GET") == 0 ? ifNoneMatch.c_str() : "");
+    ifNoneMatch.clear();
+    readPosition = 0;
+
+    uint32_t elapsed = NativeClock::elapsedMs() - start;
+    if (latencies != nullptr)
+        latencies->add(elapsed);
+    metrics.record(STAGE_HTTP_WAIT, elapsed * 1000);
+    bool counted = false;
+    for (auto& entry : statusCounts) {
+        if (entry.first == response.status) {
+            entry.second++;
+            counted = true;
+        }
+    }
+    if (!counted)
+        statusCounts.push_back({response.status, 1});
+    return response.status;
+}
+
+void MockTransport::setAuthorization(const String& value) {
+    authorization = value;
+}
+
+void MockTransport::setIfNoneMatch(const char* etag) {
+    ifNoneMatch = etag != nullptr ? etag : "";
+}
+
+int MockTransport::GET(const char* path) {
+    return send("GET", path);
+}
+
+int MockTransport::PUT(const char* path, const String& body, const char* contentType) {
+    return send("PUT", path);
+}
+
+int MockTransport::POST(const char* path, const String& body, const char* contentType) {
+    return send("POST", path);
+}
+
+String MockTransport::getString() {
+    String text(response.body.substr(readPosition));
+    readPosition = response.body.size();
+    return text;
+}
+
+Stream& MockTransport::getBodyStream() {
+    return body;
+}
+
+int MockTransport::getSize() {
+    return response.body.size();
+}
+
+bool MockTransport::etag(char* out, size_t size) {
+    return strlcpy(out, response.etag.c_str(), size) < size;
+}
+
+uint32_t MockTransport::retryAfter() {
+    return response.retryAfterSec;
+}
+
+void MockTransport::end() {
+    readPosition = response.body.size();
+}
+
+void MockTransport::abort() {
+    end();
+}
+
+uint32_t MockTransport::requests() const {
+    return requestCount;
+}
+
+const char* MockTransport::hostName() const {
+    return host;
+}
+
+void MockTransport::printStats() {
+    Serial.printf("[mock %s] peticiones: %u\n", host, requestCount);
+}
+
+MockTransport::MockTransport(MockSpotify& server, const char* host) {
+    this->server = &server;
+    this->host = host;
+    readPosition = 0;
+    requestCount = 0;
+    latencies = nullptr;
+    response = {0, "", 0, ""};
+    body.owner = this;
+}
+
+//========= Link =========
+
+// Igual que WiFi.begin(): arranca la asociacion y vuelve enseguida
+uint32_t MockLink::connect(uint32_t attempt) {
+    associated = false;
+    connecting = true;
+    connectStartedAt = NativeClock::elapsedMs();
+    return 10000;
+}
+
+bool MockLink::isUp() {
+    uint64_t at = NativeClock::elapsedMs();
+    if (!server->linkAvailable()) {
+        associated = false;
+        return false;
+    }
+    // La asociacion cuenta desde que se pidio o desde que volvio el AP, lo que pase despues
+    uint64_t from = connectStartedAt > server->linkRestoredAt() ? connectStartedAt : server->linkRestoredAt();
+    if (connecting && at - from >= server->linkConnectTime()) {
+        connecting = false;
+        associated = true;
+    }
+    return associated;
+}
+
+void MockLink::disconnect() {
+    associated = false;
+    connecting = false;
+}
+
+MockLink::MockLink(MockSpotify& server) {
+    this->server = &server;
+    associated = false;
+    connecting = false;
+    connectStartedAt = 0;
+}
@@ -0,0 +1,217 @@
+#ifndef MOCKSPOTIFY_H
+#define MOCKSPOTIFY_H
+
+#include <Arduino.h>
+#include <string>
+#include <vector>
+
+#include "HttpTransport.h"
+#include "NetworkLink.h"
+#include "Samples.h"
+
+// Falla inyectada en api.spotify.com: 1 de cada oneIn peticiones responde status
+struct MockFault {
+    int status;
+    uint32_t oneIn;
+    uint32_t retryAfterSec;  // Solo para 429
+};
+
+// Toques simulados del usuario: count veces command cada periodMs
+struct MockTap {
+    char command[8];  // next, prev, play, seek, volume (estos dos son arrastres: count eventos seguidos)
+    uint64_t periodMs;
+    uint8_t count;
+};
+
+struct MockTrack {
+    char id[24];
+    char name[96];
+    uint32_t durationMs;
+};
+
+// Playlist generada: size temas con nombres numerados, para el navegador
+struct MockPlaylist {
+    char id[24];
+    char name[64];
+    uint32_t size;
+};
+
+struct MockResponse {
+    int status;
+    std::string body;
+    uint32_t retryAfterSec;
+    std::string etag;
+};
+
+// Que cubre el ETag de currently-playing
+enum MockEtagMode {
+    ETAG_OFF,    // Sin ETag, como si spotify no lo mandara
+    ETAG_STATE,  // Cancion, play/pausa y progreso solo en pausa: un 304 mientras suena el mismo tema
+    ETAG_BODY    // El cuerpo entero: con progress_ms adentro, solo hay 304 en pausa
+};
+
+// Spotify falso para env:native. Lleva una reproduccion que avanza con el reloj (simulado o real),
+// valida el token, responde a los comandos e inyecta lo que diga el escenario: 401, 204, 429, 5xx y respuestas lentas.
+class MockSpotify {
+
+  private:
+    // Escenario
+    uint64_t durationMs;
+    uint32_t latencyMs;
+    uint32_t slowOneIn;
+    uint32_t slowMs;
+    uint32_t tokenLifetimeMs;
+    uint32_t tokenFailOneIn;
+    MockEtagMode etagMode;
+    bool hasIdle;
+    uint64_t idleFromMs;  // Hora del dia, en ms desde las 00:00
+    uint64_t idleToMs;
+    std::vector<MockFault> faults;
+    std::vector<MockTap> taps;
+    std::vector<MockTrack> tracks;
+    std::vector<MockPlaylist> playlists;
+    uint32_t seed;
+    uint64_t flapEveryMs;  // Cada cuanto se cae el WiFi (0: nunca)
+    uint64_t flapDownMs;   // Cuanto tarda en volver el AP
+    uint32_t linkConnectMs;
+
+    // Reproduccion
+    size_t current;
+    bool playing;
+    bool idle;
+    uint64_t trackStartedAt;  // Si esta en pausa, el progreso es pausedProgressMs
+    uint32_t pausedProgressMs;
+    uint8_t volumePercent;
+    uint64_t currentSince;
+
+    // Token
+    std::string token;
+    uint64_t tokenIssuedAt;
+    uint32_t tokenSerial;
+
+    uint32_t expired401;
+    uint32_t injected;
+
+    uint32_t random();
+    bool oneIn(uint32_t n);
+    uint64_t now() const;
+    bool inIdleWindow(uint64_t at) const;
+    void update();
+    uint32_t progressMs();
+    void skip(int delta);
+    void setPlaying(bool play);
+    void seek(uint32_t positionMs);
+
+    void imagesJson(std::string& out, const MockTrack& track) const;
+    void trackJson(std::string& out, const MockTrack& track) const;
+    MockResponse currentlyPlaying(const char* ifNoneMatch);
+    MockResponse queue();
+    MockResponse userPlaylists(const char* query);
+    MockResponse playlistTracks(const char* id, const char* query);
+    MockResponse api(const char* method, const char* path, const String& authorization, const char* ifNoneMatch);
+    MockResponse accounts(const char* path);
+    MockResponse images(const char* path);
+
+  public:
+    // Lee el escenario (ver src/native/scenarios). Devuelve false si hay una linea que no entiende
+    bool load(const char* path);
+    void loadDefaults();
+
+    // Atiende una peticion y mueve el reloj lo que tarde la respuesta
+    MockResponse handle(const char* host, const char* method, const char* path, const String& authorization,
+                        const char* ifNoneMatch = "");
+
+    uint64_t duration() const;
+    void setDuration(uint64_t ms);
+    const std::vector<MockTap>& scriptedTaps() const;
+
+    // Para medir cuanto tarda la pantalla en enterarse de un cambio de cancion
+    const char* currentId();
+    uint64_t currentTrackSince();
+
+    uint32_t expiredTokenRejections() const;
+    uint32_t injectedFaults() const;
+
+    // Caidas del WiFi del escenario. Mientras el AP no esta, toda peticion falla sin respuesta
+    bool linkAvailable() const;
+    uint64_t nextLinkChangeAt() const;
+    uint64_t linkRestoredAt() const;  // Cuando volvio el AP por ultima vez (0: nunca se cayo)
+    uint32_t linkConnectTime() const;
+    uint32_t linkDrops() const;
+
+    MockSpotify();
+};
+
+// El WiFi del mock: asocia linkConnectTime() despues de pedirlo, si el AP esta
+class MockLink : public NetworkLink {
+
+  private:
+    MockSpotify* server;
+    bool associated;
+    bool connecting;
+    uint64_t connectStartedAt;
+
+  public:
+    uint32_t connect(uint32_t attempt) override;
+    bool isUp() override;
+    void disconnect() override;
+
+    MockLink(MockSpotify& server);
+};
+
+// HttpTransport contra un host del mock. Guarda cada peticion para el reporte
+class MockTransport : public HttpTransport {
+
+  private:
+    MockSpotify* server;
+    const char* host;
+    String authorization;
+    std::string ifNoneMatch;
+
+    MockResponse response;
+    size_t readPosition;
+
+    // Stream sobre el cuerpo de la ultima respuesta
+    class BodyStream : public Stream {
+
+      public:
+        MockTransport* owner;
+
+        size_t write(uint8_t c) override { return 0; }
+        int available() override;
+        int read() override;
+        int peek() override;
+    } body;
+
+    uint32_t requestCount;
+
+    int send(const char* method, const char* path);
+
+  public:
+    // Tiempo de cada peticion (si se pasa un histograma) y codigos, los completa send()
+    Samples* latencies;
+    std::vector<std::pair<int, uint32_t>> statusCounts;
+
+    void setAuthorization(const String& value) override;
+    void setIfNoneMatch(const char* etag) override;
+
+    int GET(const char* path) override;
+    int PUT(const char* path, const String& body = "", const char* contentType = nullptr) override;
+    int POST(const char* path, const String& body = "", const char* contentType = nullptr) override;
+
+    String getString() override;
+    Stream& getBodyStream() override;
+    int getSize() override;
+    bool etag(char* out, size_t size) override;
+    uint32_t retryAfter() override;
+    void end() override;
+    void abort() override;
+
+    uint32_t requests() const override;
+    const char* hostName() const;
+    void printStats() override;
+
+    MockTransport(MockSpotify& server, const char* host);
+};
+
+#endif
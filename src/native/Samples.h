@@ -0,0 +1,47 @@
+#ifndef SAMPLES_H
+#define SAMPLES_H
+
+#include <Arduino.h>
+
+// Histograma de memoria fija, asi las mediciones no cuentan en el heap que se esta midiendo.
+// Exacto hasta EXACT_MS, despues en baldes de COARSE_MS
+struct Samples {
+    static constexpr uint32_t EXACT_MS = 2048;
+    static constexpr uint32_t COARSE_MS = 100;
+    static constexpr uint32_t COARSE_BUCKETS = 1200;
+
+    uint32_t exact[EXACT_MS] = {};
+    uint32_t coarse[COARSE_BUCKETS] = {};
+    uint32_t count = 0;
+    uint32_t max = 0;
+
+    void add(uint32_t value) {
+        if (value < EXACT_MS)
+            exact[value]++;
+        else
+            coarse[min((value - EXACT_MS) / COARSE_MS, COARSE_BUCKETS - 1)]++;
+        count++;
+        if (value > max)
+            max = value;
+    }
+
+    uint32_t percentile(double p) const {
+        if (count == 0)
+            return 0;
+        uint32_t rank = (uint32_t)(p * (count - 1)) + 1;
+        uint32_t seen = 0;
+        for (uint32_t i = 0; i < EXACT_MS; i++) {
+            seen += exact[i];
+            if (seen >= rank)
+                return i;
+        }
+        for (uint32_t i = 0; i < COARSE_BUCKETS; i++) {
+            seen += coarse[i];
+            if (seen >= rank)
+                return min(EXACT_MS + (i + 1) * COARSE_MS, max);
+        }
+        return max;
+    }
+};
+
+#endif
@@ -0,0 +1,448 @@
+// env:native: la logica de red del controlador (PlayerSession, TokenManager, PollScheduler, ArtCache)
+// corriendo en Linux contra MockSpotify.
+//
+//   program [--soak] [--scenario archivo] [--duration 7d] [--json] [--verbose] [--fs dir]
+//   program --bench corpus [--iterations N] [--out archivo]
+//   program --clients N [--bridge host:4680] [--duration 10m] [--tap-every 20] [--json]
+//   program --browse [--scenario archivo] [--duration 1m] [--json]
+//
+// Sin --soak corre en tiempo real y muestra el mismo log que el ESP32. Con --soak el reloj es simulado:
+// una semana corre en segundos y al final se imprime el reporte (latencias, heap, peticiones).
+// Con --bench mide el parseo de currently-playing con cada JSON del corpus y escribe el resultado en JSON.
+// Con --clients corre N controladores simulados contra un puente (env:bridge), en tiempo real.
+// Con --browse scrollea el navegador por una playlist de 1000 temas, en tiempo real.
+
+#include <Arduino.h>
+#include <FS.h>
+#include <Preferences.h>
+
+#include <deque>
+#include <vector>
+
+#include "Bench.h"
+#include "Browse.h"
+#include "Clients.h"
+#include "Samples.h"
+
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "NativeClock.h"
+#include "MockSpotify.h"
+#include "PlayerSession.h"
+#include "TokenManager.h"
+#include "CommandCoalescer.h"
+#include "ConnectivityManager.h"
+#include "ArtCache.h"
+#include "Metrics.h"
+
+#define DEFAULT_REALTIME_DURATION_MS (2 * 60 * 1000ULL)
+#define DEFAULT_BROWSE_DURATION_MS (60 * 1000ULL)
+// Un evento de arrastre por frame de LVGL
+#define DRAG_EVENT_MS 33
+#define ART_CACHE_BUDGET_BYTES (256 * 1024)
+// El heap despues de la primera hora simulada es la referencia para ver si crece
+#define WARMUP_MS (60 * 60 * 1000ULL)
+
+//========= Mediciones =========
+
+static size_t heapInUse() {
+#ifdef __GLIBC__
+    return mallinfo2().uordblks;
+#else
+    return 0;
+#endif
+}
+
+struct PendingTap {
+    uint32_t seq;
+    uint64_t at;
+};
+
+//========= Escucha =========
+
+// Hace lo que hace la UI del ESP32 con cada snapshot y mide cuanto tardo en enterarse
+class SoakListener : public PlayerListener {
+
+  private:
+    MockSpotify* mock;
+    MockTransport* images;
+    ArtCache* cache;
+
+    char shownId[sizeof(PlaybackState::id)];
+    char artUrl[sizeof(PlaybackState::imageUrl)];
+    uint64_t measuredRestore;
+
+    void downloadArt(const char* url) {
+        const char* prefix = "https://i.scdn.co";
+        if (strncmp(url, prefix, strlen(prefix)) != 0)
+            return;
+
+        uint32_t key = ArtCache::keyFor(url);
+        char path[32];
+        if (cache->lookup(key, path, sizeof(path)))
+            return;
+
+        int httpCode = images->GET(url + strlen(prefix));
+        if (httpCode != 200) {
+            images->end();
+            return;
+        }
+
+        char temp[32];
+        cache->tempPath(temp, sizeof(temp));
+        fs::File f = hostFs->open(temp, "w");
+        Stream& body = images->getBodyStream();
+        uint8_t buff[1024];
+        size_t n;
+        while ((n = body.readBytes(buff, sizeof(buff))) > 0)
+            f.write(buff, n);
+        f.close();
+        int32_t size = images->getSize();
+        images->end();
+        cache->commit(key, size);
+    }
+
+  public:
+    fs::FS* hostFs;
+    std::deque<PendingTap> pendingTaps;
+    Samples commandLatency;
+    Samples trackChangeLatency;
+    Samples linkRecoveryLatency;
+    uint32_t snapshots = 0;
+    bool shownPlaying = false;
+
+    void onSnapshot(PlaybackSnapshot& snapshot) override {
+        uint64_t now = NativeClock::elapsedMs();
+        snapshots++;
+
+        while (!pendingTaps.empty() && (int32_t)(snapshot.commandSeq - pendingTaps.front().seq) >= 0) {
+            commandLatency.add(now - pendingTaps.front().at);
+            pendingTaps.pop_front();
+        }
+
+        // Desde que volvio el AP hasta el primer estado real en pantalla
+        uint64_t restoredAt = mock->linkRestoredAt();
+        if (restoredAt > measuredRestore) {
+            linkRecoveryLatency.add(now - restoredAt);
+            measuredRestore = restoredAt;
+        }
+
+        if (!snapshot.active)
+            return;
+
+        const PlaybackState& state = snapshot.state;
+        if (strcmp(shownId, state.id) != 0) {
+            if (strcmp(mock->currentId(), state.id) == 0)
+                trackChangeLatency.add(now - mock->currentTrackSince());
+            strlcpy(shownId, state.id, sizeof(shownId));
+        }
+        shownPlaying = state.isPlaying;
+
+        if (strcmp(artUrl, state.imageUrl) != 0) {
+            strlcpy(artUrl, state.imageUrl, sizeof(artUrl));
+            downloadArt(state.imageUrl);
+        }
+    }
+
+    SoakListener(MockSpotify& mock, MockTransport& images, ArtCache& cache, fs::FS& hostFs) {
+        this->mock = &mock;
+        this->images = &images;
+        this->cache = &cache;
+        this->hostFs = &hostFs;
+        shownId[0] = '\0';
+        artUrl[0] = '\0';
+        measuredRestore = 0;
+    }
+};
+
+//========= Reporte =========
+
+static void printLatency(const char* name, const Samples& samples, bool json, bool last = false) {
+    if (json)
+        printf("    \"%s\": {\"count\": %u, \"p50\": %u, \"p95\": %u, \"p99\": %u, \"max\": %u}%s\n", name, samples.count,
+               samples.percentile(0.50), samples.percentile(0.95), samples.percentile(0.99), samples.max, last ? "" : ",");
+    else
+        printf("  %-14s n=%-7u p50=%-6u p95=%-6u p99=%-6u max=%u ms\n", name, samples.count,
+               samples.percentile(0.50), samples.percentile(0.95), samples.percentile(0.99), samples.max);
+}
+
+static void printStatuses(MockTransport& transport, bool json, bool last = false) {
+    if (json) {
+        printf("    \"%s\": {\"requests\": %u", transport.hostName(), transport.requests());
+        for (auto& entry : transport.statusCounts)
+            printf(", \"%d\": %u", entry.first, entry.second);
+        printf("}%s\n", last ? "" : ",");
+    } else {
+        printf("  %-9s %6u peticiones:", transport.hostName(), transport.requests());
+        for (auto& entry : transport.statusCounts)
+            printf(" %d=%u", entry.first, entry.second);
+        printf("\n");
+    }
+}
+
+//========= Main =========
+
+int main(int argc, char** argv) {
+    bool soak = false;
+    bool json = false;
+    bool verbose = false;
+    const char* scenario = nullptr;
+    const char* durationText = nullptr;
+    const char* fsRoot = ".native_fs";
+    const char* benchCorpus = nullptr;
+    const char* benchOut = nullptr;
+    uint32_t benchIterations = 1000;
+    uint32_t clients = 0;
+    const char* bridge = "127.0.0.1";
+    uint32_t tapEverySec = 20;
+    bool browse = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--soak") == 0)
+            soak = true;
+        else if (strcmp(argv[i], "--json") == 0)
+            json = true;
+        else if (strcmp(argv[i], "--verbose") == 0)
+            verbose = true;
+        else if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc)
+            scenario = argv[++i];
+        else if (strcmp(argv[i], "--duration") == 0 && i + 1 < argc)
+            durationText = argv[++i];
+        else if (strcmp(argv[i], "--fs") == 0 && i + 1 < argc)
+            fsRoot = argv[++i];
+        else if (strcmp(argv[i], "--bench") == 0 && i + 1 < argc)
+            benchCorpus = argv[++i];
+        else if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+            benchIterations = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+            benchOut = argv[++i];
+        else if (strcmp(argv[i], "--clients") == 0 && i + 1 < argc)
+            clients = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--bridge") == 0 && i + 1 < argc)
+            bridge = argv[++i];
+        else if (strcmp(argv[i], "--tap-every") == 0 && i + 1 < argc)
+            tapEverySec = strtoul(argv[++i], nullptr, 10);
+        else if (strcmp(argv[i], "--browse") == 0)
+            browse = true;
+        else {
+            fprintf(stderr, "uso: %s [--soak] [--scenario archivo] [--duration 7d] [--json] [--verbose] [--fs dir]\n", argv[0]);
+            fprintf(stderr, "     %s --bench corpus [--iterations N] [--out archivo]\n", argv[0]);
+            fprintf(stderr, "     %s --clients N [--bridge host:puerto] [--duration 10m] [--tap-every segundos] [--json]\n", argv[0]);
+            fprintf(stderr, "     %s --browse [--scenario archivo] [--duration 1m] [--json]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (benchCorpus != nullptr)
+        return runBench(benchCorpus, benchIterations, benchOut);
+
+    NativeClock::setSimulated(soak);
+    Serial.quiet = soak && !verbose;
+
+    MockSpotify mock;
+    if (scenario != nullptr && !mock.load(scenario))
+        return 1;
+    mock.loadDefaults();
+    if (!soak)
+        mock.setDuration(DEFAULT_REALTIME_DURATION_MS);
+    if (durationText != nullptr) {
+        char* end;
+        double days = strtod(durationText, &end);
+        uint64_t ms = strcmp(end, "d") == 0 ? days * 86400000.0 : strcmp(end, "h") == 0 ? days * 3600000.0
+                    : strcmp(end, "m") == 0 ? days * 60000.0 : days * 1000.0;
+        mock.setDuration(ms);
+    }
+
+    // Los controladores hablan con un puente de verdad: siempre en tiempo real
+    if (clients > 0)
+        return runClients(bridge, clients, soak ? DEFAULT_REALTIME_DURATION_MS : mock.duration(), tapEverySec * 1000, json);
+    if (browse)
+        return runBrowse(mock, durationText != nullptr ? mock.duration() : DEFAULT_BROWSE_DURATION_MS, json);
+
+    MockTransport api(mock, "api");
+    MockTransport accounts(mock, "accounts");
+    MockTransport images(mock, "images");
+
+    Preferences preferences;
+    preferences.begin("spotify", false);
+    TokenManager tokens(accounts, preferences, "mock-refresh-token", "mock-client-id", "mock-client-secret");
+
+    fs::FS hostFs(fsRoot);
+    ArtCache artCache(hostFs, "/art", ART_CACHE_BUDGET_BYTES);
+    artCache.begin();
+
+    CommandCoalescer commands;
+    SoakListener listener(mock, images, artCache, hostFs);
+    PlayerSession session(api, tokens, commands, listener);
+    MockLink link(mock);
+    ConnectivityManager connectivity(link);
+
+    static Samples apiLatency;
+    api.latencies = &apiLatency;
+
+    const std::vector<MockTap>& taps = mock.scriptedTaps();
+    std::vector<uint64_t> nextTapAt;
+    for (const MockTap& tap : taps)
+        nextTapAt.push_back(tap.periodMs);
+    // Arrastres en curso: cuantos eventos faltan y cuando empezo
+    std::vector<uint32_t> dragLeft(taps.size(), 0);
+    std::vector<uint64_t> dragStartedAt(taps.size(), 0);
+
+    auto wallStart = std::chrono::steady_clock::now();
+    connectivity.begin(millis());
+    bool sessionStarted = false;
+
+    size_t heapHighWater = heapInUse();
+    size_t heapAfterWarmup = 0;
+    uint32_t steps = 0;
+
+    for (;;) {
+        uint64_t now = NativeClock::elapsedMs();
+        if (now >= mock.duration())
+            break;
+
+        // Toques del usuario, como los manda la UI: se encolan y despiertan a la sesion
+        for (size_t i = 0; i < taps.size(); i++) {
+            if (now < nextTapAt[i])
+                continue;
+
+            // Un evento por frame mientras dura; la latencia se mide desde que se suelta
+            bool seek = strcmp(taps[i].command, "seek") == 0;
+            if (seek || strcmp(taps[i].command, "volume") == 0) {
+                if (dragLeft[i] == 0) {
+                    dragLeft[i] = taps[i].count;
+                    dragStartedAt[i] = now;
+                }
+                dragLeft[i]--;
+                uint32_t moved = taps[i].count - dragLeft[i];
+                uint32_t seq = seek ? commands.seekTo(moved * 1000) : commands.setVolume(moved % 101);
+                if (dragLeft[i] == 0) {
+                    listener.pendingTaps.push_back({seq, now});
+                    nextTapAt[i] = dragStartedAt[i] + taps[i].periodMs;
+                } else {
+                    nextTapAt[i] = now + DRAG_EVENT_MS;
+                }
+                continue;
+            }
+
+            nextTapAt[i] += taps[i].periodMs;
+            for (uint8_t n = 0; n < taps[i].count; n++) {
+                uint32_t seq;
+                if (strcmp(taps[i].command, "next") == 0)
+                    seq = commands.next();
+                else if (strcmp(taps[i].command, "prev") == 0)
+                    seq = commands.prev();
+                else
+                    seq = commands.setPlaying(!listener.shownPlaying);
+                listener.pendingTaps.push_back({seq, now});
+            }
+        }
+
+        // Igual que la tarea de red del ESP32: sin enlace los comandos quedan guardados y no se consulta
+        uint32_t wait = connectivity.step(millis());
+        if (connectivity.online()) {
+            if (!sessionStarted) {
+                session.begin();
+                sessionStarted = true;
+            }
+            if (connectivity.reconnected())
+                session.onReconnected();
+            TransportBatch held;
+            if (connectivity.releaseCommands(held, millis()))
+                session.runCommands(held);
+            wait = session.step();
+            connectivity.onApiFailures(session.transportErrors(), millis());
+        } else {
+            TransportBatch batch;
+            if (commands.take(batch))
+                connectivity.holdCommands(batch, millis());
+        }
+        steps++;
+
+        size_t heap = heapInUse();
+        if (heap > heapHighWater)
+            heapHighWater = heap;
+        if (heapAfterWarmup == 0 && NativeClock::elapsedMs() >= WARMUP_MS)
+            heapAfterWarmup = heap;
+
+        uint64_t wake = NativeClock::elapsedMs() + (wait > 0 ? wait : 1);
+        for (uint64_t at : nextTapAt)
+            wake = min(wake, at);
+        // En el ESP32 la caida la avisa el evento del WiFi
+        wake = min(wake, mock.nextLinkChangeAt());
+        wake = min(wake, mock.duration());
+        uint64_t after = NativeClock::elapsedMs();
+        if (wake > after)
+            NativeClock::advance(wake - after);
+    }
+
+    uint64_t wallMs = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - wallStart).count();
+    uint64_t simulatedMs = NativeClock::elapsedMs();
+    PollScheduler& scheduler = session.pollScheduler();
+    size_t heapFinal = heapInUse();
+    // El reporte sale siempre, aunque el log de la corrida este silenciado
+    Serial.quiet = false;
+
+    if (json) {
+        printf("{\n  \"simulated_ms\": %llu,\n  \"wall_ms\": %llu,\n  \"steps\": %u,\n",
+               (unsigned long long)simulatedMs, (unsigned long long)wallMs, steps);
+        printf("  \"hosts\": {\n");
+        printStatuses(api, json);
+        printStatuses(accounts, json);
+        printStatuses(images, json, true);
+        printf("  },\n  \"latency_ms\": {\n");
+        printLatency("api", apiLatency, json);
+        printLatency("command_to_screen", listener.commandLatency, json);
+        printLatency("track_change_to_screen", listener.trackChangeLatency, json);
+        printLatency("link_restored_to_screen", listener.linkRecoveryLatency, json, true);
+        printf("  },\n");
+        printf("  \"link\": {\"drops\": %u, \"outages\": %u, \"attempts\": %u, \"recoveries\": %u, \"mean_recovery_ms\": %u, "
+               "\"max_recovery_ms\": %u, \"api_resets\": %u, \"held_commands\": %u, \"dropped_skips\": %u, \"dropped_plays\": %u},\n",
+               mock.linkDrops(), connectivity.outages(), connectivity.attempts(), connectivity.recoveries(), connectivity.meanRecoveryMs(),
+               connectivity.maxRecoveryMs(), connectivity.apiResets(), connectivity.heldCommands(), connectivity.droppedSkips(),
+               connectivity.droppedPlays());
+        printf("  \"heap\": {\"high_water\": %zu, \"after_warmup\": %zu, \"final\": %zu},\n", heapHighWater, heapAfterWarmup, heapFinal);
+        printf("  \"polls\": %u,\n  \"baseline_polls\": %u,\n  \"rate_limited\": %u,\n  \"denied\": %u,\n",
+               scheduler.backgroundRequests(), scheduler.baselinePolls(millis()), scheduler.rateLimitedResponses(), scheduler.deniedRequests());
+        printf("  \"not_modified\": %u,\n", session.notModifiedResponses());
+        printf("  \"taps\": %u,\n  \"command_requests\": %u,\n  \"snapshots\": %u,\n", commands.tapCount(), session.commandRequests(), listener.snapshots);
+        printf("  \"drags\": {\"seek_events\": %u, \"seek_requests\": %u, \"volume_events\": %u, \"volume_requests\": %u},\n",
+               commands.seekEventCount(), session.seekRequests(), commands.volumeEventCount(), session.volumeRequests());
+        printf("  \"token_refreshes\": %u,\n  \"token_failures\": %u,\n  \"expired_token_401\": %u,\n  \"injected_faults\": %u,\n",
+               tokens.refreshes(), tokens.failures(), mock.expiredTokenRejections(), mock.injectedFaults());
+        printf("  \"art_cache\": {\"hits\": %u, \"misses\": %u, \"evictions\": %u},\n", artCache.hits(), artCache.misses(), artCache.evictions());
+        Serial.print("  \"metrics\": ");
+        metrics.printJson(Serial);
+        printf("}\n");
+    } else {
+        printf("\nSimulado: %.2f h en %llu ms reales, %u vueltas\n", simulatedMs / 3600000.0, (unsigned long long)wallMs, steps);
+        printf("Peticiones:\n");
+        printStatuses(api, json);
+        printStatuses(accounts, json);
+        printStatuses(images, json);
+        printf("Latencias:\n");
+        printLatency("api", apiLatency, json);
+        printLatency("comando", listener.commandLatency, json);
+        printLatency("cambio tema", listener.trackChangeLatency, json);
+        printLatency("red->pantalla", listener.linkRecoveryLatency, json);
+        printf("Heap: pico %zu bytes, despues de la primera hora %zu, al final %zu\n", heapHighWater, heapAfterWarmup, heapFinal);
+        printf("Consultas: %u (timer fijo de 5 s: %u), 429: %u, denegadas: %u\n", scheduler.backgroundRequests(),
+               scheduler.baselinePolls(millis()), scheduler.rateLimitedResponses(), scheduler.deniedRequests());
+        printf("Consultas resueltas con 304: %u\n", session.notModifiedResponses());
+        printf("Comandos: %u toques, %u llamadas a la API\n", commands.tapCount(), session.commandRequests());
+        printf("Arrastres: seek %u eventos -> %u peticiones, volumen %u eventos -> %u peticiones\n",
+               commands.seekEventCount(), session.seekRequests(), commands.volumeEventCount(), session.volumeRequests());
+        printf("Token: %u renovaciones, %u fallidas, %u 401 por token vencido, %u fallas inyectadas\n",
+               tokens.refreshes(), tokens.failures(), mock.expiredTokenRejections(), mock.injectedFaults());
+        printf("Red: %u caidas del AP, %u detectadas, %u intentos, recuperacion promedio %u ms (max %u), %u reconexiones por la API\n",
+               mock.linkDrops(), connectivity.outages(), connectivity.attempts(), connectivity.meanRecoveryMs(),
+               connectivity.maxRecoveryMs(), connectivity.apiResets());
+        printf("Comandos sin conexion: %u guardados, %u saltos y %u play/pausa descartados\n", connectivity.heldCommands(),
+               connectivity.droppedSkips(), connectivity.droppedPlays());
+        printf("Cache de tapas: %u aciertos, %u fallos, %u desalojos\n", artCache.hits(), artCache.misses(), artCache.evictions());
+        metrics.printCompact(Serial);
+    }
+    return 0;
+}